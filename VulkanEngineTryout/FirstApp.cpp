@@ -3,6 +3,8 @@
 #include "LveCamera.h"
 #include "Keyboard_Movement_Input.h"
 #include "Lve_Buffer.h"
+#include "LveShaderReloader.h"
+#include "LveFixedTimestep.h"
 
 // GLM
 #define GLM_FORCE_RADIANS
@@ -14,32 +16,58 @@
 #include <iostream>
 #include <array>
 #include <chrono>
+#include <cstdint>
 #include <cassert>
+#include <filesystem>
+#include <limits>
 #include <stdexcept>
 
 namespace lve {
 
 	struct GlobalUBO {
 		alignas(16) glm::mat4 projectionView{ 1.0f };
-		alignas(16) glm::vec3 lightDirection = glm::normalize(glm::vec3{1.0f, -3.0f, -1.0f});
+		// Only the first SimpleRenderSystem::ShaderFeatures::lightCount are used
+		glm::vec4 lightDirections[SimpleRenderSystem::MAX_LIGHTS]{ glm::vec4{ glm::normalize(glm::vec3{1.0f, -3.0f, -1.0f}), 0.0f } };
 	};;
 
-	FirstApp::FirstApp()
+	FirstApp::FirstApp(bool headless, LveBenchmark* benchmark) : benchmark{ benchmark }, lveWindow{ WIDTH, HEIGHT, "Hello Vulkan!", headless }
 	{
+		// Before anything loads a shader, unchanged ones come from the cache
+		shaderCompiler.compileDirectory("./Shaders");
+		auto shaderStats = shaderCompiler.getStats();
+		std::cout << "Shaders: " << shaderStats.compiled << " compiled, " << shaderStats.cached << " from cache" << std::endl;
+
 		globalPool = LveDescriptorPool::Builder(lveDevice)
 			.setMaxSets(Lve_Swap_Chain::MAX_FRAMES_IN_FLIGHT)
 			.addPoolSize(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, Lve_Swap_Chain::MAX_FRAMES_IN_FLIGHT)
 			.build();
 
-		loadGameObjects();
+		if (benchmark)
+		{
+			lveGameObjects = benchmark->createGameObjects(lveDevice);
+		}
+		else
+		{
+			loadGameObjects();
+		}
 	}
 
 	FirstApp::~FirstApp()
 	{
 	}
 
-	void FirstApp::run()
+	void FirstApp::run(uint64_t frameCount)
 	{
+		if (benchmark && frameCount == 0)
+		{
+			frameCount = uint64_t{ benchmark->getWarmupFrameCount() } + benchmark->getFrameCount();
+		}
+		if (lveWindow.isHeadless() && frameCount == 0)
+		{
+			throw std::runtime_error("A headless run needs a frame count");
+		}
+		bool interactive = !lveWindow.isHeadless();
+
 		std::vector<std::unique_ptr<Lve_Buffer>> uboBuffers(Lve_Swap_Chain::MAX_FRAMES_IN_FLIGHT);
 
 		for (int i = 0; i < uboBuffers.size(); i++)
@@ -54,41 +82,145 @@ namespace lve {
 			uboBuffers[i]->map();
 		}
 
-		auto globalSetLayout = LveDescriptorSetLayout::Builder(lveDevice)
-			.addBinding(0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_VERTEX_BIT)
-			.build();
+		// Set 0 as simple_shader.vert declares it
+		auto& globalSetLayout = lveDevice.getLayoutCache().getDescriptorSetLayout(
+			lveDevice.getShaderCache().acquire("./Shaders/simple_shader.vert.spv")->getReflection().getSetBindings(0));
 
 		std::vector<VkDescriptorSet> globalDescriptorSets(Lve_Swap_Chain::MAX_FRAMES_IN_FLIGHT);
 		for (int i = 0; i < globalDescriptorSets.size(); i++)
 		{
 			auto bufferInfo = uboBuffers[i]->descriptorInfo();
-			LveDescriptorWriter(*globalSetLayout, *globalPool)
+			LveDescriptorWriter(globalSetLayout, *globalPool)
 				.writeBuffer(0, &bufferInfo)
 				.build(globalDescriptorSets[i]);
 		}
 
 		std::cout << "Max Push Constant Size: " << lveDevice.properties.limits.maxPushConstantsSize << std::endl;
 
-		SimpleRenderSystem simpleRenderSystem{ lveDevice, lveRenderer.getSwapChainRenderPass(), globalSetLayout->getDescriptorSetLayout() };
+		auto pipelineStart = std::chrono::steady_clock::now();
+		SimpleRenderSystem simpleRenderSystem{ lveDevice, lveRenderer.getSwapChainRenderPass(), globalSetLayout, bindlessRegistry, pipelineCompiler };
+		std::cout << "Pipeline creation: " << std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - pipelineStart).count()
+			<< " ms (" << (lveDevice.isPipelineCacheWarm() ? "warm" : "cold") << " cache, the rest compiles in the background)" << std::endl;
+		auto layoutStats = lveDevice.getLayoutCache().getStats();
+		std::cout << "Layouts: " << layoutStats.descriptorSetLayouts << " descriptor set layouts for " << layoutStats.descriptorSetLayoutRequests << " requests, "
+			<< layoutStats.pipelineLayouts << " pipeline layouts for " << layoutStats.pipelineLayoutRequests << " requests" << std::endl;
 		LveCamera camera{};
 
+		// The scene is static, so the GPU driven path only needs it uploaded once and the CPU path only needs its bounds once
+		bool gpuDriven = PREFER_GPU_CULLING && simpleRenderSystem.isGpuCullingSupported();
+		if (gpuDriven)
+		{
+			simpleRenderSystem.setScene(lveGameObjects);
+			simpleRenderSystem.setOcclusionCulling(ENABLE_OCCLUSION_CULLING);
+			std::cout << "Culling: GPU compute" << (ENABLE_OCCLUSION_CULLING ? " with occlusion" : "") << std::endl;
+		}
+		else
+		{
+			simpleRenderSystem.updateBounds(lveGameObjects);
+			std::cout << "Culling: CPU " << LveFrustumCuller::kernelName() << std::endl;
+		}
+
+		simpleRenderSystem.setProfiler(&gpuProfiler);
+		uint32_t frameSection = gpuProfiler.addSection("Frame");
+		simpleRenderSystem.setDepthPrepass(ENABLE_DEPTH_PREPASS);
+		std::cout << "Depth pre-pass: " << (ENABLE_DEPTH_PREPASS ? "on" : "off") << std::endl;
+
+		bool parallelRecording = PARALLEL_RECORDING && !gpuDriven;
+		if (parallelRecording)
+		{
+			lveRenderer.createSecondaryCommandPools(threadPool.size());
+			std::cout << "Recording: " << threadPool.size() << " threads" << std::endl;
+
+			if (CACHE_STATIC_COMMANDS && simpleRenderSystem.isStaticSceneSupported())
+			{
+				simpleRenderSystem.setStaticScene(lveGameObjects);
+			}
+		}
+
+		uint32_t reportedStateChanges = UINT32_MAX;
+		uint32_t reportedPassCount = UINT32_MAX;
+		uint32_t reportedBarrierCount = UINT32_MAX;
+		auto lastTimingReport = std::chrono::steady_clock::now();
+
+		std::unique_ptr<LveShaderReloader> shaderReloader;
+		if (HOT_RELOAD_SHADERS && interactive)
+		{
+			shaderReloader = std::make_unique<LveShaderReloader>("./Shaders", shaderCompiler);
+		}
+
+		// Number keys pick low latency, default and throughput presentation
+		const std::array<SwapChainSettings, 3> swapChainPresets{ SwapChainSettings::lowLatency(), SwapChainSettings{}, SwapChainSettings::throughput() };
+		int heldPresetKey = -1;
+
 		auto viewerObject = LveGameObject::createGameObject();
 		//Keyboard_Movement_Input cameraController{};
 		Keyboard_Movement_Input_Alt cameraController{};
+		LveFixedTimestep simulationTimestep{ SIMULATION_STEP };
+		TransformComponent previousViewerTransform = viewerObject.transform;
+		double simulationTime = 0.0;
+
+		LveFrameStats& frameStats = lveRenderer.getFrameStats();
 
-		while (!lveWindow.shouldClose())
+		for (uint64_t frame = 0; !lveWindow.shouldClose() && (frameCount == 0 || frame < frameCount); frame++)
 		{
-			glfwPollEvents();
+			if (interactive)
+			{
+				glfwPollEvents();
+			}
+			// Input has just been read, latency is measured from here
+			float frameTime = frameStats.beginFrame();
+			auto frameStart = std::chrono::steady_clock::now();
+			// Benchmarks advance by the same step whatever the frame took, so every run renders the same frames
+			if (benchmark)
+			{
+				frameTime = benchmark->getStep();
+			}
 
-			// FPS related
-			auto currentTime = std::chrono::high_resolution_clock::now();
-			auto newTime = std::chrono::high_resolution_clock::now();
-			auto frameTime = std::chrono::duration<float, std::chrono::seconds::period>(newTime - currentTime).count();
-			currentTime = newTime;
+			// Between frames, the render system keeps drawing with the old pipelines until the new ones are compiled
+			if (shaderReloader)
+			{
+				bool graphicsShaderChanged = false;
+				for (auto& source : shaderReloader->poll())
+				{
+					bool compute = std::filesystem::path(source).extension() == ".comp";
+					std::cout << "Shader reload: " << source << (compute ? " rebuilt, compute shaders are picked up on restart" : " rebuilt") << std::endl;
+					graphicsShaderChanged |= !compute;
+				}
+				if (graphicsShaderChanged)
+				{
+					simpleRenderSystem.reloadShaders(lveRenderer.getSwapChainRenderPass());
+				}
+			}
 
-			// Camera movement
-			cameraController.moveInPlaneXZ(lveWindow.getGLFWwindow(), viewerObject, frameTime);
-			camera.setViewYXZ(viewerObject.transform.translation, viewerObject.transform.rotation);
+			int presetKey = -1;
+			for (int i = 0; interactive && i < static_cast<int>(swapChainPresets.size()); i++)
+			{
+				if (glfwGetKey(lveWindow.getGLFWwindow(), GLFW_KEY_1 + i) == GLFW_PRESS) presetKey = i;
+			}
+			if (presetKey != -1 && presetKey != heldPresetKey)
+			{
+				lveRenderer.setSwapChainSettings(swapChainPresets[presetKey]);
+				std::cout << "Frames in flight: " << lveRenderer.getFramesInFlight() << std::endl;
+			}
+			heldPresetKey = presetKey;
+
+			// Simulation in fixed steps, rendering shows a blend of the last two states
+			uint32_t steps = simulationTimestep.advance(frameTime);
+			for (uint32_t step = 0; step < steps; step++)
+			{
+				previousViewerTransform = viewerObject.transform;
+				simulationTime += simulationTimestep.getStep();
+				if (benchmark)
+				{
+					viewerObject.transform = benchmark->getCameraTransform(static_cast<float>(simulationTime));
+				}
+				else if (interactive)
+				{
+					cameraController.moveInPlaneXZ(lveWindow.getGLFWwindow(), viewerObject, simulationTimestep.getStep());
+				}
+			}
+			auto viewerTransform = TransformComponent::interpolate(previousViewerTransform, viewerObject.transform, simulationTimestep.getAlpha());
+			camera.setViewYXZ(viewerTransform.translation, viewerTransform.rotation);
 
 			// Camera projection
 			float aspect = lveRenderer.getAspectRatio();
@@ -106,20 +238,181 @@ namespace lve {
 					globalDescriptorSets[frameIndex]
 				};
 
+				gpuProfiler.beginFrame(commandBuffer, frameIndex);
+				gpuProfiler.writeBegin(commandBuffer, frameIndex, frameSection);
+
 				// Update
 				GlobalUBO ubo{};
 				ubo.projectionView = camera.getProjection() * camera.getView();
 				uboBuffers[frameIndex]->writeToBuffer(&ubo, sizeof(ubo));
 				uboBuffers[frameIndex]->flush();
 
-				// Render
-				lveRenderer.beginSwapChainRenderPass(commandBuffer);
-				simpleRenderSystem.renderGameobjects(frameInfo, lveGameObjects);
-				lveRenderer.endSwapChainRenderPass(commandBuffer);
+				bool occlusionCulling = gpuDriven && simpleRenderSystem.isOcclusionCullingEnabled();
+
+				// Frame graph, the swap chain image and depth start undefined every frame
+				renderGraph.reset();
+				auto color = renderGraph.importImage("Swap chain color", lveRenderer.getCurrentImage(), lveRenderer.getCurrentImageView(), VK_IMAGE_ASPECT_COLOR_BIT,
+					{ VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT_KHR, 0, VK_IMAGE_LAYOUT_UNDEFINED });
+				auto depth = renderGraph.importImage("Swap chain depth", lveRenderer.getCurrentDepthImage(), lveRenderer.getCurrentDepthImageView(), lveRenderer.getSwapChainDepthAspect(),
+					{ VK_PIPELINE_STAGE_2_EARLY_FRAGMENT_TESTS_BIT_KHR | VK_PIPELINE_STAGE_2_LATE_FRAGMENT_TESTS_BIT_KHR, VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT_KHR, VK_IMAGE_LAYOUT_UNDEFINED });
+				// Acquire waits on color attachment output, presentation needs no stage
+				renderGraph.exportResource(color, { VK_PIPELINE_STAGE_2_NONE_KHR, 0, lveRenderer.getSwapChainPresentLayout() });
+
+				auto writeAttachments = [&](LveRenderGraph::PassBuilder& pass)
+				{
+					pass.writeImage(color, VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT_KHR,
+						VK_ACCESS_2_COLOR_ATTACHMENT_READ_BIT_KHR | VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT_KHR, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL);
+					pass.writeImage(depth, VK_PIPELINE_STAGE_2_EARLY_FRAGMENT_TESTS_BIT_KHR | VK_PIPELINE_STAGE_2_LATE_FRAGMENT_TESTS_BIT_KHR,
+						VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_READ_BIT_KHR | VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT_KHR, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL);
+				};
+
+				// The cull keeps its buffers private and synchronizes them internally, tokens order it
+				LveRenderGraph::ResourceId earlyCull = 0;
+				if (gpuDriven)
+				{
+					earlyCull = renderGraph.createToken("Early cull");
+					renderGraph.addPass("Early cull",
+						[&](LveRenderGraph::PassBuilder& pass) { pass.writeToken(earlyCull); },
+						[&](VkCommandBuffer) { simpleRenderSystem.cullGameobjects(frameInfo); });
+				}
+
+				renderGraph.addPass("Main",
+					[&](LveRenderGraph::PassBuilder& pass)
+					{
+						if (gpuDriven) pass.readToken(earlyCull);
+						writeAttachments(pass);
+					},
+					[&](VkCommandBuffer commandBuffer)
+					{
+						lveRenderer.beginSwapChainRenderPass(commandBuffer, false, parallelRecording ? VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS : VK_SUBPASS_CONTENTS_INLINE);
+						if (gpuDriven)
+						{
+							simpleRenderSystem.renderCulledGameobjects(frameInfo);
+						}
+						else if (parallelRecording)
+						{
+							simpleRenderSystem.renderGameobjectsParallel(frameInfo, lveGameObjects, lveRenderer, threadPool);
+						}
+						else
+						{
+							simpleRenderSystem.renderGameobjects(frameInfo, lveGameObjects);
+						}
+						lveRenderer.endSwapChainRenderPass(commandBuffer);
+					});
+
+				// Occlusion: test everything against the depth drawn so far, then draw what turned out visible
+				LveRenderGraph::ResourceId pyramid = 0;
+				if (occlusionCulling)
+				{
+					// Only read by this frame's late cull, so it lives in transient graph memory
+					pyramid = renderGraph.createImage("Depth pyramid", LveDepthPyramid::getImageDesc(lveRenderer.getSwapChainExtent()));
+					renderGraph.addPass("Depth pyramid",
+						[&](LveRenderGraph::PassBuilder& pass)
+						{
+							pass.readImage(depth, VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT_KHR, VK_ACCESS_2_SHADER_READ_BIT_KHR, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+							pass.writeImage(pyramid, VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT_KHR, VK_ACCESS_2_SHADER_READ_BIT_KHR | VK_ACCESS_2_SHADER_WRITE_BIT_KHR, VK_IMAGE_LAYOUT_GENERAL);
+						},
+						[&](VkCommandBuffer) { simpleRenderSystem.buildDepthPyramid(frameInfo, lveRenderer.getCurrentDepthImageView()); });
+
+					auto lateCull = renderGraph.createToken("Late cull");
+					renderGraph.addPass("Late cull",
+						[&](LveRenderGraph::PassBuilder& pass)
+						{
+							pass.readImage(pyramid, VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT_KHR, VK_ACCESS_2_SHADER_READ_BIT_KHR, VK_IMAGE_LAYOUT_GENERAL);
+							pass.writeToken(lateCull);
+						},
+						[&](VkCommandBuffer) { simpleRenderSystem.cullGameobjects(frameInfo, CullPhase::Late); });
+
+					renderGraph.addPass("Late main",
+						[&](LveRenderGraph::PassBuilder& pass)
+						{
+							pass.readToken(lateCull);
+							writeAttachments(pass);
+						},
+						[&](VkCommandBuffer commandBuffer)
+						{
+							lveRenderer.beginSwapChainRenderPass(commandBuffer, true);
+							simpleRenderSystem.renderCulledGameobjects(frameInfo, CullPhase::Late);
+							lveRenderer.endSwapChainRenderPass(commandBuffer);
+						});
+				}
+
+				renderGraph.compile();
+				if (gpuDriven)
+				{
+					// The pyramid image is known after compile, the early cull binds descriptors pointing at it
+					simpleRenderSystem.setDepthPyramid(frameInfo, lveRenderer.getSwapChainExtent(),
+						occlusionCulling ? renderGraph.getImage(pyramid) : VK_NULL_HANDLE,
+						occlusionCulling ? renderGraph.getImageView(pyramid) : VK_NULL_HANDLE);
+				}
+				renderGraph.execute(commandBuffer);
+				gpuProfiler.writeEnd(commandBuffer, frameIndex, frameSection);
+
 				lveRenderer.endFrame();
+
+				if (benchmark && frame >= benchmark->getWarmupFrameCount())
+				{
+					LveBenchmark::FrameSample sample{};
+					sample.cpuMilliseconds = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - frameStart).count();
+					sample.gpuMilliseconds = gpuProfiler.isSupported() ? gpuProfiler.getMilliseconds(frameSection) : std::numeric_limits<float>::quiet_NaN();
+					sample.timelineWaitMilliseconds = frameStats.getLatest(LveFrameStats::Metric::TimelineWait);
+					sample.submitMilliseconds = frameStats.getLatest(LveFrameStats::Metric::Submit);
+					sample.deviceMemoryBytes = lveDevice.getMemoryUsage().usage;
+					benchmark->record(sample);
+				}
+
+				const auto& drawStats = simpleRenderSystem.getDrawStats();
+				if (drawStats.stateChanges() != reportedStateChanges)
+				{
+					reportedStateChanges = drawStats.stateChanges();
+					std::cout << "State changes per frame: " << reportedStateChanges
+						<< " (" << drawStats.pipelineBinds << " pipeline, " << drawStats.descriptorBinds << " descriptor, " << drawStats.modelBinds << " model binds for "
+						<< drawStats.batchCount << " batches)" << std::endl;
+				}
+
+				const auto& graphStats = renderGraph.getStats();
+				if (graphStats.barrierCount != reportedBarrierCount || graphStats.passCount != reportedPassCount)
+				{
+					reportedBarrierCount = graphStats.barrierCount;
+					reportedPassCount = graphStats.passCount;
+					std::cout << "Render graph: " << graphStats.passCount << " passes (" << graphStats.culledPassCount << " culled), "
+						<< graphStats.barrierCount << " barriers, " << graphStats.transientMemory << " bytes transient memory ("
+						<< graphStats.transientMemoryWithoutAliasing << " without aliasing)" << std::endl;
+				}
+
+				auto now = std::chrono::steady_clock::now();
+				if (now - lastTimingReport >= std::chrono::seconds(1))
+				{
+					lastTimingReport = now;
+					auto cpuFrame = frameStats.getSummary(LveFrameStats::Metric::CpuFrame);
+					auto latency = frameStats.getSummary(LveFrameStats::Metric::InputToPresent);
+					std::cout << "Frame time p50/p95/p99: " << cpuFrame.p50 << " / " << cpuFrame.p95 << " / " << cpuFrame.p99 << " ms";
+					if (latency.count > 0)
+					{
+						std::cout << " | input to present p50/p95/p99: " << latency.p50 << " / " << latency.p95 << " / " << latency.p99 << " ms";
+					}
+					std::cout << std::endl;
+				}
+				if (gpuProfiler.isSupported() && now == lastTimingReport)
+				{
+					std::cout << "GPU time";
+					for (uint32_t section = 0; section < gpuProfiler.getSectionCount(); section++)
+					{
+						// Sections that are not in use this run were never measured
+						if (gpuProfiler.getMilliseconds(section) == 0.0f) continue;
+						std::cout << " | " << gpuProfiler.getSectionName(section) << ": " << gpuProfiler.getMilliseconds(section) << " ms";
+					}
+					std::cout << std::endl;
+				}
 			}
 		}
 		vkDeviceWaitIdle(lveDevice.device());
+
+		if (FRAME_STATS_CSV[0] != '\0')
+		{
+			frameStats.writeCsv(FRAME_STATS_CSV);
+			std::cout << "Frame stats written to " << FRAME_STATS_CSV << std::endl;
+		}
 	}
 
 	void FirstApp::loadGameObjects() {
@@ -130,6 +423,7 @@ namespace lve {
 		smoothVase.model = lveModel;
 		smoothVase.transform.translation = { -0.25f, 0.f, 2.5f };
 		smoothVase.transform.scale = { 1.0f, 1.0f, 1.0f };
+		smoothVase.isStatic = true;
 		lveGameObjects.push_back(std::move(smoothVase));
 
 		lveModel = LveModel::createModelFromFile(lveDevice, "VulkanModels/flat_vase.obj");
@@ -137,6 +431,7 @@ namespace lve {
 		flatVase.model = lveModel;
 		flatVase.transform.translation = { 0.25f, 0.f, 2.5f };
 		flatVase.transform.scale = { 1.0f, 1.0f, 1.0f };
+		flatVase.isStatic = true;
 		lveGameObjects.push_back(std::move(flatVase));
 		
 		// Katana Model [Sketchfab]: https://skfb.ly/oBNUD
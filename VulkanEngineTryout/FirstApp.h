@@ -5,6 +5,13 @@
 #include "LveGameObject.h"
 #include "LveRenderer.h"
 #include "LveDescriptor.h"
+#include "LveThreadPool.h"
+#include "LveGpuProfiler.h"
+#include "LveBindlessRegistry.h"
+#include "LveRenderGraph.h"
+#include "LvePipelineCompiler.h"
+#include "LveShaderCompiler.h"
+#include "LveBenchmark.h"
 
 // Std
 #include <memory>
@@ -16,21 +23,50 @@ namespace lve {
 	public:
 		static constexpr int WIDTH = 1600;
 		static constexpr int HEIGHT = 1200;
+		// Falls back to the SIMD CPU cull when false or when the device can't cull on the GPU
+		static constexpr bool PREFER_GPU_CULLING = true;
+		// Two phase occlusion culling against a depth pyramid, only used on the GPU culling path
+		static constexpr bool ENABLE_OCCLUSION_CULLING = true;
+		// CPU culling path only: record the draws into secondary command buffers on the thread pool
+		static constexpr bool PARALLEL_RECORDING = true;
+		// Parallel recording only: draw static objects from command buffers that are recorded once
+		static constexpr bool CACHE_STATIC_COMMANDS = true;
+		// Depth only pass over the opaque geometry before shading, pick per scene from the reported pass timings
+		static constexpr bool ENABLE_DEPTH_PREPASS = false;
+		// Recompile the GLSL in ./Shaders when it is saved and swap in the rebuilt pipelines while running
+		static constexpr bool HOT_RELOAD_SHADERS = true;
+		// 1 frame in flight and mailbox presentation instead of 2 frames and V-Sync, switch at runtime with 1, 2 and 3
+		static constexpr bool LOW_LATENCY = false;
+		// Per frame timings of the last LveFrameStats::HISTORY_SIZE frames, written on exit, empty to skip
+		static constexpr const char* FRAME_STATS_CSV = "frame_stats.csv";
+		// Seconds per simulation step, independent of the render rate
+		static constexpr float SIMULATION_STEP = 1.0f / 120.0f;
 
-		FirstApp();
+		// Headless renders offscreen without a window or input, see LveWindow. A benchmark replaces the
+		// scene and the camera and records every measured frame into it.
+		explicit FirstApp(bool headless = false, LveBenchmark* benchmark = nullptr);
 		~FirstApp();
 
 		FirstApp(const FirstApp&) = delete;
 		FirstApp &operator=(const FirstApp&) = delete;
 
-		void run();
+		// frameCount 0 runs until the window is closed, a headless app needs a frame count unless it runs a benchmark
+		void run(uint64_t frameCount = 0);
+		const char* getDeviceName() const { return lveDevice.properties.deviceName; }
 
 	private:
 		void loadGameObjects();
 
-		LveWindow lveWindow{ WIDTH, HEIGHT, "Hello Vulkan!" };
+		LveBenchmark* benchmark;
+		LveWindow lveWindow;
 		LveDevice lveDevice{ lveWindow };
-		LveRenderer lveRenderer{ lveWindow, lveDevice };
+		LveRenderer lveRenderer{ lveWindow, lveDevice, LOW_LATENCY ? SwapChainSettings::lowLatency() : SwapChainSettings{} };
+		LveThreadPool threadPool{};
+		LvePipelineCompiler pipelineCompiler{ lveDevice };
+		LveGpuProfiler gpuProfiler{ lveDevice };
+		LveBindlessRegistry bindlessRegistry{ lveDevice };
+		LveRenderGraph renderGraph{ lveDevice };
+		LveShaderCompiler shaderCompiler{};
 
 		std::unique_ptr<LveDescriptorPool> globalPool{};
 		std::vector<LveGameObject> lveGameObjects;
@@ -0,0 +1,295 @@
+#include "GpuCullingSystem.h"
+#include "Lve_Swap_Chain.h"
+
+// GLM
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include <glm/glm.hpp>
+
+// std
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <stdexcept>
+
+namespace lve {
+
+	// Matches CullData in cull.comp (std140)
+	struct CullUniformData {
+		glm::vec4 frustumPlanes[6];
+		glm::mat4 view{ 1.0f };
+		glm::vec4 projection{ 0.0f };
+		glm::vec4 depthParams{ 0.0f };
+		uint32_t maxObjects = 0;
+		uint32_t occlusionEnabled = 0;
+	};
+
+	struct CullPushConstantData {
+		uint32_t objectCount;
+		uint32_t phase;
+	};
+
+	constexpr uint32_t CULL_WORKGROUP_SIZE = 64;
+
+	GpuCullingSystem::GpuCullingSystem(LveDevice& device, const LveDescriptorSetLayout& objectSetLayout, uint32_t maxObjects) : lveDevice{ device }, maxObjects{ maxObjects }
+	{
+		assert(isSupported(device) && "GPU culling requires drawIndirectFirstInstance");
+
+		depthPyramid = std::make_unique<LveDepthPyramid>(lveDevice);
+
+		LveShaderReflection reflection = lveDevice.getShaderCache().acquire("./Shaders/cull.comp.spv")->getReflection();
+		createBuffers(reflection);
+		createPipelineLayout(objectSetLayout, reflection);
+		createPipeline();
+	}
+
+	void GpuCullingSystem::createBuffers(const LveShaderReflection& reflection)
+	{
+		cullSetLayout = &lveDevice.getLayoutCache().getDescriptorSetLayout(reflection.getSetBindings(1));
+
+		cullPool = LveDescriptorPool::Builder(lveDevice)
+			.setMaxSets(Lve_Swap_Chain::MAX_FRAMES_IN_FLIGHT)
+			.addPoolSize(VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 3 * Lve_Swap_Chain::MAX_FRAMES_IN_FLIGHT)
+			.addPoolSize(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, Lve_Swap_Chain::MAX_FRAMES_IN_FLIGHT)
+			.addPoolSize(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, Lve_Swap_Chain::MAX_FRAMES_IN_FLIGHT)
+			.build();
+
+		visibilityBuffer = std::make_unique<Lve_Buffer>(
+			lveDevice,
+			sizeof(uint32_t),
+			maxObjects,
+			VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT
+		);
+
+		drawCommandBuffers.resize(Lve_Swap_Chain::MAX_FRAMES_IN_FLIGHT);
+		drawCountBuffers.resize(Lve_Swap_Chain::MAX_FRAMES_IN_FLIGHT);
+		cullDataBuffers.resize(Lve_Swap_Chain::MAX_FRAMES_IN_FLIGHT);
+		cullDescriptorSets.resize(Lve_Swap_Chain::MAX_FRAMES_IN_FLIGHT);
+		pyramidDescriptorViews.resize(Lve_Swap_Chain::MAX_FRAMES_IN_FLIGHT, VK_NULL_HANDLE);
+
+		for (int i = 0; i < Lve_Swap_Chain::MAX_FRAMES_IN_FLIGHT; i++)
+		{
+			// Early and late phase each get maxObjects command slots
+			drawCommandBuffers[i] = std::make_unique<Lve_Buffer>(
+				lveDevice,
+				sizeof(VkDrawIndexedIndirectCommand),
+				2 * maxObjects,
+				VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+				VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT
+			);
+
+			// One counter per batch and phase, there are never more batches than objects
+			drawCountBuffers[i] = std::make_unique<Lve_Buffer>(
+				lveDevice,
+				sizeof(uint32_t),
+				2 * maxObjects,
+				VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+				VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT
+			);
+
+			cullDataBuffers[i] = std::make_unique<Lve_Buffer>(
+				lveDevice,
+				sizeof(CullUniformData),
+				1,
+				VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
+				VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT
+			);
+			cullDataBuffers[i]->map();
+
+			auto commandInfo = drawCommandBuffers[i]->descriptorInfo();
+			auto countInfo = drawCountBuffers[i]->descriptorInfo();
+			auto cullDataInfo = cullDataBuffers[i]->descriptorInfo();
+			auto pyramidInfo = depthPyramid->descriptorInfo();
+			auto visibilityInfo = visibilityBuffer->descriptorInfo();
+			LveDescriptorWriter(*cullSetLayout, *cullPool)
+				.writeBuffer(0, &commandInfo)
+				.writeBuffer(1, &countInfo)
+				.writeBuffer(2, &cullDataInfo)
+				.writeImage(3, &pyramidInfo)
+				.writeBuffer(4, &visibilityInfo)
+				.build(cullDescriptorSets[i]);
+			pyramidDescriptorViews[i] = pyramidInfo.imageView;
+		}
+	}
+
+	void GpuCullingSystem::writePyramidDescriptor(int frameIndex)
+	{
+		auto pyramidInfo = depthPyramid->descriptorInfo();
+		LveDescriptorWriter(*cullSetLayout, *cullPool)
+			.writeImage(3, &pyramidInfo)
+			.overwrite(cullDescriptorSets[frameIndex]);
+		pyramidDescriptorViews[frameIndex] = pyramidInfo.imageView;
+	}
+
+	void GpuCullingSystem::createPipelineLayout(const LveDescriptorSetLayout& objectSetLayout, const LveShaderReflection& reflection)
+	{
+		// The object set comes from SimpleRenderSystem, it has to back what cull.comp reads from it
+		std::string error = reflection.checkSetBindings(0, objectSetLayout.getBindings());
+		if (!error.empty())
+		{
+			throw std::runtime_error("object set layout does not match cull.comp: " + error);
+		}
+
+		auto pushConstantRanges = reflection.getPushConstantRanges();
+		assert(pushConstantRanges.size() == 1 && pushConstantRanges[0].size == sizeof(CullPushConstantData) && "CullPushConstantData does not match cull.comp");
+
+		pipelineLayout = lveDevice.getLayoutCache().getPipelineLayout({ objectSetLayout.getDescriptorSetLayout(), cullSetLayout->getDescriptorSetLayout() }, pushConstantRanges);
+	}
+
+	void GpuCullingSystem::createPipeline()
+	{
+		assert(pipelineLayout != nullptr && "Cannot create pipeline before pipeline layout");
+
+		pipeline = std::make_unique<ComputePipeline>(lveDevice, "./Shaders/cull.comp.spv", pipelineLayout);
+	}
+
+	void GpuCullingSystem::setOcclusionCulling(bool enabled)
+	{
+		if (enabled != occlusionCulling)
+		{
+			occlusionCulling = enabled;
+			resetVisibility();
+		}
+	}
+
+	void GpuCullingSystem::writeCullData(FrameInfo& frameInfo)
+	{
+		const glm::mat4& projection = frameInfo.camera.getProjection();
+		VkExtent2D depthExtent = depthPyramid->getDepthExtent();
+
+		CullUniformData cullData{};
+		auto planes = frameInfo.camera.getFrustumPlanes();
+		std::copy(planes.begin(), planes.end(), cullData.frustumPlanes);
+		cullData.view = frameInfo.camera.getView();
+		cullData.projection = glm::vec4{ projection[0][0], projection[1][1], projection[2][2], projection[3][2] };
+		cullData.depthParams = glm::vec4{ depthExtent.width, depthExtent.height, -projection[3][2] / projection[2][2], 0.0f };
+		cullData.maxObjects = maxObjects;
+
+		// The sphere projection in the shader assumes a perspective camera
+		bool perspective = projection[2][3] == 1.0f;
+		cullData.occlusionEnabled = occlusionCulling && perspective ? 1 : 0;
+
+		cullDataBuffers[frameInfo.frameIndex]->writeToBuffer(&cullData, sizeof(cullData));
+		cullDataBuffers[frameInfo.frameIndex]->flush();
+	}
+
+	void GpuCullingSystem::cull(FrameInfo& frameInfo, VkDescriptorSet objectSet, uint32_t objectCount, CullPhase phase)
+	{
+		assert(objectCount <= maxObjects && "Too many objects for the cull buffers");
+		assert((phase == CullPhase::Early || occlusionCulling) && "The late cull phase requires occlusion culling");
+
+		VkCommandBuffer commandBuffer = frameInfo.commandBuffer;
+
+		if (phase == CullPhase::Early)
+		{
+			writeCullData(frameInfo);
+
+			VkBuffer drawCommands = drawCommandBuffers[frameInfo.frameIndex]->getBuffer();
+			VkBuffer drawCounts = drawCountBuffers[frameInfo.frameIndex]->getBuffer();
+
+			// The previous frame using these buffers must be done reading its indirect arguments,
+			// and the previous late phase done with the visibility buffer
+			VkMemoryBarrier previousBarrier{};
+			previousBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+			previousBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+			previousBarrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+			vkCmdPipelineBarrier(
+				commandBuffer,
+				VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+				VK_PIPELINE_STAGE_TRANSFER_BIT,
+				0, 1, &previousBarrier, 0, nullptr, 0, nullptr);
+
+			vkCmdFillBuffer(commandBuffer, drawCounts, 0, VK_WHOLE_SIZE, 0);
+			if (!lveDevice.features12.drawIndirectCount)
+			{
+				// Without a GPU side count every slot gets drawn, so culled slots need zero instances
+				vkCmdFillBuffer(commandBuffer, drawCommands, 0, VK_WHOLE_SIZE, 0);
+			}
+			if (visibilityResetPending)
+			{
+				vkCmdFillBuffer(commandBuffer, visibilityBuffer->getBuffer(), 0, VK_WHOLE_SIZE, 0);
+				visibilityResetPending = false;
+			}
+
+			VkMemoryBarrier clearBarrier{};
+			clearBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+			clearBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+			clearBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+			vkCmdPipelineBarrier(
+				commandBuffer,
+				VK_PIPELINE_STAGE_TRANSFER_BIT,
+				VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+				0, 1, &clearBarrier, 0, nullptr, 0, nullptr);
+		}
+
+		pipeline->bind(commandBuffer);
+
+		std::array<VkDescriptorSet, 2> descriptorSets{ objectSet, cullDescriptorSets[frameInfo.frameIndex] };
+		vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipelineLayout, 0, static_cast<uint32_t>(descriptorSets.size()), descriptorSets.data(), 0, nullptr);
+
+		CullPushConstantData push{};
+		push.objectCount = objectCount;
+		push.phase = static_cast<uint32_t>(phase);
+		vkCmdPushConstants(commandBuffer, pipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(CullPushConstantData), &push);
+
+		vkCmdDispatch(commandBuffer, (objectCount + CULL_WORKGROUP_SIZE - 1) / CULL_WORKGROUP_SIZE, 1, 1);
+
+		// Late phase visibility writes are read by the next frame's early phase
+		VkMemoryBarrier cullBarrier{};
+		cullBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+		cullBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+		cullBarrier.dstAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_SHADER_READ_BIT;
+		vkCmdPipelineBarrier(
+			commandBuffer,
+			VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+			VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+			0, 1, &cullBarrier, 0, nullptr, 0, nullptr);
+	}
+
+	void GpuCullingSystem::setDepthPyramid(FrameInfo& frameInfo, VkExtent2D depthExtent, VkImage image, VkImageView view)
+	{
+		VkExtent2D previousExtent = depthPyramid->getDepthExtent();
+		depthPyramid->setImage(depthExtent, image, view);
+		if (image != VK_NULL_HANDLE && (depthExtent.width != previousExtent.width || depthExtent.height != previousExtent.height))
+		{
+			resetVisibility();
+		}
+
+		// Only this frame's set is safe to rewrite, the others may still be bound by frames in flight
+		if (pyramidDescriptorViews[frameInfo.frameIndex] != depthPyramid->descriptorInfo().imageView)
+		{
+			writePyramidDescriptor(frameInfo.frameIndex);
+		}
+	}
+
+	void GpuCullingSystem::buildDepthPyramid(FrameInfo& frameInfo, VkImageView depthView)
+	{
+		assert(occlusionCulling && "Depth pyramid is only used by occlusion culling");
+
+		depthPyramid->build(frameInfo.commandBuffer, frameInfo.frameIndex, depthView);
+	}
+
+	void GpuCullingSystem::drawBatch(VkCommandBuffer commandBuffer, int frameIndex, CullPhase phase, uint32_t batchIndex, uint32_t firstCommand, uint32_t maxCommandCount)
+	{
+		constexpr uint32_t stride = sizeof(VkDrawIndexedIndirectCommand);
+		uint32_t phaseOffset = static_cast<uint32_t>(phase) * maxObjects;
+		VkBuffer drawCommands = drawCommandBuffers[frameIndex]->getBuffer();
+		VkDeviceSize commandOffset = static_cast<VkDeviceSize>(phaseOffset + firstCommand) * stride;
+
+		if (lveDevice.features12.drawIndirectCount)
+		{
+			VkBuffer drawCounts = drawCountBuffers[frameIndex]->getBuffer();
+			VkDeviceSize countOffset = static_cast<VkDeviceSize>(phaseOffset + batchIndex) * sizeof(uint32_t);
+			vkCmdDrawIndexedIndirectCount(commandBuffer, drawCommands, commandOffset, drawCounts, countOffset, maxCommandCount, stride);
+			return;
+		}
+
+		uint32_t maxDrawCount = lveDevice.features.multiDrawIndirect ? lveDevice.properties.limits.maxDrawIndirectCount : 1;
+		for (uint32_t first = 0; first < maxCommandCount; first += maxDrawCount)
+		{
+			uint32_t drawCount = std::min(maxDrawCount, maxCommandCount - first);
+			vkCmdDrawIndexedIndirect(commandBuffer, drawCommands, commandOffset + static_cast<VkDeviceSize>(first) * stride, drawCount, stride);
+		}
+	}
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include "Pipeline.h"
+#include "LveDevice.h"
+#include "LveDescriptor.h"
+#include "LveDepthPyramid.h"
+#include "Lve_Buffer.h"
+#include "Lve_Frame_Info.h"
+
+// Std
+#include <memory>
+#include <vector>
+
+namespace lve {
+	// Early draws what was visible last frame, late draws what the depth pyramid of the early pass revealed
+	enum class CullPhase : uint32_t {
+		Early = 0,
+		Late = 1,
+	};
+
+	// Frustum and occlusion culls the object buffer on the GPU and compacts the surviving objects into
+	// per-batch indirect draw commands plus a per-batch draw count.
+	class GpuCullingSystem
+	{
+	public:
+		// objectSetLayout is bound as set 0 of cull.comp
+		GpuCullingSystem(LveDevice& device, const LveDescriptorSetLayout& objectSetLayout, uint32_t maxObjects);
+
+		GpuCullingSystem(const GpuCullingSystem&) = delete;
+		GpuCullingSystem& operator=(const GpuCullingSystem&) = delete;
+
+		static bool isSupported(LveDevice& device) { return device.features.drawIndirectFirstInstance; }
+
+		// With occlusion culling off only the early phase is used and it draws everything inside the frustum
+		void setOcclusionCulling(bool enabled);
+		bool isOcclusionCullingEnabled() const { return occlusionCulling; }
+		// Object indices changed, forget which objects were visible last frame
+		void resetVisibility() { visibilityResetPending = true; }
+
+		// Call every frame before recording the early phase, with the render graph's pyramid image for this frame
+		// (see LveDepthPyramid::getImageDesc) or VK_NULL_HANDLE without occlusion culling. Rewrites the descriptor
+		// set the cull binds when the image changed.
+		void setDepthPyramid(FrameInfo& frameInfo, VkExtent2D depthExtent, VkImage image, VkImageView view);
+
+		// Must be recorded outside of a render pass
+		void cull(FrameInfo& frameInfo, VkDescriptorSet objectSet, uint32_t objectCount, CullPhase phase);
+		void buildDepthPyramid(FrameInfo& frameInfo, VkImageView depthView);
+		void drawBatch(VkCommandBuffer commandBuffer, int frameIndex, CullPhase phase, uint32_t batchIndex, uint32_t firstCommand, uint32_t maxCommandCount);
+
+	private:
+		void createBuffers(const LveShaderReflection& reflection);
+		void createPipelineLayout(const LveDescriptorSetLayout& objectSetLayout, const LveShaderReflection& reflection);
+		void createPipeline();
+		void writeCullData(FrameInfo& frameInfo);
+		void writePyramidDescriptor(int frameIndex);
+
+		LveDevice& lveDevice;
+		uint32_t maxObjects;
+
+		std::unique_ptr<ComputePipeline> pipeline;
+		VkPipelineLayout pipelineLayout;  // owned by the layout cache
+
+		LveDescriptorSetLayout* cullSetLayout = nullptr;  // owned by the layout cache
+		std::unique_ptr<LveDescriptorPool> cullPool;
+		std::vector<VkDescriptorSet> cullDescriptorSets;
+		std::vector<VkImageView> pyramidDescriptorViews;  // per frame, rewritten once that frame's timeline value has been waited on
+		std::vector<std::unique_ptr<Lve_Buffer>> drawCommandBuffers;
+		std::vector<std::unique_ptr<Lve_Buffer>> drawCountBuffers;
+		std::vector<std::unique_ptr<Lve_Buffer>> cullDataBuffers;
+
+		// The image is a render graph transient shared by all frames, frames are culled in submission order
+		std::unique_ptr<LveDepthPyramid> depthPyramid;
+		std::unique_ptr<Lve_Buffer> visibilityBuffer;
+
+		bool occlusionCulling = false;
+		bool visibilityResetPending = true;
+	};
+}
@@ -25,8 +25,8 @@ namespace lve {
 		void moveInPlaneXZ(GLFWwindow* window, LveGameObject& gameObject, float deltaTime);
 
 		KeyMappings keys{};
-		float moveSpeed{ 5000.0f };
-		float lookSpeed{ 5000.0f };
+		float moveSpeed{ 3.0f };
+		float lookSpeed{ 1.5f };
 	};
 	
 	class Keyboard_Movement_Input_Alt
@@ -50,7 +50,7 @@ namespace lve {
 		void moveInPlaneXZ(GLFWwindow* window, LveGameObject& gameObject, float deltaTime);
 
 		KeyMappings keys{};
-		float moveSpeed{ 5000.0f };
-		float lookSpeed{ 5000.0f };
+		float moveSpeed{ 3.0f };
+		float lookSpeed{ 1.5f };
 	};
 }
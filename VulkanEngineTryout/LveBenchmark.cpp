@@ -0,0 +1,354 @@
+#include "LveBenchmark.h"
+#include "LveModel.h"
+#include "SimpleRenderSystem.h"
+
+// std
+#include <algorithm>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <unordered_map>
+
+namespace lve {
+
+	namespace {
+		// Catmull-Rom between p1 and p2, the neighbours shape the tangents
+		glm::vec3 catmullRom(const glm::vec3& p0, const glm::vec3& p1, const glm::vec3& p2, const glm::vec3& p3, float t)
+		{
+			float t2 = t * t;
+			float t3 = t2 * t;
+			return 0.5f * (2.0f * p1 + (p2 - p0) * t + (2.0f * p0 - 5.0f * p1 + 4.0f * p2 - p3) * t2 + (3.0f * p1 - p0 - 3.0f * p2 + p3) * t3);
+		}
+
+		// JSON has no NaN, metrics that were not measured are null
+		std::string jsonNumber(float value)
+		{
+			if (std::isnan(value)) return "null";
+			std::ostringstream stream;
+			stream << value;
+			return stream.str();
+		}
+
+		std::string jsonString(const std::string& value)
+		{
+			std::string escaped = "\"";
+			for (char c : value)
+			{
+				if (c == '"' || c == '\\') escaped += '\\';
+				escaped += c;
+			}
+			return escaped + "\"";
+		}
+
+		void writeJsonSummary(std::ofstream& file, const char* name, const LveFrameStats::Summary& summary)
+		{
+			file << "    \"" << name << "\": { \"count\": " << summary.count << ", \"mean\": " << summary.mean << ", \"p50\": " << summary.p50
+				<< ", \"p95\": " << summary.p95 << ", \"p99\": " << summary.p99 << ", \"max\": " << summary.max << " }";
+		}
+	}
+
+	LveBenchmark LveBenchmark::loadFromFile(const std::string& filePath)
+	{
+		std::ifstream file{ filePath };
+		if (!file.is_open())
+		{
+			throw std::runtime_error("Failed to open file: " + filePath);
+		}
+
+		LveBenchmark benchmark{};
+		benchmark.name = std::filesystem::path(filePath).stem().string();
+
+		std::string line;
+		for (uint32_t lineNumber = 1; std::getline(file, line); lineNumber++)
+		{
+			line = line.substr(0, line.find('#'));
+			std::istringstream tokens{ line };
+			std::string directive;
+			if (!(tokens >> directive)) continue;
+
+			auto fail = [&](const std::string& message)
+			{
+				throw std::runtime_error(filePath + ":" + std::to_string(lineNumber) + ": " + message);
+			};
+			auto readFloat = [&]()
+			{
+				float value;
+				if (!(tokens >> value)) fail("expected a number after " + directive);
+				return value;
+			};
+			auto readVec3 = [&]() { return glm::vec3{ readFloat(), readFloat(), readFloat() }; };
+			auto readCount = [&]()
+			{
+				float value = readFloat();
+				// 2^32, UINT32_MAX itself rounds up to it as a float and would pass a > check
+				if (value < 0.0f || value >= 4294967296.0f || value != std::floor(value)) fail("expected a whole number after " + directive);
+				return static_cast<uint32_t>(value);
+			};
+			// The renderer's indirect draw buffers have a fixed size
+			auto checkObjectCount = [&](uint64_t addedCount)
+			{
+				if (benchmark.objects.size() + addedCount > SimpleRenderSystem::MAX_OBJECTS)
+				{
+					fail("more than " + std::to_string(SimpleRenderSystem::MAX_OBJECTS) + " objects, the renderer's limit");
+				}
+			};
+			auto readString = [&]()
+			{
+				std::string value;
+				if (!(tokens >> value)) fail("expected a model path after " + directive);
+				return value;
+			};
+
+			if (directive == "frames")
+			{
+				benchmark.frameCount = readCount();
+				if (!(tokens >> std::ws).eof()) benchmark.warmupFrameCount = readCount();
+			}
+			else if (directive == "step")
+			{
+				benchmark.step = readFloat();
+				if (benchmark.step <= 0.0f) fail("step has to be positive");
+			}
+			else if (directive == "object")
+			{
+				SceneObject object{};
+				object.modelPath = readString();
+				object.transform.translation = readVec3();
+				object.transform.rotation = glm::radians(readVec3());
+				object.transform.scale = glm::vec3{ readFloat() };
+				std::string flag;
+				if (tokens >> flag)
+				{
+					if (flag != "static") fail("unknown object flag " + flag);
+					object.isStatic = true;
+				}
+				checkObjectCount(1);
+				benchmark.objects.push_back(object);
+			}
+			else if (directive == "grid")
+			{
+				std::string modelPath = readString();
+				uint32_t columns = readCount();
+				uint32_t rows = readCount();
+				float spacing = readFloat();
+				glm::vec3 center = readVec3();
+				float scale = readFloat();
+				checkObjectCount(uint64_t{ columns } * rows);
+
+				// Centered on center in the XZ plane
+				glm::vec3 origin = center - glm::vec3{ (columns - 1) * spacing, 0.0f, (rows - 1) * spacing } * 0.5f;
+				for (uint32_t row = 0; row < rows; row++)
+				{
+					for (uint32_t column = 0; column < columns; column++)
+					{
+						SceneObject object{};
+						object.modelPath = modelPath;
+						object.transform.translation = origin + glm::vec3{ column * spacing, 0.0f, row * spacing };
+						object.transform.scale = glm::vec3{ scale };
+						object.isStatic = true;
+						benchmark.objects.push_back(object);
+					}
+				}
+			}
+			else if (directive == "camera")
+			{
+				CameraKey key{};
+				key.time = readFloat();
+				key.position = readVec3();
+				key.rotation = glm::radians(readVec3());
+				if (!benchmark.cameraKeys.empty() && key.time <= benchmark.cameraKeys.back().time) fail("camera keys have to be in ascending time");
+				benchmark.cameraKeys.push_back(key);
+			}
+			else
+			{
+				fail("unknown directive " + directive);
+			}
+
+			std::string rest;
+			if (tokens >> rest) fail("unexpected " + rest);
+		}
+
+		if (benchmark.frameCount == 0)
+		{
+			throw std::runtime_error(filePath + ": needs a frames directive with at least one frame");
+		}
+		if (benchmark.cameraKeys.empty())
+		{
+			throw std::runtime_error(filePath + ": needs at least one camera key");
+		}
+		return benchmark;
+	}
+
+	std::vector<LveGameObject> LveBenchmark::createGameObjects(LveDevice& device) const
+	{
+		std::unordered_map<std::string, std::shared_ptr<LveModel>> models;
+		std::vector<LveGameObject> gameObjects;
+		gameObjects.reserve(objects.size());
+		for (const auto& object : objects)
+		{
+			auto& model = models[object.modelPath];
+			if (!model)
+			{
+				model = LveModel::createModelFromFile(device, object.modelPath);
+			}
+
+			auto gameObject = LveGameObject::createGameObject();
+			gameObject.model = model;
+			gameObject.transform = object.transform;
+			gameObject.isStatic = object.isStatic;
+			gameObjects.push_back(std::move(gameObject));
+		}
+		return gameObjects;
+	}
+
+	TransformComponent LveBenchmark::getCameraTransform(float time) const
+	{
+		TransformComponent transform{};
+		if (time <= cameraKeys.front().time)
+		{
+			transform.translation = cameraKeys.front().position;
+			transform.rotation = cameraKeys.front().rotation;
+			return transform;
+		}
+		if (time >= cameraKeys.back().time)
+		{
+			transform.translation = cameraKeys.back().position;
+			transform.rotation = cameraKeys.back().rotation;
+			return transform;
+		}
+
+		// The segment time is in, the first and last key stand in for their missing neighbours
+		size_t segment = std::upper_bound(cameraKeys.begin(), cameraKeys.end(), time,
+			[](float t, const CameraKey& key) { return t < key.time; }) - cameraKeys.begin() - 1;
+		const CameraKey& k0 = cameraKeys[segment == 0 ? 0 : segment - 1];
+		const CameraKey& k1 = cameraKeys[segment];
+		const CameraKey& k2 = cameraKeys[segment + 1];
+		const CameraKey& k3 = cameraKeys[std::min(segment + 2, cameraKeys.size() - 1)];
+
+		float t = (time - k1.time) / (k2.time - k1.time);
+		transform.translation = catmullRom(k0.position, k1.position, k2.position, k3.position, t);
+		transform.rotation = catmullRom(k0.rotation, k1.rotation, k2.rotation, k3.rotation, t);
+		return transform;
+	}
+
+	void LveBenchmark::record(const FrameSample& sample)
+	{
+		samples.push_back(sample);
+	}
+
+	std::vector<float> LveBenchmark::getMilliseconds(float FrameSample::* member) const
+	{
+		std::vector<float> values;
+		values.reserve(samples.size());
+		for (const auto& sample : samples)
+		{
+			if (!std::isnan(sample.*member)) values.push_back(sample.*member);
+		}
+		return values;
+	}
+
+	LveFrameStats::Summary LveBenchmark::getCpuSummary() const
+	{
+		return LveFrameStats::summarize(getMilliseconds(&FrameSample::cpuMilliseconds));
+	}
+
+	LveFrameStats::Summary LveBenchmark::getGpuSummary() const
+	{
+		return LveFrameStats::summarize(getMilliseconds(&FrameSample::gpuMilliseconds));
+	}
+
+	void LveBenchmark::writeCsv(const std::string& filePath) const
+	{
+		std::ofstream file{ filePath, std::ios::trunc };
+		if (!file.is_open())
+		{
+			throw std::runtime_error("Failed to open file: " + filePath);
+		}
+
+		file << "frame,cpu_ms,gpu_ms,timeline_wait_ms,submit_ms,device_memory_bytes\n";
+		for (size_t i = 0; i < samples.size(); i++)
+		{
+			const FrameSample& sample = samples[i];
+			file << i;
+			for (float value : { sample.cpuMilliseconds, sample.gpuMilliseconds, sample.timelineWaitMilliseconds, sample.submitMilliseconds })
+			{
+				file << ",";
+				if (!std::isnan(value)) file << value;
+			}
+			file << "," << sample.deviceMemoryBytes << "\n";
+		}
+
+		if (!file)
+		{
+			throw std::runtime_error("Failed to write file: " + filePath);
+		}
+	}
+
+	void LveBenchmark::writeJson(const std::string& filePath, const std::string& deviceName) const
+	{
+		std::ofstream file{ filePath, std::ios::trunc };
+		if (!file.is_open())
+		{
+			throw std::runtime_error("Failed to open file: " + filePath);
+		}
+
+		uint64_t peakMemory = 0;
+		for (const auto& sample : samples) peakMemory = std::max(peakMemory, sample.deviceMemoryBytes);
+
+		file << "{\n";
+		file << "  \"benchmark\": " << jsonString(name) << ",\n";
+		file << "  \"device\": " << jsonString(deviceName) << ",\n";
+		file << "  \"warmup_frames\": " << warmupFrameCount << ",\n";
+		file << "  \"frames\": " << samples.size() << ",\n";
+		file << "  \"step_seconds\": " << step << ",\n";
+		file << "  \"summary\": {\n";
+		writeJsonSummary(file, "cpu_ms", getCpuSummary());
+		file << ",\n";
+		writeJsonSummary(file, "gpu_ms", getGpuSummary());
+		file << ",\n";
+		writeJsonSummary(file, "timeline_wait_ms", LveFrameStats::summarize(getMilliseconds(&FrameSample::timelineWaitMilliseconds)));
+		file << ",\n";
+		writeJsonSummary(file, "submit_ms", LveFrameStats::summarize(getMilliseconds(&FrameSample::submitMilliseconds)));
+		file << ",\n";
+		file << "    \"peak_device_memory_bytes\": " << peakMemory << "\n";
+		file << "  },\n";
+
+		file << "  \"samples\": [\n";
+		for (size_t i = 0; i < samples.size(); i++)
+		{
+			const FrameSample& sample = samples[i];
+			file << "    { \"cpu_ms\": " << jsonNumber(sample.cpuMilliseconds) << ", \"gpu_ms\": " << jsonNumber(sample.gpuMilliseconds)
+				<< ", \"timeline_wait_ms\": " << jsonNumber(sample.timelineWaitMilliseconds) << ", \"submit_ms\": " << jsonNumber(sample.submitMilliseconds)
+				<< ", \"device_memory_bytes\": " << sample.deviceMemoryBytes << " }" << (i + 1 < samples.size() ? ",\n" : "\n");
+		}
+		file << "  ]\n";
+		file << "}\n";
+
+		if (!file)
+		{
+			throw std::runtime_error("Failed to write file: " + filePath);
+		}
+	}
+
+	void LveBenchmark::printSummary() const
+	{
+		auto cpu = getCpuSummary();
+		auto gpu = getGpuSummary();
+		uint64_t peakMemory = 0;
+		for (const auto& sample : samples) peakMemory = std::max(peakMemory, sample.deviceMemoryBytes);
+
+		std::cout << "Benchmark " << name << ": " << samples.size() << " frames after " << warmupFrameCount << " warmup frames" << std::endl;
+		std::cout << "  CPU mean/p50/p95/p99/max: " << cpu.mean << " / " << cpu.p50 << " / " << cpu.p95 << " / " << cpu.p99 << " / " << cpu.max << " ms" << std::endl;
+		if (gpu.count > 0)
+		{
+			std::cout << "  GPU mean/p50/p95/p99/max: " << gpu.mean << " / " << gpu.p50 << " / " << gpu.p95 << " / " << gpu.p99 << " / " << gpu.max << " ms" << std::endl;
+		}
+		if (peakMemory > 0)
+		{
+			std::cout << "  Peak device memory: " << peakMemory / (1024 * 1024) << " MiB" << std::endl;
+		}
+	}
+}
@@ -0,0 +1,83 @@
+#pragma once
+
+#include "LveDevice.h"
+#include "LveGameObject.h"
+#include "LveFrameStats.h"
+
+// GLM
+#include <glm/glm.hpp>
+
+// std
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace lve {
+
+	// A repeatable run: a scene, a scripted camera path and a frame count, read from a text file such as
+	// Benchmarks/orbit.bench. Every frame advances time by the same step however long it took, so every
+	// run renders the same images and only the measurements differ. The samples of the measured frames
+	// are written as CSV and JSON.
+	class LveBenchmark
+	{
+	public:
+		struct FrameSample {
+			float cpuMilliseconds = 0.0f;           // from the start of the frame until it is submitted
+			float gpuMilliseconds = 0.0f;           // the last measured one, frames in flight behind the CPU
+			float timelineWaitMilliseconds = 0.0f;
+			float submitMilliseconds = 0.0f;
+			uint64_t deviceMemoryBytes = 0;         // device local usage, 0 without VK_EXT_memory_budget
+		};
+
+		// Throws std::runtime_error with the line of the first error
+		static LveBenchmark loadFromFile(const std::string& filePath);
+
+		const std::string& getName() const { return name; }
+		uint32_t getWarmupFrameCount() const { return warmupFrameCount; }
+		uint32_t getFrameCount() const { return frameCount; }
+		// Seconds every frame advances by
+		float getStep() const { return step; }
+
+		// Objects sharing a model file share the model
+		std::vector<LveGameObject> createGameObjects(LveDevice& device) const;
+		// Catmull-Rom through the camera keys, clamped to the first and last key
+		TransformComponent getCameraTransform(float time) const;
+
+		// Once per measured frame
+		void record(const FrameSample& sample);
+		const std::vector<FrameSample>& getSamples() const { return samples; }
+
+		LveFrameStats::Summary getCpuSummary() const;
+		LveFrameStats::Summary getGpuSummary() const;
+
+		// One row or entry per measured frame, the JSON starts with the summaries. Throw std::runtime_error.
+		void writeCsv(const std::string& filePath) const;
+		void writeJson(const std::string& filePath, const std::string& deviceName) const;
+		void printSummary() const;
+
+	private:
+		struct SceneObject {
+			std::string modelPath;
+			TransformComponent transform;
+			bool isStatic;
+		};
+
+		struct CameraKey {
+			float time;
+			glm::vec3 position;
+			glm::vec3 rotation;  // radians
+		};
+
+		std::vector<float> getMilliseconds(float FrameSample::* member) const;
+
+		std::string name;
+		// Covers pipeline compilation in the background and the first GPU timings arriving
+		uint32_t warmupFrameCount = 60;
+		uint32_t frameCount = 0;
+		float step = 1.0f / 60.0f;
+		std::vector<SceneObject> objects;
+		std::vector<CameraKey> cameraKeys;  // ascending time
+
+		std::vector<FrameSample> samples;
+	};
+}
@@ -0,0 +1,174 @@
+#include "LveBindlessRegistry.h"
+
+// std
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <stdexcept>
+#include <string>
+
+namespace lve {
+
+	LveBindlessRegistry::LveBindlessRegistry(LveDevice& device) : lveDevice{ device }
+	{
+		if (const char* missingFeature = findMissingFeature(lveDevice))
+		{
+			throw std::runtime_error(std::string("bindless descriptors need the descriptor indexing feature ") + missingFeature + ", which the device does not support");
+		}
+		fitToLimits();
+
+		// Partially bound: unregistered slots may stay empty as long as no shader reads them.
+		// Update after bind: slots can be registered while the set is bound in command buffers that are pending.
+		constexpr VkDescriptorBindingFlags bindlessFlags =
+			VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT |
+			VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT |
+			VK_DESCRIPTOR_BINDING_UPDATE_UNUSED_WHILE_PENDING_BIT;
+
+		// Not reflected: shaders declare the arrays unsized and the counts and flags are the registry's choice
+		setLayout = &lveDevice.getLayoutCache().getDescriptorSetLayout(
+			{
+				{ BUFFER_BINDING, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, maxBuffers, VK_SHADER_STAGE_ALL_GRAPHICS | VK_SHADER_STAGE_COMPUTE_BIT, nullptr },
+				{ SAMPLER_BINDING, VK_DESCRIPTOR_TYPE_SAMPLER, maxSamplers, VK_SHADER_STAGE_FRAGMENT_BIT | VK_SHADER_STAGE_COMPUTE_BIT, nullptr },
+				{ TEXTURE_BINDING, VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, maxTextures, VK_SHADER_STAGE_FRAGMENT_BIT | VK_SHADER_STAGE_COMPUTE_BIT, nullptr },
+			},
+			{ bindlessFlags, bindlessFlags, bindlessFlags | VK_DESCRIPTOR_BINDING_VARIABLE_DESCRIPTOR_COUNT_BIT });
+
+		pool = LveDescriptorPool::Builder(lveDevice)
+			.setMaxSets(1)
+			.setPoolFlags(VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT)
+			.addPoolSize(VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, maxBuffers)
+			.addPoolSize(VK_DESCRIPTOR_TYPE_SAMPLER, maxSamplers)
+			.addPoolSize(VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, maxTextures)
+			.build();
+
+		if (!pool->allocateDescriptor(setLayout->getDescriptorSetLayout(), descriptorSet, maxTextures))
+		{
+			throw std::runtime_error("failed to allocate bindless descriptor set");
+		}
+
+		createDefaults();
+	}
+
+	LveBindlessRegistry::~LveBindlessRegistry()
+	{
+		vkDestroySampler(lveDevice.device(), defaultSampler, nullptr);
+	}
+
+	const char* LveBindlessRegistry::findMissingFeature(LveDevice& device)
+	{
+		auto& features12 = device.features12;
+		if (!features12.descriptorIndexing) return "descriptorIndexing";
+		if (!features12.runtimeDescriptorArray) return "runtimeDescriptorArray";
+		if (!features12.shaderSampledImageArrayNonUniformIndexing) return "shaderSampledImageArrayNonUniformIndexing";
+		if (!features12.descriptorBindingPartiallyBound) return "descriptorBindingPartiallyBound";
+		if (!features12.descriptorBindingVariableDescriptorCount) return "descriptorBindingVariableDescriptorCount";
+		if (!features12.descriptorBindingUpdateUnusedWhilePending) return "descriptorBindingUpdateUnusedWhilePending";
+		if (!features12.descriptorBindingSampledImageUpdateAfterBind) return "descriptorBindingSampledImageUpdateAfterBind";
+		if (!features12.descriptorBindingStorageBufferUpdateAfterBind) return "descriptorBindingStorageBufferUpdateAfterBind";
+		return nullptr;
+	}
+
+	void LveBindlessRegistry::fitToLimits()
+	{
+		// The per stage and per set limits count every set of a pipeline layout, not just this one
+		auto clampToLimit = [](uint32_t count, uint32_t limit, const char* limitName)
+		{
+			if (limit <= RESERVED_DESCRIPTORS)
+			{
+				throw std::runtime_error(std::string("bindless registry does not fit the device limit ") + limitName + " (" + std::to_string(limit) + ")");
+			}
+			return std::min(count, limit - RESERVED_DESCRIPTORS);
+		};
+		auto remaining = [](uint32_t limit, uint32_t used) { return limit > used ? limit - used : 0; };
+
+		const auto& limits = lveDevice.properties12;
+		maxBuffers = clampToLimit(MAX_BUFFERS, limits.maxPerStageDescriptorUpdateAfterBindStorageBuffers, "maxPerStageDescriptorUpdateAfterBindStorageBuffers");
+		maxBuffers = clampToLimit(maxBuffers, limits.maxDescriptorSetUpdateAfterBindStorageBuffers, "maxDescriptorSetUpdateAfterBindStorageBuffers");
+		maxSamplers = clampToLimit(MAX_SAMPLERS, limits.maxPerStageDescriptorUpdateAfterBindSamplers, "maxPerStageDescriptorUpdateAfterBindSamplers");
+		maxSamplers = clampToLimit(maxSamplers, limits.maxDescriptorSetUpdateAfterBindSamplers, "maxDescriptorSetUpdateAfterBindSamplers");
+		maxTextures = clampToLimit(MAX_TEXTURES, limits.maxPerStageDescriptorUpdateAfterBindSampledImages, "maxPerStageDescriptorUpdateAfterBindSampledImages");
+		maxTextures = clampToLimit(maxTextures, limits.maxDescriptorSetUpdateAfterBindSampledImages, "maxDescriptorSetUpdateAfterBindSampledImages");
+
+		// Buffers and textures share the per stage resource limit, and all three the pool limit. Textures give way.
+		maxTextures = clampToLimit(maxTextures, remaining(limits.maxPerStageUpdateAfterBindResources, maxBuffers), "maxPerStageUpdateAfterBindResources");
+		maxTextures = clampToLimit(maxTextures, remaining(limits.maxUpdateAfterBindDescriptorsInAllPools, maxBuffers + maxSamplers), "maxUpdateAfterBindDescriptorsInAllPools");
+	}
+
+	void LveBindlessRegistry::createDefaults()
+	{
+		VkSamplerCreateInfo samplerInfo{};
+		samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+		samplerInfo.magFilter = VK_FILTER_LINEAR;
+		samplerInfo.minFilter = VK_FILTER_LINEAR;
+		samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
+		samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+		samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+		samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+		samplerInfo.anisotropyEnable = VK_TRUE;
+		samplerInfo.maxAnisotropy = lveDevice.properties.limits.maxSamplerAnisotropy;
+		samplerInfo.minLod = 0.0f;
+		samplerInfo.maxLod = VK_LOD_CLAMP_NONE;
+
+		if (vkCreateSampler(lveDevice.device(), &samplerInfo, nullptr, &defaultSampler) != VK_SUCCESS)
+		{
+			throw std::runtime_error("failed to create default sampler");
+		}
+
+		std::array<uint8_t, 4> white{ 255, 255, 255, 255 };
+		whiteTexture = std::make_unique<LveTexture>(lveDevice, 1, 1, white.data());
+
+		uint32_t samplerIndex = registerSampler(defaultSampler);
+		uint32_t textureIndex = registerTexture(*whiteTexture);
+		assert(samplerIndex == DEFAULT_SAMPLER && textureIndex == WHITE_TEXTURE && "Defaults must take the first slots");
+	}
+
+	uint32_t LveBindlessRegistry::allocateSlot(uint32_t& nextSlot, std::vector<uint32_t>& freeSlots, uint32_t maxSlots, const char* kind)
+	{
+		if (!freeSlots.empty())
+		{
+			uint32_t slot = freeSlots.back();
+			freeSlots.pop_back();
+			return slot;
+		}
+
+		if (nextSlot == maxSlots)
+		{
+			throw std::runtime_error(std::string("bindless registry is out of ") + kind + " slots");
+		}
+		return nextSlot++;
+	}
+
+	uint32_t LveBindlessRegistry::registerBuffer(VkDescriptorBufferInfo bufferInfo)
+	{
+		uint32_t index = allocateSlot(nextBuffer, freeBuffers, maxBuffers, "buffer");
+		LveDescriptorWriter(*setLayout, *pool)
+			.writeBuffer(BUFFER_BINDING, index, &bufferInfo)
+			.overwrite(descriptorSet);
+		return index;
+	}
+
+	uint32_t LveBindlessRegistry::registerSampler(VkSampler sampler)
+	{
+		uint32_t index = allocateSlot(nextSampler, freeSamplers, maxSamplers, "sampler");
+
+		VkDescriptorImageInfo imageInfo{};
+		imageInfo.sampler = sampler;
+		LveDescriptorWriter(*setLayout, *pool)
+			.writeImage(SAMPLER_BINDING, index, &imageInfo)
+			.overwrite(descriptorSet);
+		return index;
+	}
+
+	uint32_t LveBindlessRegistry::registerTexture(const LveTexture& texture)
+	{
+		uint32_t index = allocateSlot(nextTexture, freeTextures, maxTextures, "texture");
+
+		VkDescriptorImageInfo imageInfo{};
+		imageInfo.imageView = texture.getImageView();
+		imageInfo.imageLayout = texture.getImageLayout();
+		LveDescriptorWriter(*setLayout, *pool)
+			.writeImage(TEXTURE_BINDING, index, &imageInfo)
+			.overwrite(descriptorSet);
+		return index;
+	}
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+#include "LveDevice.h"
+#include "LveDescriptor.h"
+#include "LveTexture.h"
+
+// std
+#include <memory>
+#include <vector>
+
+namespace lve {
+	// One descriptor set holding every buffer, sampler and texture, referenced by index from shaders
+	// (descriptor indexing). Bound once per command buffer no matter how many resources the draws use.
+	// Slots are written with update after bind, so registering never invalidates recorded command buffers.
+	class LveBindlessRegistry
+	{
+	public:
+		static constexpr uint32_t BUFFER_BINDING = 0;
+		static constexpr uint32_t SAMPLER_BINDING = 1;
+		static constexpr uint32_t TEXTURE_BINDING = 2;  // highest binding, the only one with a variable count
+
+		// Upper bounds, devices with lower update after bind limits get fewer slots, see getMaxBuffers and friends
+		static constexpr uint32_t MAX_BUFFERS = 1024;
+		static constexpr uint32_t MAX_SAMPLERS = 32;
+		static constexpr uint32_t MAX_TEXTURES = 4096;
+		// Per descriptor type, left to the other sets of pipeline layouts that include the registry's set
+		static constexpr uint32_t RESERVED_DESCRIPTORS = 8;
+
+		// Registered by the constructor, so shaders can always sample something
+		static constexpr uint32_t DEFAULT_SAMPLER = 0;
+		static constexpr uint32_t WHITE_TEXTURE = 0;
+
+		// Throws std::runtime_error naming the missing feature or the device limit that is too low
+		LveBindlessRegistry(LveDevice& device);
+		~LveBindlessRegistry();
+
+		LveBindlessRegistry(const LveBindlessRegistry&) = delete;
+		LveBindlessRegistry& operator=(const LveBindlessRegistry&) = delete;
+
+		static bool isSupported(LveDevice& device) { return findMissingFeature(device) == nullptr; }
+
+		uint32_t getMaxBuffers() const { return maxBuffers; }
+		uint32_t getMaxSamplers() const { return maxSamplers; }
+		uint32_t getMaxTextures() const { return maxTextures; }
+
+		VkDescriptorSetLayout getDescriptorSetLayout() const { return setLayout->getDescriptorSetLayout(); }
+		const LveDescriptorSetLayout& getSetLayout() const { return *setLayout; }
+		VkDescriptorSet getDescriptorSet() const { return descriptorSet; }
+
+		// The resources must outlive their registration
+		uint32_t registerBuffer(VkDescriptorBufferInfo bufferInfo);
+		uint32_t registerSampler(VkSampler sampler);
+		uint32_t registerTexture(const LveTexture& texture);
+
+		// The slot is reused by the next registration, no frame in flight may still read it
+		void releaseBuffer(uint32_t index) { freeBuffers.push_back(index); }
+		void releaseSampler(uint32_t index) { freeSamplers.push_back(index); }
+		void releaseTexture(uint32_t index) { freeTextures.push_back(index); }
+
+	private:
+		// Null when the device has every feature the registry needs
+		static const char* findMissingFeature(LveDevice& device);
+		void fitToLimits();
+		static uint32_t allocateSlot(uint32_t& nextSlot, std::vector<uint32_t>& freeSlots, uint32_t maxSlots, const char* kind);
+		void createDefaults();
+
+		LveDevice& lveDevice;
+		LveDescriptorSetLayout* setLayout = nullptr;  // owned by the layout cache
+		std::unique_ptr<LveDescriptorPool> pool;
+		VkDescriptorSet descriptorSet;
+
+		uint32_t maxBuffers = MAX_BUFFERS;
+		uint32_t maxSamplers = MAX_SAMPLERS;
+		uint32_t maxTextures = MAX_TEXTURES;
+
+		uint32_t nextBuffer = 0;
+		uint32_t nextSampler = 0;
+		uint32_t nextTexture = 0;
+		std::vector<uint32_t> freeBuffers;
+		std::vector<uint32_t> freeSamplers;
+		std::vector<uint32_t> freeTextures;
+
+		VkSampler defaultSampler;
+		std::unique_ptr<LveTexture> whiteTexture;
+	};
+}
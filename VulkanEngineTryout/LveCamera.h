@@ -5,6 +5,9 @@
 #define GLM_FORCE_DEPTH_ZERO_TO_ONE
 #include <glm/glm.hpp>
 
+// std
+#include <array>
+
 namespace lve {
 	class LveCamera
 	{
@@ -18,6 +21,9 @@ namespace lve {
 
 		const glm::mat4& getProjection() const { return projectionMatrix; }
 		const glm::mat4& getView() const { return viewMatrix; }
+
+		// Normalized planes (xyz = inward normal, w = distance) in the order left, right, bottom, top, near, far
+		std::array<glm::vec4, 6> getFrustumPlanes() const;
 	private:
 		glm::mat4 projectionMatrix{ 1.0f };
 		glm::mat4 viewMatrix{ 1.0f };
@@ -0,0 +1,81 @@
+#include "LveDeletionQueue.h"
+
+// std
+#include <cassert>
+#include <iterator>
+
+namespace lve {
+
+	LveDeletionQueue::~LveDeletionQueue()
+	{
+		assert(pending.empty() && deletions.empty() && "Deletion queue must be flushed before the device is destroyed");
+	}
+
+	void LveDeletionQueue::push(std::function<void()> deleter)
+	{
+		std::lock_guard<std::mutex> lock{ mutex };
+		pending.push_back({ 0, std::move(deleter) });
+	}
+
+	void LveDeletionQueue::submit(uint64_t timelineValue)
+	{
+		std::lock_guard<std::mutex> lock{ mutex };
+		assert((deletions.empty() || timelineValue >= deletions.back().timelineValue) && "Timeline values must not go backwards");
+		for (auto& deletion : pending)
+		{
+			deletion.timelineValue = timelineValue;
+			deletions.push_back(std::move(deletion));
+		}
+		pending.clear();
+	}
+
+	void LveDeletionQueue::collect(uint64_t completedValue)
+	{
+		std::deque<Deletion> ready;
+		{
+			std::lock_guard<std::mutex> lock{ mutex };
+			while (!deletions.empty() && deletions.front().timelineValue <= completedValue)
+			{
+				ready.push_back(std::move(deletions.front()));
+				deletions.pop_front();
+			}
+		}
+
+		// Outside of the lock, a deleter may retire further objects
+		run(ready);
+	}
+
+	void LveDeletionQueue::flush()
+	{
+		std::deque<Deletion> ready;
+		while (true)
+		{
+			{
+				std::lock_guard<std::mutex> lock{ mutex };
+				ready.swap(deletions);
+				ready.insert(ready.end(), std::make_move_iterator(pending.begin()), std::make_move_iterator(pending.end()));
+				pending.clear();
+			}
+			if (ready.empty())
+			{
+				return;
+			}
+			run(ready);
+		}
+	}
+
+	size_t LveDeletionQueue::size()
+	{
+		std::lock_guard<std::mutex> lock{ mutex };
+		return pending.size() + deletions.size();
+	}
+
+	void LveDeletionQueue::run(std::deque<Deletion>& ready)
+	{
+		for (auto& deletion : ready)
+		{
+			deletion.deleter();
+		}
+		ready.clear();
+	}
+}
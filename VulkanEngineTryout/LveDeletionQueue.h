@@ -0,0 +1,46 @@
+#pragma once
+
+// std
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+
+namespace lve {
+	// Defers destroying GPU objects until every frame that could still reference them has finished.
+	// A deletion pushed while a frame is recorded runs once the graphics timeline reaches the value that
+	// frame's submission signals.
+	class LveDeletionQueue
+	{
+	public:
+		LveDeletionQueue() = default;
+		~LveDeletionQueue();
+
+		LveDeletionQueue(const LveDeletionQueue&) = delete;
+		LveDeletionQueue& operator=(const LveDeletionQueue&) = delete;
+
+		// Safe to call from any thread
+		void push(std::function<void()> deleter);
+
+		// A frame was submitted with timelineValue, deletions pushed so far wait for it
+		void submit(uint64_t timelineValue);
+		// Runs the deletions whose frame has reached completedValue
+		void collect(uint64_t completedValue);
+		// Runs everything, the device must be idle
+		void flush();
+
+		size_t size();
+
+	private:
+		struct Deletion {
+			uint64_t timelineValue;
+			std::function<void()> deleter;
+		};
+
+		void run(std::deque<Deletion>& ready);
+
+		std::mutex mutex;
+		std::deque<Deletion> pending;  // pushed since the last submit
+		std::deque<Deletion> deletions;  // ordered by timeline value
+	};
+}
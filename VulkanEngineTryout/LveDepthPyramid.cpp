@@ -0,0 +1,305 @@
+#include "LveDepthPyramid.h"
+#include "Lve_Swap_Chain.h"
+
+// std
+#include <algorithm>
+#include <cassert>
+#include <stdexcept>
+
+namespace lve {
+
+	struct PyramidPushConstantData {
+		int32_t sourceSize[2];
+		int32_t destinationSize[2];
+	};
+
+	constexpr uint32_t PYRAMID_WORKGROUP_SIZE = 8;
+
+	LveDepthPyramid::LveDepthPyramid(LveDevice& device) : lveDevice{ device }
+	{
+		createPipeline();
+		createPlaceholder();
+	}
+
+	LveDepthPyramid::~LveDepthPyramid()
+	{
+		for (auto levelView : levelViews)
+		{
+			vkDestroyImageView(lveDevice.device(), levelView, nullptr);
+		}
+
+		vkDestroyImageView(lveDevice.device(), placeholderView, nullptr);
+		vkDestroyImage(lveDevice.device(), placeholderImage, nullptr);
+		vkFreeMemory(lveDevice.device(), placeholderMemory, nullptr);
+		vkDestroySampler(lveDevice.device(), sampler, nullptr);
+	}
+
+	LveRenderGraph::ImageDesc LveDepthPyramid::getImageDesc(VkExtent2D depthExtent)
+	{
+		LveRenderGraph::ImageDesc desc{};
+		desc.extent.width = std::max(1u, (depthExtent.width + 1) / 2);
+		desc.extent.height = std::max(1u, (depthExtent.height + 1) / 2);
+		desc.format = VK_FORMAT_R32_SFLOAT;
+		desc.usage = VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+		desc.aspect = VK_IMAGE_ASPECT_COLOR_BIT;
+
+		// Same rounding up halving as build(), down to a single texel
+		desc.mipLevels = 1;
+		uint32_t levelSize = std::max(desc.extent.width, desc.extent.height);
+		while (levelSize > 1 && desc.mipLevels < MAX_LEVELS)
+		{
+			levelSize = (levelSize + 1) / 2;
+			desc.mipLevels++;
+		}
+		return desc;
+	}
+
+	void LveDepthPyramid::setImage(VkExtent2D newDepthExtent, VkImage newImage, VkImageView newView)
+	{
+		if (newImage == image && newDepthExtent.width == depthExtent.width && newDepthExtent.height == depthExtent.height)
+		{
+			return;
+		}
+
+		// Frames in flight may still build the old pyramid
+		if (image != VK_NULL_HANDLE)
+		{
+			retireLevelViews();
+		}
+
+		image = newImage;
+		imageView = newView;
+		if (image == VK_NULL_HANDLE)
+		{
+			return;
+		}
+
+		auto desc = getImageDesc(newDepthExtent);
+		depthExtent = newDepthExtent;
+		pyramidExtent = desc.extent;
+		levelCount = desc.mipLevels;
+
+		pool = LveDescriptorPool::Builder(lveDevice)
+			.setMaxSets(Lve_Swap_Chain::MAX_FRAMES_IN_FLIGHT + MAX_LEVELS)
+			.addPoolSize(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, Lve_Swap_Chain::MAX_FRAMES_IN_FLIGHT + MAX_LEVELS)
+			.addPoolSize(VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, Lve_Swap_Chain::MAX_FRAMES_IN_FLIGHT + MAX_LEVELS)
+			.build();
+		createLevelViews();
+		writeLevelDescriptors();
+	}
+
+	void LveDepthPyramid::createPipeline()
+	{
+		// Layouts as the shader declares them, shared with every other pyramid through the layout cache
+		LveShaderReflection reflection = lveDevice.getShaderCache().acquire("./Shaders/depth_pyramid.comp.spv")->getReflection();
+		auto pushConstantRanges = reflection.getPushConstantRanges();
+		assert(pushConstantRanges.size() == 1 && pushConstantRanges[0].size == sizeof(PyramidPushConstantData) && "PyramidPushConstantData does not match depth_pyramid.comp");
+
+		auto& layoutCache = lveDevice.getLayoutCache();
+		setLayout = &layoutCache.getDescriptorSetLayout(reflection.getSetBindings(0));
+		pipelineLayout = layoutCache.getPipelineLayout({ setLayout->getDescriptorSetLayout() }, pushConstantRanges);
+
+		pipeline = std::make_unique<ComputePipeline>(lveDevice, "./Shaders/depth_pyramid.comp.spv", pipelineLayout);
+
+		// Texels are fetched directly, the sampler only exists because the descriptor type needs one
+		VkSamplerCreateInfo samplerInfo{};
+		samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+		samplerInfo.magFilter = VK_FILTER_NEAREST;
+		samplerInfo.minFilter = VK_FILTER_NEAREST;
+		samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+		samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+		samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+		samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+		samplerInfo.minLod = 0.0f;
+		samplerInfo.maxLod = static_cast<float>(MAX_LEVELS);
+
+		if (vkCreateSampler(lveDevice.device(), &samplerInfo, nullptr, &sampler) != VK_SUCCESS)
+		{
+			throw std::runtime_error("failed to create depth pyramid sampler");
+		}
+	}
+
+	void LveDepthPyramid::createPlaceholder()
+	{
+		VkImageCreateInfo imageInfo{};
+		imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+		imageInfo.imageType = VK_IMAGE_TYPE_2D;
+		imageInfo.extent.width = 1;
+		imageInfo.extent.height = 1;
+		imageInfo.extent.depth = 1;
+		imageInfo.mipLevels = 1;
+		imageInfo.arrayLayers = 1;
+		imageInfo.format = VK_FORMAT_R32_SFLOAT;
+		imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+		imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+		imageInfo.usage = VK_IMAGE_USAGE_SAMPLED_BIT;
+		imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+		imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+		imageInfo.flags = 0;
+
+		lveDevice.createImageWithInfo(imageInfo, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, placeholderImage, placeholderMemory);
+
+		VkImageViewCreateInfo viewInfo{};
+		viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+		viewInfo.image = placeholderImage;
+		viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+		viewInfo.format = VK_FORMAT_R32_SFLOAT;
+		viewInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		viewInfo.subresourceRange.baseMipLevel = 0;
+		viewInfo.subresourceRange.levelCount = 1;
+		viewInfo.subresourceRange.baseArrayLayer = 0;
+		viewInfo.subresourceRange.layerCount = 1;
+
+		if (vkCreateImageView(lveDevice.device(), &viewInfo, nullptr, &placeholderView) != VK_SUCCESS)
+		{
+			throw std::runtime_error("failed to create depth pyramid placeholder view");
+		}
+
+		// Never read, it only has to be in the layout the descriptors claim
+		VkImageMemoryBarrier barrier{};
+		barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+		barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+		barrier.newLayout = VK_IMAGE_LAYOUT_GENERAL;
+		barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.image = placeholderImage;
+		barrier.subresourceRange = viewInfo.subresourceRange;
+		barrier.srcAccessMask = 0;
+		barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+
+		VkCommandBuffer commandBuffer = lveDevice.beginSingleTimeCommands();
+		vkCmdPipelineBarrier(
+			commandBuffer,
+			VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+			VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+			0, 0, nullptr, 0, nullptr, 1, &barrier);
+		lveDevice.endSingleTimeCommands(commandBuffer);
+	}
+
+	void LveDepthPyramid::createLevelViews()
+	{
+		VkImageViewCreateInfo viewInfo{};
+		viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+		viewInfo.image = image;
+		viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+		viewInfo.format = VK_FORMAT_R32_SFLOAT;
+		viewInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		viewInfo.subresourceRange.levelCount = 1;
+		viewInfo.subresourceRange.baseArrayLayer = 0;
+		viewInfo.subresourceRange.layerCount = 1;
+
+		levelViews.resize(levelCount);
+		for (uint32_t level = 0; level < levelCount; level++)
+		{
+			viewInfo.subresourceRange.baseMipLevel = level;
+			if (vkCreateImageView(lveDevice.device(), &viewInfo, nullptr, &levelViews[level]) != VK_SUCCESS)
+			{
+				throw std::runtime_error("failed to create depth pyramid level view");
+			}
+		}
+	}
+
+	void LveDepthPyramid::retireLevelViews()
+	{
+		VkDevice device = lveDevice.device();
+		std::shared_ptr<LveDescriptorPool> retiredPool = std::move(pool);
+		lveDevice.getDeletionQueue().push([device, views = levelViews, retiredPool]() mutable
+		{
+			for (auto levelView : views)
+			{
+				vkDestroyImageView(device, levelView, nullptr);
+			}
+			// Frees the descriptor sets that point at the views
+			retiredPool.reset();
+		});
+
+		levelViews.clear();
+		depthDescriptorSets.clear();
+		levelDescriptorSets.clear();
+	}
+
+	void LveDepthPyramid::writeLevelDescriptors()
+	{
+		depthDescriptorSets.resize(Lve_Swap_Chain::MAX_FRAMES_IN_FLIGHT);
+		for (auto& descriptorSet : depthDescriptorSets)
+		{
+			// Written in build() once the depth image of the frame is known
+			if (!pool->allocateDescriptor(setLayout->getDescriptorSetLayout(), descriptorSet))
+			{
+				throw std::runtime_error("failed to allocate depth pyramid descriptor set");
+			}
+		}
+
+		levelDescriptorSets.resize(levelCount - 1);
+		for (uint32_t level = 1; level < levelCount; level++)
+		{
+			VkDescriptorImageInfo sourceInfo{ sampler, levelViews[level - 1], VK_IMAGE_LAYOUT_GENERAL };
+			VkDescriptorImageInfo destinationInfo{ VK_NULL_HANDLE, levelViews[level], VK_IMAGE_LAYOUT_GENERAL };
+			LveDescriptorWriter(*setLayout, *pool)
+				.writeImage(0, &sourceInfo)
+				.writeImage(1, &destinationInfo)
+				.build(levelDescriptorSets[level - 1]);
+		}
+	}
+
+	void LveDepthPyramid::build(VkCommandBuffer commandBuffer, int frameIndex, VkImageView depthView)
+	{
+		assert(image != VK_NULL_HANDLE && "Depth pyramid has no image this frame");
+
+		// Safe to rewrite, the last command buffer that used this frame's set has finished
+		VkDescriptorImageInfo depthInfo{ sampler, depthView, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL };
+		VkDescriptorImageInfo levelInfo{ VK_NULL_HANDLE, levelViews[0], VK_IMAGE_LAYOUT_GENERAL };
+		LveDescriptorWriter(*setLayout, *pool)
+			.writeImage(0, &depthInfo)
+			.writeImage(1, &levelInfo)
+			.overwrite(depthDescriptorSets[frameIndex]);
+
+		// The graph already waited for the previous readers of the image and moved it to general layout
+		pipeline->bind(commandBuffer);
+
+		VkMemoryBarrier levelBarrier{};
+		levelBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+		levelBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+		levelBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+
+		VkExtent2D sourceExtent = depthExtent;
+		VkExtent2D levelExtent = pyramidExtent;
+		for (uint32_t level = 0; level < levelCount; level++)
+		{
+			VkDescriptorSet descriptorSet = level == 0 ? depthDescriptorSets[frameIndex] : levelDescriptorSets[level - 1];
+			vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipelineLayout, 0, 1, &descriptorSet, 0, nullptr);
+
+			PyramidPushConstantData push{};
+			push.sourceSize[0] = static_cast<int32_t>(sourceExtent.width);
+			push.sourceSize[1] = static_cast<int32_t>(sourceExtent.height);
+			push.destinationSize[0] = static_cast<int32_t>(levelExtent.width);
+			push.destinationSize[1] = static_cast<int32_t>(levelExtent.height);
+			vkCmdPushConstants(commandBuffer, pipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(PyramidPushConstantData), &push);
+
+			vkCmdDispatch(
+				commandBuffer,
+				(levelExtent.width + PYRAMID_WORKGROUP_SIZE - 1) / PYRAMID_WORKGROUP_SIZE,
+				(levelExtent.height + PYRAMID_WORKGROUP_SIZE - 1) / PYRAMID_WORKGROUP_SIZE,
+				1);
+
+			// The next level reads this one
+			if (level + 1 < levelCount)
+			{
+				vkCmdPipelineBarrier(
+					commandBuffer,
+					VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+					VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+					0, 1, &levelBarrier, 0, nullptr, 0, nullptr);
+			}
+
+			sourceExtent = levelExtent;
+			levelExtent.width = std::max(1u, (levelExtent.width + 1) / 2);
+			levelExtent.height = std::max(1u, (levelExtent.height + 1) / 2);
+		}
+	}
+
+	VkDescriptorImageInfo LveDepthPyramid::descriptorInfo() const
+	{
+		return VkDescriptorImageInfo{ sampler, image != VK_NULL_HANDLE ? imageView : placeholderView, VK_IMAGE_LAYOUT_GENERAL };
+	}
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#include "LveDevice.h"
+#include "LveDescriptor.h"
+#include "LveRenderGraph.h"
+#include "Pipeline.h"
+
+// std
+#include <memory>
+#include <vector>
+
+namespace lve {
+	// Hierarchical Z buffer: a mip chain of the depth attachment where every texel holds the farthest
+	// depth of the texels it covers. Mip 0 is half the depth resolution, so a texel at mip m covers
+	// a 2^(m+1) square of depth pixels.
+	class LveDepthPyramid
+	{
+	public:
+		static constexpr uint32_t MAX_LEVELS = 16;
+
+		explicit LveDepthPyramid(LveDevice& device);
+		~LveDepthPyramid();
+
+		LveDepthPyramid(const LveDepthPyramid&) = delete;
+		LveDepthPyramid& operator=(const LveDepthPyramid&) = delete;
+
+		// Only read by the frame that builds it, so the render graph owns the image as a transient
+		static LveRenderGraph::ImageDesc getImageDesc(VkExtent2D depthExtent);
+
+		// The graph's image for a depth attachment of depthExtent, VK_NULL_HANDLE when no pyramid is built this frame.
+		// Views and descriptor sets of a previous image are destroyed once the frames in flight have finished.
+		void setImage(VkExtent2D depthExtent, VkImage image, VkImageView view);
+
+		// Must be recorded outside of a render pass, with the depth image already in shader read layout and the
+		// pyramid image in general layout. Readers of the finished pyramid are synchronized by the graph.
+		void build(VkCommandBuffer commandBuffer, int frameIndex, VkImageView depthView);
+
+		// A placeholder without an image, descriptor sets binding the pyramid always need a valid one
+		VkDescriptorImageInfo descriptorInfo() const;
+		VkExtent2D getDepthExtent() const { return depthExtent; }
+		uint32_t getLevelCount() const { return levelCount; }
+
+	private:
+		void createPipeline();
+		void createPlaceholder();
+		void createLevelViews();
+		void retireLevelViews();
+		void writeLevelDescriptors();
+
+		LveDevice& lveDevice;
+		VkExtent2D depthExtent{ 0, 0 };
+		VkExtent2D pyramidExtent{ 0, 0 };
+		uint32_t levelCount = 0;
+
+		VkImage image = VK_NULL_HANDLE;  // owned by the render graph
+		VkImageView imageView = VK_NULL_HANDLE;
+		std::vector<VkImageView> levelViews;
+		VkSampler sampler;
+
+		VkImage placeholderImage = VK_NULL_HANDLE;
+		VkDeviceMemory placeholderMemory = VK_NULL_HANDLE;
+		VkImageView placeholderView = VK_NULL_HANDLE;
+
+		std::unique_ptr<ComputePipeline> pipeline;
+		VkPipelineLayout pipelineLayout;  // owned by the layout cache
+
+		LveDescriptorSetLayout* setLayout = nullptr;  // owned by the layout cache
+		std::unique_ptr<LveDescriptorPool> pool;
+		std::vector<VkDescriptorSet> depthDescriptorSets;  // mip 0, one per frame since the depth image changes
+		std::vector<VkDescriptorSet> levelDescriptorSets;  // mip 1 and up, reads the previous mip
+	};
+}
@@ -15,25 +15,32 @@ namespace lve {
         public:
             Builder(LveDevice& lveDevice) : lveDevice{ lveDevice } {}
 
+            // bindingFlags (descriptor indexing) e.g. partially bound, update after bind or a variable count,
+            // which is only allowed on the highest binding of the layout
             Builder& addBinding(
                 uint32_t binding,
                 VkDescriptorType descriptorType,
                 VkShaderStageFlags stageFlags,
-                uint32_t count = 1);
+                uint32_t count = 1,
+                VkDescriptorBindingFlags bindingFlags = 0);
             std::unique_ptr<LveDescriptorSetLayout> build() const;
 
         private:
             LveDevice& lveDevice;
             std::unordered_map<uint32_t, VkDescriptorSetLayoutBinding> bindings{};
+            std::unordered_map<uint32_t, VkDescriptorBindingFlags> bindingFlags{};
         };
 
         LveDescriptorSetLayout(
-            LveDevice& lveDevice, std::unordered_map<uint32_t, VkDescriptorSetLayoutBinding> bindings);
+            LveDevice& lveDevice,
+            std::unordered_map<uint32_t, VkDescriptorSetLayoutBinding> bindings,
+            std::unordered_map<uint32_t, VkDescriptorBindingFlags> bindingFlags = {});
         ~LveDescriptorSetLayout();
         LveDescriptorSetLayout(const LveDescriptorSetLayout&) = delete;
         LveDescriptorSetLayout& operator=(const LveDescriptorSetLayout&) = delete;
 
         VkDescriptorSetLayout getDescriptorSetLayout() const { return descriptorSetLayout; }
+        const std::unordered_map<uint32_t, VkDescriptorSetLayoutBinding>& getBindings() const { return bindings; }
 
     private:
         LveDevice& lveDevice;
@@ -72,6 +79,11 @@ namespace lve {
 
         bool allocateDescriptor(
             const VkDescriptorSetLayout descriptorSetLayout, VkDescriptorSet& descriptor) const;
+        // For layouts whose last binding has a variable descriptor count, sets the count of that binding
+        bool allocateDescriptor(
+            const VkDescriptorSetLayout descriptorSetLayout,
+            VkDescriptorSet& descriptor,
+            uint32_t variableDescriptorCount) const;
 
         void freeDescriptors(std::vector<VkDescriptorSet>& descriptors) const;
 
@@ -90,6 +102,9 @@ namespace lve {
 
         LveDescriptorWriter& writeBuffer(uint32_t binding, VkDescriptorBufferInfo* bufferInfo);
         LveDescriptorWriter& writeImage(uint32_t binding, VkDescriptorImageInfo* imageInfo);
+        // Single element of an array binding
+        LveDescriptorWriter& writeBuffer(uint32_t binding, uint32_t arrayElement, VkDescriptorBufferInfo* bufferInfo);
+        LveDescriptorWriter& writeImage(uint32_t binding, uint32_t arrayElement, VkDescriptorImageInfo* imageInfo);
 
         bool build(VkDescriptorSet& set);
         void overwrite(VkDescriptorSet& set);
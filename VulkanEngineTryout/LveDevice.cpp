@@ -1,7 +1,10 @@
 #include "LveDevice.h"
 
 // std headers
+#include <cassert>
 #include <cstring>
+#include <filesystem>
+#include <fstream>
 #include <iostream>
 #include <set>
 #include <unordered_set>
@@ -55,9 +58,17 @@ namespace lve {
         pickPhysicalDevice();
         createLogicalDevice();
         createCommandPool();
+        createPipelineCache();
     }
 
     LveDevice::~LveDevice() {
+        vkDeviceWaitIdle(device_);
+        deletionQueue.flush();
+        layoutCache.clear();
+        graphicsTimeline.reset();
+
+        savePipelineCache();
+        vkDestroyPipelineCache(device_, pipelineCache_, nullptr);
         vkDestroyCommandPool(device_, commandPool, nullptr);
         vkDestroyDevice(device_, nullptr);
 
@@ -80,7 +91,7 @@ namespace lve {
         appInfo.applicationVersion = VK_MAKE_VERSION(1, 0, 0);
         appInfo.pEngineName = "No Engine";
         appInfo.engineVersion = VK_MAKE_VERSION(1, 0, 0);
-        appInfo.apiVersion = VK_API_VERSION_1_0;
+        appInfo.apiVersion = VK_API_VERSION_1_2;
 
         VkInstanceCreateInfo createInfo = {};
         createInfo.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
@@ -142,7 +153,69 @@ namespace lve {
         }
 
         vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+        vkGetPhysicalDeviceFeatures(physicalDevice, &features);
         std::cout << "physical device: " << properties.deviceName << std::endl;
+
+        features12 = {};
+        features12.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+        properties12 = {};
+        properties12.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_PROPERTIES;
+        synchronization2 = false;
+        graphicsPipelineLibrary = false;
+        presentWait = false;
+        memoryBudget = isDeviceExtensionAvailable(physicalDevice, VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+        if (properties.apiVersion >= VK_API_VERSION_1_2) {
+            VkPhysicalDeviceSynchronization2FeaturesKHR synchronization2Features{};
+            synchronization2Features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SYNCHRONIZATION_2_FEATURES_KHR;
+            VkPhysicalDeviceGraphicsPipelineLibraryFeaturesEXT graphicsPipelineLibraryFeatures{};
+            graphicsPipelineLibraryFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_GRAPHICS_PIPELINE_LIBRARY_FEATURES_EXT;
+            VkPhysicalDevicePresentIdFeaturesKHR presentIdFeatures{};
+            presentIdFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_ID_FEATURES_KHR;
+            VkPhysicalDevicePresentWaitFeaturesKHR presentWaitFeatures{};
+            presentWaitFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_WAIT_FEATURES_KHR;
+
+            VkPhysicalDeviceFeatures2 features2{};
+            features2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+            features2.pNext = &features12;
+            // only extensions the device exposes may be chained
+            void** next = &features12.pNext;
+            if (isDeviceExtensionAvailable(physicalDevice, VK_KHR_SYNCHRONIZATION_2_EXTENSION_NAME)) {
+                *next = &synchronization2Features;
+                next = &synchronization2Features.pNext;
+            }
+            if (isDeviceExtensionAvailable(physicalDevice, VK_KHR_PIPELINE_LIBRARY_EXTENSION_NAME) &&
+                isDeviceExtensionAvailable(physicalDevice, VK_EXT_GRAPHICS_PIPELINE_LIBRARY_EXTENSION_NAME)) {
+                *next = &graphicsPipelineLibraryFeatures;
+                next = &graphicsPipelineLibraryFeatures.pNext;
+            }
+            if (!isHeadless() &&
+                isDeviceExtensionAvailable(physicalDevice, VK_KHR_PRESENT_ID_EXTENSION_NAME) &&
+                isDeviceExtensionAvailable(physicalDevice, VK_KHR_PRESENT_WAIT_EXTENSION_NAME)) {
+                *next = &presentIdFeatures;
+                presentIdFeatures.pNext = &presentWaitFeatures;
+                next = &presentWaitFeatures.pNext;
+            }
+            vkGetPhysicalDeviceFeatures2(physicalDevice, &features2);
+            features12.pNext = nullptr;
+
+            VkPhysicalDeviceProperties2 properties2{};
+            properties2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+            properties2.pNext = &properties12;
+            vkGetPhysicalDeviceProperties2(physicalDevice, &properties2);
+            properties12.pNext = nullptr;
+
+            synchronization2 = synchronization2Features.synchronization2 == VK_TRUE;
+            graphicsPipelineLibrary = graphicsPipelineLibraryFeatures.graphicsPipelineLibrary == VK_TRUE;
+            presentWait = presentIdFeatures.presentId == VK_TRUE && presentWaitFeatures.presentWait == VK_TRUE;
+        }
+        // Frame pacing is built on them, core and required since Vulkan 1.2
+        if (features12.timelineSemaphore != VK_TRUE) {
+            throw std::runtime_error("GPU does not support timeline semaphores!");
+        }
+        std::cout << "synchronization2: " << (synchronization2 ? "yes" : "no") << std::endl;
+        std::cout << "graphics pipeline library: " << (graphicsPipelineLibrary ? "yes" : "no") << std::endl;
+        std::cout << "present wait: " << (presentWait ? "yes" : "no") << std::endl;
+        std::cout << "memory budget: " << (memoryBudget ? "yes" : "no") << std::endl;
     }
 
     void LveDevice::createLogicalDevice() {
@@ -163,6 +236,9 @@ namespace lve {
 
         VkPhysicalDeviceFeatures deviceFeatures = {};
         deviceFeatures.samplerAnisotropy = VK_TRUE;
+        // optional, used by the indirect draw path when available
+        deviceFeatures.multiDrawIndirect = features.multiDrawIndirect;
+        deviceFeatures.drawIndirectFirstInstance = features.drawIndirectFirstInstance;
 
         VkDeviceCreateInfo createInfo = {};
         createInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
@@ -171,8 +247,65 @@ namespace lve {
         createInfo.pQueueCreateInfos = queueCreateInfos.data();
 
         createInfo.pEnabledFeatures = &deviceFeatures;
-        createInfo.enabledExtensionCount = static_cast<uint32_t>(deviceExtensions.size());
-        createInfo.ppEnabledExtensionNames = deviceExtensions.data();
+
+        // optional Vulkan 1.2 features, only chained when the device supports 1.2
+        VkPhysicalDeviceVulkan12Features enabledFeatures12{};
+        enabledFeatures12.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+        enabledFeatures12.drawIndirectCount = features12.drawIndirectCount;
+        enabledFeatures12.timelineSemaphore = VK_TRUE;
+        // descriptor indexing, used by the bindless registry
+        enabledFeatures12.descriptorIndexing = features12.descriptorIndexing;
+        enabledFeatures12.runtimeDescriptorArray = features12.runtimeDescriptorArray;
+        enabledFeatures12.shaderSampledImageArrayNonUniformIndexing = features12.shaderSampledImageArrayNonUniformIndexing;
+        enabledFeatures12.shaderStorageBufferArrayNonUniformIndexing = features12.shaderStorageBufferArrayNonUniformIndexing;
+        enabledFeatures12.descriptorBindingPartiallyBound = features12.descriptorBindingPartiallyBound;
+        enabledFeatures12.descriptorBindingVariableDescriptorCount = features12.descriptorBindingVariableDescriptorCount;
+        enabledFeatures12.descriptorBindingUpdateUnusedWhilePending = features12.descriptorBindingUpdateUnusedWhilePending;
+        enabledFeatures12.descriptorBindingSampledImageUpdateAfterBind = features12.descriptorBindingSampledImageUpdateAfterBind;
+        enabledFeatures12.descriptorBindingStorageBufferUpdateAfterBind = features12.descriptorBindingStorageBufferUpdateAfterBind;
+        if (properties.apiVersion >= VK_API_VERSION_1_2) {
+            createInfo.pNext = &enabledFeatures12;
+        }
+
+        // optional extensions, only enabled when the feature was found in pickPhysicalDevice
+        std::vector<const char*> enabledExtensions = getRequiredDeviceExtensions();
+        VkPhysicalDeviceSynchronization2FeaturesKHR enabledSynchronization2{};
+        enabledSynchronization2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SYNCHRONIZATION_2_FEATURES_KHR;
+        enabledSynchronization2.synchronization2 = VK_TRUE;
+        VkPhysicalDeviceGraphicsPipelineLibraryFeaturesEXT enabledGraphicsPipelineLibrary{};
+        enabledGraphicsPipelineLibrary.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_GRAPHICS_PIPELINE_LIBRARY_FEATURES_EXT;
+        enabledGraphicsPipelineLibrary.graphicsPipelineLibrary = VK_TRUE;
+        VkPhysicalDevicePresentIdFeaturesKHR enabledPresentId{};
+        enabledPresentId.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_ID_FEATURES_KHR;
+        enabledPresentId.presentId = VK_TRUE;
+        VkPhysicalDevicePresentWaitFeaturesKHR enabledPresentWait{};
+        enabledPresentWait.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_WAIT_FEATURES_KHR;
+        enabledPresentWait.presentWait = VK_TRUE;
+        void** next = &enabledFeatures12.pNext;
+        if (synchronization2) {
+            enabledExtensions.push_back(VK_KHR_SYNCHRONIZATION_2_EXTENSION_NAME);
+            *next = &enabledSynchronization2;
+            next = &enabledSynchronization2.pNext;
+        }
+        if (graphicsPipelineLibrary) {
+            enabledExtensions.push_back(VK_KHR_PIPELINE_LIBRARY_EXTENSION_NAME);
+            enabledExtensions.push_back(VK_EXT_GRAPHICS_PIPELINE_LIBRARY_EXTENSION_NAME);
+            *next = &enabledGraphicsPipelineLibrary;
+            next = &enabledGraphicsPipelineLibrary.pNext;
+        }
+        if (presentWait) {
+            enabledExtensions.push_back(VK_KHR_PRESENT_ID_EXTENSION_NAME);
+            enabledExtensions.push_back(VK_KHR_PRESENT_WAIT_EXTENSION_NAME);
+            *next = &enabledPresentId;
+            enabledPresentId.pNext = &enabledPresentWait;
+            next = &enabledPresentWait.pNext;
+        }
+        if (memoryBudget) {
+            enabledExtensions.push_back(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+        }
+
+        createInfo.enabledExtensionCount = static_cast<uint32_t>(enabledExtensions.size());
+        createInfo.ppEnabledExtensionNames = enabledExtensions.data();
 
         // might not really be necessary anymore because device specific validation layers
         // have been deprecated
@@ -190,6 +323,54 @@ namespace lve {
 
         vkGetDeviceQueue(device_, indices.graphicsFamily, 0, &graphicsQueue_);
         vkGetDeviceQueue(device_, indices.presentFamily, 0, &presentQueue_);
+
+        if (synchronization2) {
+            cmdPipelineBarrier2KHR = (PFN_vkCmdPipelineBarrier2KHR)vkGetDeviceProcAddr(device_, "vkCmdPipelineBarrier2KHR");
+            queueSubmit2KHR = (PFN_vkQueueSubmit2KHR)vkGetDeviceProcAddr(device_, "vkQueueSubmit2KHR");
+            synchronization2 = cmdPipelineBarrier2KHR != nullptr && queueSubmit2KHR != nullptr;
+            if (!synchronization2) {
+                queueSubmit2KHR = nullptr;
+            }
+        }
+
+        if (presentWait) {
+            waitForPresentKHR = (PFN_vkWaitForPresentKHR)vkGetDeviceProcAddr(device_, "vkWaitForPresentKHR");
+            presentWait = waitForPresentKHR != nullptr;
+        }
+
+        graphicsTimeline = std::make_unique<LveQueueTimeline>(device_, graphicsQueue_, queueSubmit2KHR);
+    }
+
+    void LveDevice::cmdPipelineBarrier2(VkCommandBuffer commandBuffer, const VkDependencyInfoKHR& dependencyInfo) {
+        assert(cmdPipelineBarrier2KHR != nullptr && "synchronization2 is not enabled");
+        cmdPipelineBarrier2KHR(commandBuffer, &dependencyInfo);
+    }
+
+    VkResult LveDevice::waitForPresent(VkSwapchainKHR swapChain, uint64_t presentId, uint64_t timeout) {
+        assert(waitForPresentKHR != nullptr && "present wait is not enabled");
+        return waitForPresentKHR(device_, swapChain, presentId, timeout);
+    }
+
+    LveDevice::MemoryUsage LveDevice::getMemoryUsage() {
+        MemoryUsage memoryUsage{};
+        if (!memoryBudget) {
+            return memoryUsage;
+        }
+
+        VkPhysicalDeviceMemoryBudgetPropertiesEXT budgetProperties{};
+        budgetProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_BUDGET_PROPERTIES_EXT;
+        VkPhysicalDeviceMemoryProperties2 memProperties{};
+        memProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_PROPERTIES_2;
+        memProperties.pNext = &budgetProperties;
+        vkGetPhysicalDeviceMemoryProperties2(physicalDevice, &memProperties);
+
+        for (uint32_t i = 0; i < memProperties.memoryProperties.memoryHeapCount; i++) {
+            if (memProperties.memoryProperties.memoryHeaps[i].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT) {
+                memoryUsage.usage += budgetProperties.heapUsage[i];
+                memoryUsage.budget += budgetProperties.heapBudget[i];
+            }
+        }
+        return memoryUsage;
     }
 
     void LveDevice::createCommandPool() {
@@ -206,15 +387,94 @@ namespace lve {
         }
     }
 
-    void LveDevice::createSurface() { window.createWindowSurface(instance, &surface_); }
+    void LveDevice::createPipelineCache() {
+        std::vector<char> data;
+        std::ifstream file{ PIPELINE_CACHE_PATH, std::ios::ate | std::ios::binary };
+        if (file.is_open()) {
+            data.resize(static_cast<size_t>(file.tellg()));
+            file.seekg(0);
+            file.read(data.data(), data.size());
+            if (!file || !isPipelineCacheCompatible(data)) {
+                std::cout << "pipeline cache: discarding " << PIPELINE_CACHE_PATH << std::endl;
+                data.clear();
+            }
+        }
+
+        VkPipelineCacheCreateInfo cacheInfo{};
+        cacheInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+        cacheInfo.initialDataSize = data.size();
+        cacheInfo.pInitialData = data.empty() ? nullptr : data.data();
+
+        if (vkCreatePipelineCache(device_, &cacheInfo, nullptr, &pipelineCache_) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create pipeline cache!");
+        }
+
+        pipelineCacheWarm = !data.empty();
+        std::cout << "pipeline cache: " << (pipelineCacheWarm ? "warm, " : "cold, ") << data.size() << " bytes" << std::endl;
+    }
+
+    // Drivers are supposed to reject foreign data themselves, not all of them do
+    bool LveDevice::isPipelineCacheCompatible(const std::vector<char>& data) {
+        VkPipelineCacheHeaderVersionOne header;
+        if (data.size() < sizeof(header)) {
+            return false;
+        }
+        std::memcpy(&header, data.data(), sizeof(header));
+
+        return header.headerSize >= sizeof(header) &&
+            header.headerSize <= data.size() &&
+            header.headerVersion == VK_PIPELINE_CACHE_HEADER_VERSION_ONE &&
+            header.vendorID == properties.vendorID &&
+            header.deviceID == properties.deviceID &&
+            std::memcmp(header.pipelineCacheUUID, properties.pipelineCacheUUID, VK_UUID_SIZE) == 0;
+    }
+
+    // Written next to the cache and renamed over it, so a crash never leaves a truncated cache behind
+    void LveDevice::savePipelineCache() {
+        size_t size = 0;
+        if (vkGetPipelineCacheData(device_, pipelineCache_, &size, nullptr) != VK_SUCCESS || size == 0) {
+            return;
+        }
+        std::vector<char> data(size);
+        if (vkGetPipelineCacheData(device_, pipelineCache_, &size, data.data()) != VK_SUCCESS) {
+            return;
+        }
+
+        std::string temporaryPath = std::string{ PIPELINE_CACHE_PATH } + ".tmp";
+        {
+            std::ofstream file{ temporaryPath, std::ios::binary | std::ios::trunc };
+            file.write(data.data(), size);
+            file.close();
+            if (!file) {
+                std::cout << "pipeline cache: failed to write " << temporaryPath << std::endl;
+                std::error_code ignored;
+                std::filesystem::remove(temporaryPath, ignored);
+                return;
+            }
+        }
+
+        std::error_code error;
+        std::filesystem::rename(temporaryPath, PIPELINE_CACHE_PATH, error);
+        if (error) {
+            std::cout << "pipeline cache: failed to replace " << PIPELINE_CACHE_PATH << ": " << error.message() << std::endl;
+            std::filesystem::remove(temporaryPath, error);
+        }
+    }
+
+    void LveDevice::createSurface() {
+        if (!isHeadless()) {
+            window.createWindowSurface(instance, &surface_);
+        }
+    }
 
     bool LveDevice::isDeviceSuitable(VkPhysicalDevice device) {
         QueueFamilyIndices indices = findQueueFamilies(device);
 
         bool extensionsSupported = checkDeviceExtensionSupport(device);
 
-        bool swapChainAdequate = false;
-        if (extensionsSupported) {
+        // Headless rendering goes to offscreen images
+        bool swapChainAdequate = isHeadless();
+        if (extensionsSupported && !isHeadless()) {
             SwapChainSupportDetails swapChainSupport = querySwapChainSupport(device);
             swapChainAdequate = !swapChainSupport.formats.empty() && !swapChainSupport.presentModes.empty();
         }
@@ -275,8 +535,10 @@ namespace lve {
 
     std::vector<const char*> LveDevice::getRequiredExtensions() {
         uint32_t glfwExtensionCount = 0;
-        const char** glfwExtensions;
-        glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
+        const char** glfwExtensions = nullptr;
+        if (!isHeadless()) {
+            glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
+        }
 
         std::vector<const char*> extensions(glfwExtensions, glfwExtensions + glfwExtensionCount);
 
@@ -321,6 +583,7 @@ namespace lve {
             &extensionCount,
             availableExtensions.data());
 
+        auto deviceExtensions = getRequiredDeviceExtensions();
         std::set<std::string> requiredExtensions(deviceExtensions.begin(), deviceExtensions.end());
 
         for (const auto& extension : availableExtensions) {
@@ -330,6 +593,28 @@ namespace lve {
         return requiredExtensions.empty();
     }
 
+    std::vector<const char*> LveDevice::getRequiredDeviceExtensions() const {
+        if (isHeadless()) {
+            return {};
+        }
+        return deviceExtensions;
+    }
+
+    bool LveDevice::isDeviceExtensionAvailable(VkPhysicalDevice device, const char* extensionName) {
+        uint32_t extensionCount;
+        vkEnumerateDeviceExtensionProperties(device, nullptr, &extensionCount, nullptr);
+
+        std::vector<VkExtensionProperties> availableExtensions(extensionCount);
+        vkEnumerateDeviceExtensionProperties(device, nullptr, &extensionCount, availableExtensions.data());
+
+        for (const auto& extension : availableExtensions) {
+            if (strcmp(extension.extensionName, extensionName) == 0) {
+                return true;
+            }
+        }
+        return false;
+    }
+
     QueueFamilyIndices LveDevice::findQueueFamilies(VkPhysicalDevice device) {
         QueueFamilyIndices indices;
 
@@ -345,8 +630,14 @@ namespace lve {
                 indices.graphicsFamily = i;
                 indices.graphicsFamilyHasValue = true;
             }
+            // Nothing is presented headless, the graphics queue stands in for the present queue
             VkBool32 presentSupport = false;
-            vkGetPhysicalDeviceSurfaceSupportKHR(device, i, surface_, &presentSupport);
+            if (isHeadless()) {
+                presentSupport = indices.graphicsFamilyHasValue && indices.graphicsFamily == static_cast<uint32_t>(i);
+            }
+            else {
+                vkGetPhysicalDeviceSurfaceSupportKHR(device, i, surface_, &presentSupport);
+            }
             if (queueFamily.queueCount > 0 && presentSupport) {
                 indices.presentFamily = i;
                 indices.presentFamilyHasValue = true;
@@ -469,13 +760,8 @@ namespace lve {
     void LveDevice::endSingleTimeCommands(VkCommandBuffer commandBuffer) {
         vkEndCommandBuffer(commandBuffer);
 
-        VkSubmitInfo submitInfo{};
-        submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-        submitInfo.commandBufferCount = 1;
-        submitInfo.pCommandBuffers = &commandBuffer;
-
-        vkQueueSubmit(graphicsQueue_, 1, &submitInfo, VK_NULL_HANDLE);
-        vkQueueWaitIdle(graphicsQueue_);
+        // Only waits for this submission, not for the frames in flight before it
+        graphicsTimeline->wait(graphicsTimeline->submit({ commandBuffer }));
 
         vkFreeCommandBuffers(device_, commandPool, 1, &commandBuffer);
     }
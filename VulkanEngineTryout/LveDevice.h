@@ -1,8 +1,13 @@
 #pragma once
 
 #include "LveWindow.h"
+#include "LveDeletionQueue.h"
+#include "LveShaderCache.h"
+#include "LveLayoutCache.h"
+#include "LveQueueTimeline.h"
 
 // std lib headers
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -41,9 +46,24 @@ class LveDevice {
 
   VkCommandPool getCommandPool() { return commandPool; }
   VkDevice device() { return device_; }
+  // VK_NULL_HANDLE when headless
   VkSurfaceKHR surface() { return surface_; }
+  // No surface, no present queue and no swap chain extension, see LveWindow
+  bool isHeadless() const { return window.isHeadless(); }
   VkQueue graphicsQueue() { return graphicsQueue_; }
   VkQueue presentQueue() { return presentQueue_; }
+  // Shared by every pipeline, loaded from and saved to PIPELINE_CACHE_PATH
+  VkPipelineCache pipelineCache() { return pipelineCache_; }
+  // True when the cache started from data of a previous run on the same device and driver
+  bool isPipelineCacheWarm() const { return pipelineCacheWarm; }
+  // Every submission to the graphics queue goes through this, its values order all GPU work
+  LveQueueTimeline& getGraphicsTimeline() { return *graphicsTimeline; }
+  // Objects released while frames are in flight, advanced by LveRenderer
+  LveDeletionQueue& getDeletionQueue() { return deletionQueue; }
+  // Shader modules shared between pipelines
+  LveShaderCache& getShaderCache() { return shaderCache; }
+  // Descriptor set and pipeline layouts shared between systems
+  LveLayoutCache& getLayoutCache() { return layoutCache; }
 
   SwapChainSupportDetails getSwapChainSupport() { return querySwapChainSupport(physicalDevice); }
   uint32_t findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties);
@@ -70,7 +90,31 @@ class LveDevice {
       VkImage &image,
       VkDeviceMemory &imageMemory);
 
+  // Records through vkCmdPipelineBarrier2KHR, only valid when synchronization2 is set
+  void cmdPipelineBarrier2(VkCommandBuffer commandBuffer, const VkDependencyInfoKHR &dependencyInfo);
+  // vkWaitForPresentKHR, only valid when presentWait is set
+  VkResult waitForPresent(VkSwapchainKHR swapChain, uint64_t presentId, uint64_t timeout);
+
+  struct MemoryUsage {
+    VkDeviceSize usage = 0;
+    VkDeviceSize budget = 0;
+  };
+  // Summed over the device local heaps, includes other processes' allocations. All zero without memoryBudget.
+  MemoryUsage getMemoryUsage();
+
   VkPhysicalDeviceProperties properties;
+  VkPhysicalDeviceFeatures features;
+  VkPhysicalDeviceVulkan12Features features12{};
+  // Zero unless the device supports Vulkan 1.2
+  VkPhysicalDeviceVulkan12Properties properties12{};
+  // VK_KHR_synchronization2, optional
+  bool synchronization2 = false;
+  // VK_EXT_graphics_pipeline_library, optional
+  bool graphicsPipelineLibrary = false;
+  // VK_KHR_present_id and VK_KHR_present_wait, optional
+  bool presentWait = false;
+  // VK_EXT_memory_budget, optional
+  bool memoryBudget = false;
 
  private:
   void createInstance();
@@ -79,6 +123,8 @@ class LveDevice {
   void pickPhysicalDevice();
   void createLogicalDevice();
   void createCommandPool();
+  void createPipelineCache();
+  void savePipelineCache();
 
   // helper functions
   bool isDeviceSuitable(VkPhysicalDevice device);
@@ -88,6 +134,9 @@ class LveDevice {
   void populateDebugMessengerCreateInfo(VkDebugUtilsMessengerCreateInfoEXT &createInfo);
   void hasGflwRequiredInstanceExtensions();
   bool checkDeviceExtensionSupport(VkPhysicalDevice device);
+  std::vector<const char *> getRequiredDeviceExtensions() const;
+  bool isDeviceExtensionAvailable(VkPhysicalDevice device, const char *extensionName);
+  bool isPipelineCacheCompatible(const std::vector<char> &data);
   SwapChainSupportDetails querySwapChainSupport(VkPhysicalDevice device);
 
   VkInstance instance;
@@ -97,12 +146,23 @@ class LveDevice {
   VkCommandPool commandPool;
 
   VkDevice device_;
-  VkSurfaceKHR surface_;
+  VkSurfaceKHR surface_ = VK_NULL_HANDLE;
   VkQueue graphicsQueue_;
   VkQueue presentQueue_;
+  PFN_vkCmdPipelineBarrier2KHR cmdPipelineBarrier2KHR = nullptr;
+  PFN_vkQueueSubmit2KHR queueSubmit2KHR = nullptr;
+  PFN_vkWaitForPresentKHR waitForPresentKHR = nullptr;
+  std::unique_ptr<LveQueueTimeline> graphicsTimeline;
+  VkPipelineCache pipelineCache_ = VK_NULL_HANDLE;
+  bool pipelineCacheWarm = false;
+
+  LveDeletionQueue deletionQueue;
+  LveShaderCache shaderCache{*this};
+  LveLayoutCache layoutCache{*this};
 
   const std::vector<const char *> validationLayers = {"VK_LAYER_KHRONOS_validation"};
   const std::vector<const char *> deviceExtensions = {VK_KHR_SWAPCHAIN_EXTENSION_NAME};
+  static constexpr const char *PIPELINE_CACHE_PATH = "pipeline_cache.bin";
 };
 
 }  // namespace lve
\ No newline at end of file
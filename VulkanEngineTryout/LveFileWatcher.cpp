@@ -0,0 +1,157 @@
+#include "LveFileWatcher.h"
+
+// std
+#include <algorithm>
+#include <stdexcept>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#elif defined(__linux__)
+#include <cerrno>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+namespace lve {
+
+	namespace {
+		void addUnique(std::vector<std::string>& names, std::string name)
+		{
+			if (std::find(names.begin(), names.end(), name) == names.end())
+			{
+				names.push_back(std::move(name));
+			}
+		}
+	}
+
+#ifdef _WIN32
+	struct LveFileWatcher::PlatformState {
+		HANDLE directory = INVALID_HANDLE_VALUE;
+		OVERLAPPED overlapped{};
+		// FILE_NOTIFY_INFORMATION records are DWORD aligned
+		alignas(DWORD) char buffer[64 * 1024];
+
+		bool read()
+		{
+			return ReadDirectoryChangesW(directory, buffer, sizeof(buffer), FALSE,
+				FILE_NOTIFY_CHANGE_LAST_WRITE | FILE_NOTIFY_CHANGE_FILE_NAME, nullptr, &overlapped, nullptr) != FALSE;
+		}
+	};
+
+	LveFileWatcher::LveFileWatcher(const std::string& directory) : state{ std::make_unique<PlatformState>() }
+	{
+		state->directory = CreateFileA(directory.c_str(), FILE_LIST_DIRECTORY, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+			nullptr, OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED, nullptr);
+		if (state->directory == INVALID_HANDLE_VALUE)
+		{
+			throw std::runtime_error("Failed to watch directory: " + directory);
+		}
+
+		state->overlapped.hEvent = CreateEventA(nullptr, TRUE, FALSE, nullptr);
+		if (state->overlapped.hEvent == nullptr || !state->read())
+		{
+			if (state->overlapped.hEvent != nullptr) CloseHandle(state->overlapped.hEvent);
+			CloseHandle(state->directory);
+			throw std::runtime_error("Failed to watch directory: " + directory);
+		}
+	}
+
+	LveFileWatcher::~LveFileWatcher()
+	{
+		// The kernel writes into buffer until the read is cancelled
+		DWORD bytes = 0;
+		CancelIoEx(state->directory, &state->overlapped);
+		GetOverlappedResult(state->directory, &state->overlapped, &bytes, TRUE);
+		CloseHandle(state->overlapped.hEvent);
+		CloseHandle(state->directory);
+	}
+
+	std::vector<std::string> LveFileWatcher::poll()
+	{
+		std::vector<std::string> names;
+		DWORD bytes = 0;
+		while (GetOverlappedResult(state->directory, &state->overlapped, &bytes, FALSE))
+		{
+			// Zero bytes means the buffer overflowed and the changes are lost
+			for (DWORD offset = 0; bytes != 0;)
+			{
+				auto* info = reinterpret_cast<const FILE_NOTIFY_INFORMATION*>(state->buffer + offset);
+				if (info->Action == FILE_ACTION_ADDED || info->Action == FILE_ACTION_MODIFIED || info->Action == FILE_ACTION_RENAMED_NEW_NAME)
+				{
+					int length = static_cast<int>(info->FileNameLength / sizeof(WCHAR));
+					int size = WideCharToMultiByte(CP_UTF8, 0, info->FileName, length, nullptr, 0, nullptr, nullptr);
+					std::string name(size, '\0');
+					WideCharToMultiByte(CP_UTF8, 0, info->FileName, length, name.data(), size, nullptr, nullptr);
+					addUnique(names, std::move(name));
+				}
+				if (info->NextEntryOffset == 0) break;
+				offset += info->NextEntryOffset;
+			}
+
+			ResetEvent(state->overlapped.hEvent);
+			if (!state->read()) break;
+		}
+		return names;
+	}
+#elif defined(__linux__)
+	struct LveFileWatcher::PlatformState {
+		int descriptor = -1;
+	};
+
+	LveFileWatcher::LveFileWatcher(const std::string& directory) : state{ std::make_unique<PlatformState>() }
+	{
+		state->descriptor = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+		// Editors either write in place or write a temporary file and move it over the original
+		if (state->descriptor < 0 || inotify_add_watch(state->descriptor, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO) < 0)
+		{
+			if (state->descriptor >= 0) close(state->descriptor);
+			throw std::runtime_error("Failed to watch directory: " + directory);
+		}
+	}
+
+	LveFileWatcher::~LveFileWatcher()
+	{
+		close(state->descriptor);
+	}
+
+	std::vector<std::string> LveFileWatcher::poll()
+	{
+		std::vector<std::string> names;
+		alignas(inotify_event) char buffer[16 * 1024];
+		for (;;)
+		{
+			ssize_t bytes = read(state->descriptor, buffer, sizeof(buffer));
+			if (bytes <= 0) break;  // EAGAIN once every event has been read
+
+			for (ssize_t offset = 0; offset < bytes;)
+			{
+				auto* event = reinterpret_cast<const inotify_event*>(buffer + offset);
+				if (event->len != 0)
+				{
+					addUnique(names, event->name);
+				}
+				offset += sizeof(inotify_event) + event->len;
+			}
+		}
+		return names;
+	}
+#else
+	struct LveFileWatcher::PlatformState {
+	};
+
+	LveFileWatcher::LveFileWatcher(const std::string& directory) : state{ std::make_unique<PlatformState>() }
+	{
+	}
+
+	LveFileWatcher::~LveFileWatcher()
+	{
+	}
+
+	std::vector<std::string> LveFileWatcher::poll()
+	{
+		return {};
+	}
+#endif
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+// std
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace lve {
+
+	// Reports files of one directory (not its subdirectories) that were written or moved into it.
+	// Polled, never blocks. inotify on Linux, ReadDirectoryChangesW on Windows, nothing elsewhere.
+	class LveFileWatcher
+	{
+	public:
+		// Throws std::runtime_error when the directory cannot be watched
+		explicit LveFileWatcher(const std::string& directory);
+		~LveFileWatcher();
+
+		LveFileWatcher(const LveFileWatcher&) = delete;
+		LveFileWatcher& operator=(const LveFileWatcher&) = delete;
+
+		// Names relative to the directory, each file once however often it changed since the last call
+		std::vector<std::string> poll();
+
+	private:
+		struct PlatformState;
+
+		std::unique_ptr<PlatformState> state;
+	};
+}
@@ -0,0 +1,30 @@
+#include "LveFixedTimestep.h"
+
+// std
+#include <cassert>
+
+namespace lve {
+
+	LveFixedTimestep::LveFixedTimestep(float stepSeconds, uint32_t maxStepsPerFrame) : step{ stepSeconds }, maxStepsPerFrame{ maxStepsPerFrame }
+	{
+		assert(stepSeconds > 0.0f && maxStepsPerFrame > 0 && "Fixed timestep needs a positive step and at least one step per frame");
+	}
+
+	uint32_t LveFixedTimestep::advance(float frameTime)
+	{
+		accumulator += frameTime;
+
+		uint32_t steps = 0;
+		while (accumulator >= step && steps < maxStepsPerFrame)
+		{
+			accumulator -= step;
+			steps++;
+		}
+
+		if (accumulator >= step)
+		{
+			accumulator = 0.0f;
+		}
+		return steps;
+	}
+}
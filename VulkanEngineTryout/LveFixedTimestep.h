@@ -0,0 +1,29 @@
+#pragma once
+
+// std
+#include <cstdint>
+
+namespace lve {
+
+	// Accumulates render frame times and hands them out as fixed simulation steps. Fast rendering doesn't
+	// run the simulation more often, slow rendering runs several steps per frame, up to maxStepsPerFrame.
+	// Time beyond that is dropped, so a long stall slows the simulation down instead of making every later
+	// frame catch up.
+	class LveFixedTimestep
+	{
+	public:
+		explicit LveFixedTimestep(float stepSeconds = 1.0f / 60.0f, uint32_t maxStepsPerFrame = 8);
+
+		// Adds the frame time in seconds, returns how many steps to simulate this frame
+		uint32_t advance(float frameTime);
+
+		float getStep() const { return step; }
+		// How far rendering is past the last step, in steps: 0 shows the previous state, 1 the latest one
+		float getAlpha() const { return accumulator / step; }
+
+	private:
+		float step;
+		uint32_t maxStepsPerFrame;
+		float accumulator = 0.0f;
+	};
+}
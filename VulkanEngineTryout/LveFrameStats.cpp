@@ -0,0 +1,152 @@
+#include "LveFrameStats.h"
+
+// std
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <fstream>
+#include <limits>
+#include <stdexcept>
+
+namespace lve {
+
+	LveFrameStats::LveFrameStats()
+	{
+		history.resize(HISTORY_SIZE);
+	}
+
+	float LveFrameStats::beginFrame()
+	{
+		auto now = std::chrono::steady_clock::now();
+		float frameTime = frameCount == 0 ? 0.0f : std::chrono::duration<float, std::chrono::seconds::period>(now - inputTime).count();
+		inputTime = now;
+
+		Frame& frame = history[frameCount % HISTORY_SIZE];
+		frame.number = frameCount;
+		frame.milliseconds.fill(std::numeric_limits<float>::quiet_NaN());
+		frameCount++;
+
+		if (frameCount > 1)
+		{
+			record(Metric::CpuFrame, frameTime * 1000.0f);
+		}
+		return frameTime;
+	}
+
+	void LveFrameStats::record(Metric metric, float milliseconds)
+	{
+		assert(metric != Metric::Count && "Count is not a metric");
+		if (frameCount == 0) return;
+
+		float& value = history[(frameCount - 1) % HISTORY_SIZE].milliseconds[static_cast<size_t>(metric)];
+		value = std::isnan(value) ? milliseconds : value + milliseconds;
+	}
+
+	std::vector<float> LveFrameStats::getSamples(Metric metric) const
+	{
+		std::vector<float> samples;
+		uint64_t frames = std::min<uint64_t>(frameCount, HISTORY_SIZE);
+		samples.reserve(frames);
+		for (uint64_t i = 0; i < frames; i++)
+		{
+			float value = history[i].milliseconds[static_cast<size_t>(metric)];
+			if (!std::isnan(value)) samples.push_back(value);
+		}
+		return samples;
+	}
+
+	float LveFrameStats::getLatest(Metric metric) const
+	{
+		assert(metric != Metric::Count && "Count is not a metric");
+		if (frameCount == 0) return std::numeric_limits<float>::quiet_NaN();
+		return history[(frameCount - 1) % HISTORY_SIZE].milliseconds[static_cast<size_t>(metric)];
+	}
+
+	LveFrameStats::Summary LveFrameStats::getSummary(Metric metric) const
+	{
+		return summarize(getSamples(metric));
+	}
+
+	LveFrameStats::Summary LveFrameStats::summarize(std::vector<float> samples)
+	{
+		Summary summary{};
+		if (samples.empty()) return summary;
+
+		std::sort(samples.begin(), samples.end());
+		// Nearest rank
+		auto percentile = [&](float p) { return samples[static_cast<size_t>(std::ceil(p * samples.size())) - 1]; };
+
+		double sum = 0.0;
+		for (float sample : samples) sum += sample;
+
+		summary.count = static_cast<uint32_t>(samples.size());
+		summary.mean = static_cast<float>(sum / samples.size());
+		summary.p50 = percentile(0.50f);
+		summary.p95 = percentile(0.95f);
+		summary.p99 = percentile(0.99f);
+		summary.max = samples.back();
+		return summary;
+	}
+
+	std::vector<uint32_t> LveFrameStats::getHistogram(Metric metric, float bucketMilliseconds, uint32_t bucketCount) const
+	{
+		assert(bucketMilliseconds > 0.0f && bucketCount > 0 && "Histogram needs at least one bucket of positive width");
+
+		std::vector<uint32_t> buckets(bucketCount, 0);
+		for (float sample : getSamples(metric))
+		{
+			size_t bucket = static_cast<size_t>(std::max(sample, 0.0f) / bucketMilliseconds);
+			buckets[std::min<size_t>(bucket, bucketCount - 1)]++;
+		}
+		return buckets;
+	}
+
+	void LveFrameStats::writeCsv(const std::string& filePath) const
+	{
+		std::ofstream file{ filePath, std::ios::trunc };
+		if (!file.is_open())
+		{
+			throw std::runtime_error("Failed to open file: " + filePath);
+		}
+
+		file << "frame";
+		for (size_t metric = 0; metric < METRIC_COUNT; metric++)
+		{
+			file << "," << getMetricName(static_cast<Metric>(metric)) << "_ms";
+		}
+		file << "\n";
+
+		// Oldest first
+		uint64_t first = frameCount > HISTORY_SIZE ? frameCount - HISTORY_SIZE : 0;
+		for (uint64_t number = first; number < frameCount; number++)
+		{
+			const Frame& frame = history[number % HISTORY_SIZE];
+			file << frame.number;
+			for (float value : frame.milliseconds)
+			{
+				file << ",";
+				if (!std::isnan(value)) file << value;
+			}
+			file << "\n";
+		}
+
+		if (!file)
+		{
+			throw std::runtime_error("Failed to write file: " + filePath);
+		}
+	}
+
+	const char* LveFrameStats::getMetricName(Metric metric)
+	{
+		switch (metric)
+		{
+		case Metric::CpuFrame: return "cpu_frame";
+		case Metric::TimelineWait: return "timeline_wait";
+		case Metric::Acquire: return "acquire";
+		case Metric::Submit: return "submit";
+		case Metric::Present: return "present";
+		case Metric::InputToPresent: return "input_to_present";
+		default: return "unknown";
+		}
+	}
+}
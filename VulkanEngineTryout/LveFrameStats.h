@@ -0,0 +1,76 @@
+#pragma once
+
+// std
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace lve {
+
+	// Per frame CPU timings and input to present latency over the last HISTORY_SIZE frames, with percentiles,
+	// histograms and a CSV dump. Times are in milliseconds.
+	class LveFrameStats
+	{
+	public:
+		enum class Metric {
+			CpuFrame,        // from one beginFrame to the next
+			TimelineWait,    // waiting for the frame slot to finish on the GPU
+			Acquire,         // vkAcquireNextImageKHR
+			Submit,          // queue submission, including waiting for the swap chain image's previous frame
+			Present,         // vkQueuePresentKHR
+			InputToPresent,  // input poll to the image reaching the screen, VK_KHR_present_wait only
+			Count
+		};
+
+		struct Summary {
+			uint32_t count = 0;
+			float mean = 0.0f;
+			float p50 = 0.0f;
+			float p95 = 0.0f;
+			float p99 = 0.0f;
+			float max = 0.0f;
+		};
+
+		static constexpr uint32_t HISTORY_SIZE = 4096;
+
+		LveFrameStats();
+
+		// Call right after polling input, latency is measured from here. Returns the CPU frame time in
+		// seconds, 0 for the first frame.
+		float beginFrame();
+		std::chrono::steady_clock::time_point getInputTime() const { return inputTime; }
+
+		// Into the current frame, a metric recorded twice in one frame keeps the sum. Latency is recorded
+		// in the frame its present completes, not in the frame that was presented.
+		void record(Metric metric, float milliseconds);
+
+		// The current frame's value, NaN when it has not been measured (yet)
+		float getLatest(Metric metric) const;
+		// Over the frames in the history that measured metric
+		Summary getSummary(Metric metric) const;
+		// Same statistics over any set of samples
+		static Summary summarize(std::vector<float> samples);
+		// bucketCount buckets of bucketMilliseconds each, the last one also counts everything above
+		std::vector<uint32_t> getHistogram(Metric metric, float bucketMilliseconds, uint32_t bucketCount) const;
+		// One row per frame in the history, empty cells for metrics that were not measured. Throws std::runtime_error.
+		void writeCsv(const std::string& filePath) const;
+
+		static const char* getMetricName(Metric metric);
+
+	private:
+		static constexpr size_t METRIC_COUNT = static_cast<size_t>(Metric::Count);
+
+		struct Frame {
+			uint64_t number;
+			std::array<float, METRIC_COUNT> milliseconds;  // NaN when not measured
+		};
+
+		std::vector<float> getSamples(Metric metric) const;
+
+		std::vector<Frame> history;  // ring buffer indexed by frame number
+		uint64_t frameCount = 0;
+		std::chrono::steady_clock::time_point inputTime;
+	};
+}
@@ -0,0 +1,277 @@
+#include "LveFrustumCuller.h"
+#include "LveCamera.h"
+
+// std
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <limits>
+#include <random>
+
+#if defined(__AVX2__)
+#define LVE_CULL_AVX2
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define LVE_CULL_SSE2
+#include <emmintrin.h>
+#endif
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace lve {
+
+	namespace {
+		inline uint32_t countTrailingZeros(uint32_t mask)
+		{
+#if defined(_MSC_VER)
+			unsigned long index;
+			_BitScanForward(&index, mask);
+			return static_cast<uint32_t>(index);
+#else
+			return static_cast<uint32_t>(__builtin_ctz(mask));
+#endif
+		}
+
+		inline void appendMaskedIndices(uint32_t mask, uint32_t first, std::vector<uint32_t>& visibleIndices)
+		{
+			while (mask != 0)
+			{
+				visibleIndices.push_back(first + countTrailingZeros(mask));
+				mask &= mask - 1;
+			}
+		}
+
+		// For the AABB test only the corner furthest along the plane normal matters,
+		// which array that corner comes from is fixed per plane
+		struct PlaneArrays {
+			const float* x;
+			const float* y;
+			const float* z;
+		};
+	}
+
+	void LveFrustumCuller::resize(uint32_t count)
+	{
+		for (auto* values : { &sphereX, &sphereY, &sphereZ, &sphereRadius, &minX, &minY, &minZ, &maxX, &maxY, &maxZ })
+		{
+			values->resize(count);
+		}
+	}
+
+	void LveFrustumCuller::setBounds(uint32_t index, const glm::mat4& modelMatrix, const glm::vec3& sphereCenter, float radius, const glm::vec3& aabbMin, const glm::vec3& aabbMax)
+	{
+		assert(index < size() && "Bounds index out of range");
+
+		glm::vec3 worldCenter = modelMatrix * glm::vec4(sphereCenter, 1.0f);
+		float maxScale = glm::max(glm::length(glm::vec3(modelMatrix[0])), glm::max(glm::length(glm::vec3(modelMatrix[1])), glm::length(glm::vec3(modelMatrix[2]))));
+
+		sphereX[index] = worldCenter.x;
+		sphereY[index] = worldCenter.y;
+		sphereZ[index] = worldCenter.z;
+		sphereRadius[index] = radius * maxScale;
+
+		// Transform the box center and project its half extents onto the world axes (Arvo)
+		glm::vec3 localCenter = 0.5f * (aabbMin + aabbMax);
+		glm::vec3 localExtent = 0.5f * (aabbMax - aabbMin);
+		glm::vec3 boxCenter = modelMatrix * glm::vec4(localCenter, 1.0f);
+		glm::vec3 boxExtent{ 0.0f };
+		for (int column = 0; column < 3; column++)
+		{
+			boxExtent += glm::abs(glm::vec3(modelMatrix[column])) * localExtent[column];
+		}
+
+		minX[index] = boxCenter.x - boxExtent.x;
+		minY[index] = boxCenter.y - boxExtent.y;
+		minZ[index] = boxCenter.z - boxExtent.z;
+		maxX[index] = boxCenter.x + boxExtent.x;
+		maxY[index] = boxCenter.y + boxExtent.y;
+		maxZ[index] = boxCenter.z + boxExtent.z;
+	}
+
+	void LveFrustumCuller::setEmpty(uint32_t index)
+	{
+		assert(index < size() && "Bounds index out of range");
+
+		sphereX[index] = 0.0f;
+		sphereY[index] = 0.0f;
+		sphereZ[index] = 0.0f;
+		sphereRadius[index] = -std::numeric_limits<float>::max();
+		minX[index] = minY[index] = minZ[index] = 0.0f;
+		maxX[index] = maxY[index] = maxZ[index] = 0.0f;
+	}
+
+	const char* LveFrustumCuller::kernelName()
+	{
+#if defined(LVE_CULL_AVX2)
+		return "AVX2 (8 wide)";
+#elif defined(LVE_CULL_SSE2)
+		return "SSE2 (4 wide)";
+#else
+		return "scalar";
+#endif
+	}
+
+	void LveFrustumCuller::cull(const std::array<glm::vec4, 6>& frustumPlanes, std::vector<uint32_t>& visibleIndices) const
+	{
+		uint32_t i = 0;
+
+#if defined(LVE_CULL_AVX2) || defined(LVE_CULL_SSE2)
+		const uint32_t count = size();
+		PlaneArrays corners[6];
+		for (int p = 0; p < 6; p++)
+		{
+			corners[p].x = frustumPlanes[p].x >= 0.0f ? maxX.data() : minX.data();
+			corners[p].y = frustumPlanes[p].y >= 0.0f ? maxY.data() : minY.data();
+			corners[p].z = frustumPlanes[p].z >= 0.0f ? maxZ.data() : minZ.data();
+		}
+#endif
+
+#if defined(LVE_CULL_AVX2)
+		__m256 planeX[6], planeY[6], planeZ[6], planeW[6];
+		for (int p = 0; p < 6; p++)
+		{
+			planeX[p] = _mm256_set1_ps(frustumPlanes[p].x);
+			planeY[p] = _mm256_set1_ps(frustumPlanes[p].y);
+			planeZ[p] = _mm256_set1_ps(frustumPlanes[p].z);
+			planeW[p] = _mm256_set1_ps(frustumPlanes[p].w);
+		}
+		const __m256 zero = _mm256_setzero_ps();
+
+		for (; i + 8 <= count; i += 8)
+		{
+			__m256 centerX = _mm256_loadu_ps(sphereX.data() + i);
+			__m256 centerY = _mm256_loadu_ps(sphereY.data() + i);
+			__m256 centerZ = _mm256_loadu_ps(sphereZ.data() + i);
+			__m256 radius = _mm256_loadu_ps(sphereRadius.data() + i);
+			__m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+
+			for (int p = 0; p < 6; p++)
+			{
+				// Sphere: dot(n, c) + w + r >= 0
+				__m256 sphereDistance = _mm256_add_ps(
+					_mm256_add_ps(_mm256_mul_ps(planeX[p], centerX), _mm256_mul_ps(planeY[p], centerY)),
+					_mm256_add_ps(_mm256_mul_ps(planeZ[p], centerZ), _mm256_add_ps(planeW[p], radius)));
+				inside = _mm256_and_ps(inside, _mm256_cmp_ps(sphereDistance, zero, _CMP_GE_OQ));
+
+				// AABB: the positive vertex must be on the inner side of the plane
+				__m256 boxDistance = _mm256_add_ps(
+					_mm256_add_ps(_mm256_mul_ps(planeX[p], _mm256_loadu_ps(corners[p].x + i)), _mm256_mul_ps(planeY[p], _mm256_loadu_ps(corners[p].y + i))),
+					_mm256_add_ps(_mm256_mul_ps(planeZ[p], _mm256_loadu_ps(corners[p].z + i)), planeW[p]));
+				inside = _mm256_and_ps(inside, _mm256_cmp_ps(boxDistance, zero, _CMP_GE_OQ));
+			}
+
+			appendMaskedIndices(static_cast<uint32_t>(_mm256_movemask_ps(inside)), i, visibleIndices);
+		}
+#elif defined(LVE_CULL_SSE2)
+		__m128 planeX[6], planeY[6], planeZ[6], planeW[6];
+		for (int p = 0; p < 6; p++)
+		{
+			planeX[p] = _mm_set1_ps(frustumPlanes[p].x);
+			planeY[p] = _mm_set1_ps(frustumPlanes[p].y);
+			planeZ[p] = _mm_set1_ps(frustumPlanes[p].z);
+			planeW[p] = _mm_set1_ps(frustumPlanes[p].w);
+		}
+		const __m128 zero = _mm_setzero_ps();
+
+		for (; i + 4 <= count; i += 4)
+		{
+			__m128 centerX = _mm_loadu_ps(sphereX.data() + i);
+			__m128 centerY = _mm_loadu_ps(sphereY.data() + i);
+			__m128 centerZ = _mm_loadu_ps(sphereZ.data() + i);
+			__m128 radius = _mm_loadu_ps(sphereRadius.data() + i);
+			__m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+
+			for (int p = 0; p < 6; p++)
+			{
+				__m128 sphereDistance = _mm_add_ps(
+					_mm_add_ps(_mm_mul_ps(planeX[p], centerX), _mm_mul_ps(planeY[p], centerY)),
+					_mm_add_ps(_mm_mul_ps(planeZ[p], centerZ), _mm_add_ps(planeW[p], radius)));
+				inside = _mm_and_ps(inside, _mm_cmpge_ps(sphereDistance, zero));
+
+				__m128 boxDistance = _mm_add_ps(
+					_mm_add_ps(_mm_mul_ps(planeX[p], _mm_loadu_ps(corners[p].x + i)), _mm_mul_ps(planeY[p], _mm_loadu_ps(corners[p].y + i))),
+					_mm_add_ps(_mm_mul_ps(planeZ[p], _mm_loadu_ps(corners[p].z + i)), planeW[p]));
+				inside = _mm_and_ps(inside, _mm_cmpge_ps(boxDistance, zero));
+			}
+
+			appendMaskedIndices(static_cast<uint32_t>(_mm_movemask_ps(inside)), i, visibleIndices);
+		}
+#endif
+
+		cullScalar(frustumPlanes, i, visibleIndices);
+	}
+
+	void LveFrustumCuller::cullScalar(const std::array<glm::vec4, 6>& frustumPlanes, uint32_t first, std::vector<uint32_t>& visibleIndices) const
+	{
+		const uint32_t count = size();
+		for (uint32_t i = first; i < count; i++)
+		{
+			bool inside = true;
+			for (int p = 0; p < 6 && inside; p++)
+			{
+				const glm::vec4& plane = frustumPlanes[p];
+				float sphereDistance = plane.x * sphereX[i] + plane.y * sphereY[i] + plane.z * sphereZ[i] + plane.w + sphereRadius[i];
+				float boxDistance =
+					plane.x * (plane.x >= 0.0f ? maxX[i] : minX[i]) +
+					plane.y * (plane.y >= 0.0f ? maxY[i] : minY[i]) +
+					plane.z * (plane.z >= 0.0f ? maxZ[i] : minZ[i]) + plane.w;
+				inside = sphereDistance >= 0.0f && boxDistance >= 0.0f;
+			}
+
+			if (inside)
+			{
+				visibleIndices.push_back(i);
+			}
+		}
+	}
+
+	LveFrustumCuller::BenchmarkResult LveFrustumCuller::runBenchmark(uint32_t objectCount, uint32_t iterations)
+	{
+		assert(iterations > 0 && "Benchmark needs at least one iteration");
+
+		// Unit cubes scattered around a camera at the origin looking down +z, fixed seed for repeatable runs
+		std::mt19937 random{ 1337 };
+		std::uniform_real_distribution<float> position{ -50.0f, 50.0f };
+		std::uniform_real_distribution<float> scale{ 0.25f, 2.0f };
+
+		LveFrustumCuller culler{};
+		culler.resize(objectCount);
+		for (uint32_t i = 0; i < objectCount; i++)
+		{
+			glm::mat4 modelMatrix{ 1.0f };
+			modelMatrix[0][0] = modelMatrix[1][1] = modelMatrix[2][2] = scale(random);
+			modelMatrix[3] = glm::vec4{ position(random), position(random), position(random), 1.0f };
+			culler.setBounds(i, modelMatrix, glm::vec3{ 0.0f }, glm::sqrt(3.0f), glm::vec3{ -1.0f }, glm::vec3{ 1.0f });
+		}
+
+		LveCamera camera{};
+		camera.setPerspectiveProjection(glm::radians(60.0f), 16.0f / 9.0f, 0.1f, 40.0f);
+		camera.setViewDirection(glm::vec3{ 0.0f }, glm::vec3{ 0.0f, 0.0f, 1.0f });
+		auto planes = camera.getFrustumPlanes();
+
+		std::vector<uint32_t> visibleIndices;
+		visibleIndices.reserve(objectCount);
+
+		auto startTime = std::chrono::high_resolution_clock::now();
+		for (uint32_t iteration = 0; iteration < iterations; iteration++)
+		{
+			visibleIndices.clear();
+			culler.cull(planes, visibleIndices);
+		}
+		auto endTime = std::chrono::high_resolution_clock::now();
+
+		double totalMicroseconds = std::chrono::duration<double, std::micro>(endTime - startTime).count();
+		double microsecondsPerCull = totalMicroseconds / iterations;
+		uint32_t visibleCount = static_cast<uint32_t>(visibleIndices.size());
+
+		BenchmarkResult result{};
+		result.objectCount = objectCount;
+		result.visibleCount = visibleCount;
+		result.microsecondsPerCull = microsecondsPerCull;
+		result.culledPerMicrosecond = microsecondsPerCull > 0.0 ? (objectCount - visibleCount) / microsecondsPerCull : 0.0;
+		result.testedPerMicrosecond = microsecondsPerCull > 0.0 ? objectCount / microsecondsPerCull : 0.0;
+		return result;
+	}
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+// libs
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include <glm/glm.hpp>
+
+// std
+#include <array>
+#include <cstdint>
+#include <vector>
+
+namespace lve {
+	// World space bounding spheres and AABBs kept in structure-of-arrays form so the frustum test
+	// can run on 8 (AVX2) or 4 (SSE2) objects per iteration.
+	class LveFrustumCuller
+	{
+	public:
+		struct BenchmarkResult {
+			uint32_t objectCount;
+			uint32_t visibleCount;
+			double microsecondsPerCull;
+			double culledPerMicrosecond;
+			double testedPerMicrosecond;
+		};
+
+		void resize(uint32_t count);
+		uint32_t size() const { return static_cast<uint32_t>(sphereRadius.size()); }
+
+		void setBounds(uint32_t index, const glm::mat4& modelMatrix, const glm::vec3& sphereCenter, float sphereRadius, const glm::vec3& aabbMin, const glm::vec3& aabbMax);
+		// Objects marked as empty never pass the frustum test (e.g. game objects without a model)
+		void setEmpty(uint32_t index);
+
+		// Appends the indices of all objects that intersect the frustum, in ascending order
+		void cull(const std::array<glm::vec4, 6>& frustumPlanes, std::vector<uint32_t>& visibleIndices) const;
+
+		static const char* kernelName();
+		static BenchmarkResult runBenchmark(uint32_t objectCount, uint32_t iterations);
+
+	private:
+		void cullScalar(const std::array<glm::vec4, 6>& frustumPlanes, uint32_t first, std::vector<uint32_t>& visibleIndices) const;
+
+		std::vector<float> sphereX;
+		std::vector<float> sphereY;
+		std::vector<float> sphereZ;
+		std::vector<float> sphereRadius;
+
+		std::vector<float> minX;
+		std::vector<float> minY;
+		std::vector<float> minZ;
+		std::vector<float> maxX;
+		std::vector<float> maxY;
+		std::vector<float> maxZ;
+	};
+}
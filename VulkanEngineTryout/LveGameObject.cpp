@@ -1,5 +1,8 @@
 #include "LveGameObject.h"
 
+// Libs
+#include <glm/gtc/constants.hpp>
+
 namespace lve {
 	glm::mat4 TransformComponent::mat4() {
 		const float c3 = glm::cos(rotation.z);
@@ -59,4 +62,15 @@ namespace lve {
 			}
 		};
 	}
-}
\ No newline at end of file
+
+	TransformComponent TransformComponent::interpolate(const TransformComponent& from, const TransformComponent& to, float alpha) {
+		// Angles may have wrapped between the states (the camera keeps yaw in [0, 2pi))
+		glm::vec3 rotationDelta = glm::mod(to.rotation - from.rotation + glm::pi<float>(), glm::two_pi<float>()) - glm::pi<float>();
+
+		TransformComponent result{};
+		result.translation = glm::mix(from.translation, to.translation, alpha);
+		result.scale = glm::mix(from.scale, to.scale, alpha);
+		result.rotation = from.rotation + rotationDelta * alpha;
+		return result;
+	}
+}
@@ -20,6 +20,9 @@ namespace lve {
 		// https://en.wikipedia.org/wiki/Euler_angles#Rotation_matrix
 		glm::mat4 mat4();
 		glm::mat3 normalMatrix();
+
+		// Between two simulation states, alpha 0 is from and 1 is to. Rotations take the shorter way around.
+		static TransformComponent interpolate(const TransformComponent& from, const TransformComponent& to, float alpha);
 	};
 
 	class LveGameObject
@@ -41,7 +44,14 @@ namespace lve {
 
 		std::shared_ptr<LveModel> model{};
 		glm::vec3 color{};
+		// Bindless texture slot, 0 is LveBindlessRegistry::WHITE_TEXTURE
+		uint32_t textureIndex = 0;
 		TransformComponent transform{};
+		// Drawn after all opaque objects with blending, sorted back to front
+		bool transparent = false;
+		// Opaque static objects are recorded once into cached command buffers, see SimpleRenderSystem::setStaticScene.
+		// The transform must not change afterwards.
+		bool isStatic = false;
 
 	private:
 		LveGameObject(id_t objId) : id(objId) {}
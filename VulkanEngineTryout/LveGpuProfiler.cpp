@@ -0,0 +1,119 @@
+#include "LveGpuProfiler.h"
+#include "Lve_Swap_Chain.h"
+
+// std
+#include <array>
+#include <cassert>
+#include <stdexcept>
+
+namespace lve {
+
+	LveGpuProfiler::LveGpuProfiler(LveDevice& device) : lveDevice{ device }
+	{
+		frameRecorded.resize(Lve_Swap_Chain::MAX_FRAMES_IN_FLIGHT, false);
+
+		if (lveDevice.properties.limits.timestampComputeAndGraphics)
+		{
+			createQueryPool();
+		}
+	}
+
+	LveGpuProfiler::~LveGpuProfiler()
+	{
+		vkDestroyQueryPool(lveDevice.device(), queryPool, nullptr);
+	}
+
+	void LveGpuProfiler::createQueryPool()
+	{
+		VkQueryPoolCreateInfo poolInfo{};
+		poolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+		poolInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+		poolInfo.queryCount = Lve_Swap_Chain::MAX_FRAMES_IN_FLIGHT * MAX_SECTIONS * 2;
+
+		if (vkCreateQueryPool(lveDevice.device(), &poolInfo, nullptr, &queryPool) != VK_SUCCESS)
+		{
+			throw std::runtime_error("failed to create timestamp query pool");
+		}
+	}
+
+	uint32_t LveGpuProfiler::addSection(const std::string& name)
+	{
+		assert(sections.size() < MAX_SECTIONS && "Too many profiler sections");
+
+		sections.push_back({ name });
+		return static_cast<uint32_t>(sections.size() - 1);
+	}
+
+	uint32_t LveGpuProfiler::queryIndex(int frameIndex, uint32_t section, uint32_t point) const
+	{
+		return (static_cast<uint32_t>(frameIndex) * MAX_SECTIONS + section) * 2 + point;
+	}
+
+	void LveGpuProfiler::beginFrame(VkCommandBuffer commandBuffer, int frameIndex)
+	{
+		if (!isSupported() || sections.empty())
+		{
+			return;
+		}
+
+		uint32_t firstQuery = queryIndex(frameIndex, 0, 0);
+		uint32_t queryCount = static_cast<uint32_t>(sections.size()) * 2;
+
+		// The timeline value of this frame slot has been waited on, so its queries are final. Sections that were
+		// not written that frame report as unavailable and keep their previous timing.
+		if (frameRecorded[frameIndex])
+		{
+			// Timestamp value followed by its availability
+			std::array<uint64_t, MAX_SECTIONS * 2 * 2> results{};
+			VkResult result = vkGetQueryPoolResults(
+				lveDevice.device(),
+				queryPool,
+				firstQuery,
+				queryCount,
+				sizeof(results),
+				results.data(),
+				sizeof(uint64_t) * 2,
+				VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WITH_AVAILABILITY_BIT);
+
+			if (result == VK_SUCCESS || result == VK_NOT_READY)
+			{
+				for (uint32_t section = 0; section < sections.size(); section++)
+				{
+					uint64_t begin = results[section * 4];
+					uint64_t beginAvailable = results[section * 4 + 1];
+					uint64_t end = results[section * 4 + 2];
+					uint64_t endAvailable = results[section * 4 + 3];
+					if (beginAvailable != 0 && endAvailable != 0 && end >= begin)
+					{
+						// timestampPeriod is nanoseconds per tick
+						double nanoseconds = static_cast<double>(end - begin) * lveDevice.properties.limits.timestampPeriod;
+						sections[section].milliseconds = static_cast<float>(nanoseconds / 1000000.0);
+					}
+				}
+			}
+		}
+
+		vkCmdResetQueryPool(commandBuffer, queryPool, firstQuery, queryCount);
+		frameRecorded[frameIndex] = true;
+	}
+
+	void LveGpuProfiler::writeBegin(VkCommandBuffer commandBuffer, int frameIndex, uint32_t section)
+	{
+		if (!isSupported())
+		{
+			return;
+		}
+
+		vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, queryPool, queryIndex(frameIndex, section, 0));
+	}
+
+	void LveGpuProfiler::writeEnd(VkCommandBuffer commandBuffer, int frameIndex, uint32_t section)
+	{
+		if (!isSupported())
+		{
+			return;
+		}
+
+		vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, queryPool, queryIndex(frameIndex, section, 1));
+	}
+}
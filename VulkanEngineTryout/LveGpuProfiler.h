@@ -0,0 +1,56 @@
+#pragma once
+
+#include "LveDevice.h"
+
+// std
+#include <string>
+#include <vector>
+
+namespace lve {
+	// GPU timings from timestamp queries. Sections are registered up front and every section owns a fixed
+	// pair of queries per frame in flight, so the timestamps can also be written from cached command buffers.
+	// Results arrive once the frame slot's timeline value has been waited on, i.e. as many frames late as there are frames in flight.
+	class LveGpuProfiler
+	{
+	public:
+		static constexpr uint32_t MAX_SECTIONS = 16;
+
+		LveGpuProfiler(LveDevice& device);
+		~LveGpuProfiler();
+
+		LveGpuProfiler(const LveGpuProfiler&) = delete;
+		LveGpuProfiler& operator=(const LveGpuProfiler&) = delete;
+
+		// Without timestamp support every write is a no-op and all timings stay zero
+		bool isSupported() const { return queryPool != VK_NULL_HANDLE; }
+
+		// Call before the first frame, returns the section id
+		uint32_t addSection(const std::string& name);
+		uint32_t getSectionCount() const { return static_cast<uint32_t>(sections.size()); }
+		const std::string& getSectionName(uint32_t section) const { return sections[section].name; }
+		// Last measured GPU time of the section, zero until it has been measured
+		float getMilliseconds(uint32_t section) const { return sections[section].milliseconds; }
+
+		// Reads back the results of this frame slot and resets its queries, must be recorded outside of a render pass
+		void beginFrame(VkCommandBuffer commandBuffer, int frameIndex);
+
+		// Only records into the command buffer, safe to call from recording threads. Each section may be
+		// written at most once per frame and the end must execute after the begin.
+		void writeBegin(VkCommandBuffer commandBuffer, int frameIndex, uint32_t section);
+		void writeEnd(VkCommandBuffer commandBuffer, int frameIndex, uint32_t section);
+
+	private:
+		struct Section {
+			std::string name;
+			float milliseconds = 0.0f;
+		};
+
+		void createQueryPool();
+		uint32_t queryIndex(int frameIndex, uint32_t section, uint32_t point) const;
+
+		LveDevice& lveDevice;
+		VkQueryPool queryPool = VK_NULL_HANDLE;
+		std::vector<Section> sections;
+		std::vector<bool> frameRecorded;
+	};
+}
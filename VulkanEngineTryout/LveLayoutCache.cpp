@@ -0,0 +1,126 @@
+#include "LveLayoutCache.h"
+#include "LveDescriptor.h"
+
+// std
+#include <algorithm>
+#include <cassert>
+#include <stdexcept>
+#include <type_traits>
+
+namespace lve {
+
+	namespace {
+		template<typename T>
+		void appendKey(std::string& key, const T& value)
+		{
+			static_assert(std::is_trivially_copyable<T>::value, "Layout keys are built from plain values");
+			key.append(reinterpret_cast<const char*>(&value), sizeof(T));
+		}
+	}
+
+	LveLayoutCache::LveLayoutCache(LveDevice& device) : lveDevice{ device }
+	{
+	}
+
+	LveLayoutCache::~LveLayoutCache()
+	{
+		assert(descriptorSetLayouts.empty() && pipelineLayouts.empty() && "Layouts have to be cleared before the device is destroyed");
+	}
+
+	LveDescriptorSetLayout& LveLayoutCache::getDescriptorSetLayout(const std::vector<VkDescriptorSetLayoutBinding>& bindings, const std::vector<VkDescriptorBindingFlags>& bindingFlags)
+	{
+		assert((bindingFlags.empty() || bindingFlags.size() == bindings.size()) && "One set of flags per binding");
+
+		// Sorted by binding, so the order bindings are listed in does not matter
+		std::vector<size_t> order(bindings.size());
+		for (size_t i = 0; i < order.size(); i++) order[i] = i;
+		std::sort(order.begin(), order.end(), [&](size_t a, size_t b) { return bindings[a].binding < bindings[b].binding; });
+
+		std::string key;
+		for (size_t i : order)
+		{
+			const auto& binding = bindings[i];
+			assert(binding.pImmutableSamplers == nullptr && "Immutable samplers are not part of the layout key");
+			appendKey(key, binding.binding);
+			appendKey(key, binding.descriptorType);
+			appendKey(key, binding.descriptorCount);
+			appendKey(key, binding.stageFlags);
+			appendKey(key, bindingFlags.empty() ? VkDescriptorBindingFlags{ 0 } : bindingFlags[i]);
+		}
+
+		std::lock_guard<std::mutex> lock{ mutex };
+		stats.descriptorSetLayoutRequests++;
+		auto& layout = descriptorSetLayouts[key];
+		if (!layout)
+		{
+			std::unordered_map<uint32_t, VkDescriptorSetLayoutBinding> layoutBindings;
+			std::unordered_map<uint32_t, VkDescriptorBindingFlags> layoutBindingFlags;
+			for (size_t i = 0; i < bindings.size(); i++)
+			{
+				assert(layoutBindings.count(bindings[i].binding) == 0 && "Binding already in use");
+				layoutBindings[bindings[i].binding] = bindings[i];
+				if (!bindingFlags.empty() && bindingFlags[i] != 0)
+				{
+					layoutBindingFlags[bindings[i].binding] = bindingFlags[i];
+				}
+			}
+			layout = std::make_unique<LveDescriptorSetLayout>(lveDevice, layoutBindings, layoutBindingFlags);
+			stats.descriptorSetLayouts++;
+		}
+		return *layout;
+	}
+
+	VkPipelineLayout LveLayoutCache::getPipelineLayout(const std::vector<VkDescriptorSetLayout>& setLayouts, const std::vector<VkPushConstantRange>& pushConstantRanges)
+	{
+		std::string key;
+		appendKey(key, setLayouts.size());
+		for (auto setLayout : setLayouts)
+		{
+			appendKey(key, setLayout);
+		}
+		for (const auto& range : pushConstantRanges)
+		{
+			appendKey(key, range.stageFlags);
+			appendKey(key, range.offset);
+			appendKey(key, range.size);
+		}
+
+		std::lock_guard<std::mutex> lock{ mutex };
+		stats.pipelineLayoutRequests++;
+		auto& pipelineLayout = pipelineLayouts[key];
+		if (pipelineLayout == VK_NULL_HANDLE)
+		{
+			VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
+			pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+			pipelineLayoutInfo.setLayoutCount = static_cast<uint32_t>(setLayouts.size());
+			pipelineLayoutInfo.pSetLayouts = setLayouts.data();
+			pipelineLayoutInfo.pushConstantRangeCount = static_cast<uint32_t>(pushConstantRanges.size());
+			pipelineLayoutInfo.pPushConstantRanges = pushConstantRanges.data();
+
+			if (vkCreatePipelineLayout(lveDevice.device(), &pipelineLayoutInfo, nullptr, &pipelineLayout) != VK_SUCCESS)
+			{
+				pipelineLayouts.erase(key);
+				throw std::runtime_error("failed to create pipeline layout");
+			}
+			stats.pipelineLayouts++;
+		}
+		return pipelineLayout;
+	}
+
+	void LveLayoutCache::clear()
+	{
+		std::lock_guard<std::mutex> lock{ mutex };
+		for (auto& [key, pipelineLayout] : pipelineLayouts)
+		{
+			vkDestroyPipelineLayout(lveDevice.device(), pipelineLayout, nullptr);
+		}
+		pipelineLayouts.clear();
+		descriptorSetLayouts.clear();
+	}
+
+	LveLayoutCache::Stats LveLayoutCache::getStats()
+	{
+		std::lock_guard<std::mutex> lock{ mutex };
+		return stats;
+	}
+}
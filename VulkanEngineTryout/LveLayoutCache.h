@@ -0,0 +1,54 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+// std
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace lve {
+	class LveDevice;
+	class LveDescriptorSetLayout;
+
+	// Descriptor set and pipeline layouts shared by every system, so that identical layouts exist once.
+	// Layouts are kept until the device is destroyed, which also keeps their handles unique: a handle
+	// from this cache always stands for the same layout.
+	class LveLayoutCache
+	{
+	public:
+		struct Stats {
+			uint32_t descriptorSetLayoutRequests = 0;
+			uint32_t descriptorSetLayouts = 0;
+			uint32_t pipelineLayoutRequests = 0;
+			uint32_t pipelineLayouts = 0;
+		};
+
+		explicit LveLayoutCache(LveDevice& device);
+		~LveLayoutCache();
+
+		LveLayoutCache(const LveLayoutCache&) = delete;
+		LveLayoutCache& operator=(const LveLayoutCache&) = delete;
+
+		// Thread safe. bindingFlags are matched to bindings by position, empty for no flags.
+		LveDescriptorSetLayout& getDescriptorSetLayout(const std::vector<VkDescriptorSetLayoutBinding>& bindings, const std::vector<VkDescriptorBindingFlags>& bindingFlags = {});
+		// Thread safe. setLayouts should come from getDescriptorSetLayout, the handle of a destroyed layout
+		// could be reused by a different one.
+		VkPipelineLayout getPipelineLayout(const std::vector<VkDescriptorSetLayout>& setLayouts, const std::vector<VkPushConstantRange>& pushConstantRanges);
+
+		// Destroys every layout, called by the device before it is destroyed
+		void clear();
+
+		Stats getStats();
+
+	private:
+		LveDevice& lveDevice;
+
+		std::mutex mutex;
+		std::unordered_map<std::string, std::unique_ptr<LveDescriptorSetLayout>> descriptorSetLayouts;
+		std::unordered_map<std::string, VkPipelineLayout> pipelineLayouts;
+		Stats stats{};
+	};
+}
@@ -10,6 +10,7 @@
 
 // std
 #include <cassert>
+#include <algorithm>
 #include <cstring>
 #include <stdexcept>
 #include <unordered_map>
@@ -29,8 +30,11 @@ namespace std {
 
 namespace lve {
 
-	LveModel::LveModel(LveDevice& device, const LveModel::Builder& builder) : lveDevice{ device }
+	LveModel::LveModel(LveDevice& device, const LveModel::Builder& builder) : lveDevice{ device }, boundsCenter{ builder.boundsCenter }, boundsRadius{ builder.boundsRadius }, boundsMin{ builder.boundsMin }, boundsMax{ builder.boundsMax }
 	{
+		static id_t currentId = 0;
+		id = currentId++;
+
 		createVertexBuffers(builder.vertices);
 		createIndexBuffers(builder.indices);
 	}
@@ -218,5 +222,39 @@ namespace lve {
 				indices.push_back(uniqueVertices[vertex]);
 			}
 		}
+
+		computeBounds();
+	}
+
+	void LveModel::Builder::computeBounds()
+	{
+		if (vertices.empty())
+		{
+			boundsCenter = glm::vec3{ 0.0f };
+			boundsRadius = 0.0f;
+			boundsMin = glm::vec3{ 0.0f };
+			boundsMax = glm::vec3{ 0.0f };
+			return;
+		}
+
+		// Sphere around the AABB center, not minimal but cheap and stable
+		glm::vec3 minPos = vertices[0].position;
+		glm::vec3 maxPos = vertices[0].position;
+		for (const auto& vertex : vertices)
+		{
+			minPos = glm::min(minPos, vertex.position);
+			maxPos = glm::max(maxPos, vertex.position);
+		}
+
+		boundsMin = minPos;
+		boundsMax = maxPos;
+		boundsCenter = 0.5f * (minPos + maxPos);
+		float radiusSquared = 0.0f;
+		for (const auto& vertex : vertices)
+		{
+			glm::vec3 offset = vertex.position - boundsCenter;
+			radiusSquared = std::max(radiusSquared, glm::dot(offset, offset));
+		}
+		boundsRadius = glm::sqrt(radiusSquared);
 	}
 }
\ No newline at end of file
@@ -16,6 +16,8 @@ namespace lve {
 	class LveModel
 	{
 	public:
+		using id_t = unsigned int;
+
 		struct Vertex
 		{
 			glm::vec3 position{};
@@ -36,7 +38,14 @@ namespace lve {
 			std::vector<Vertex> vertices{};
 			std::vector<uint32_t> indices{};
 
+			// Model space bounding sphere and AABB, filled in by computeBounds()
+			glm::vec3 boundsCenter{};
+			float boundsRadius = 0.0f;
+			glm::vec3 boundsMin{};
+			glm::vec3 boundsMax{};
+
 			void loadModel(const std::string& filePath);
+			void computeBounds();
 		};
 		LveModel(LveDevice &device, const LveModel::Builder& builder);
 		~LveModel();
@@ -49,11 +58,22 @@ namespace lve {
 		void bind(VkCommandBuffer commandBuffer);
 		void draw(VkCommandBuffer commandBuffer);
 
+		id_t getId() const { return id; }
+		bool hasIndices() const { return hasIndexBuffer; }
+		uint32_t getIndexCount() const { return indexCount; }
+		uint32_t getVertexCount() const { return vertexCount; }
+
+		const glm::vec3& getBoundsCenter() const { return boundsCenter; }
+		float getBoundsRadius() const { return boundsRadius; }
+		const glm::vec3& getBoundsMin() const { return boundsMin; }
+		const glm::vec3& getBoundsMax() const { return boundsMax; }
+
 	private:
 		void createVertexBuffers(const std::vector<Vertex>& vertices);
 		void createIndexBuffers(const std::vector<uint32_t>& indices);
 
 		LveDevice& lveDevice;
+		id_t id;
 		
 		std::unique_ptr<Lve_Buffer> vertexBuffer;
 		uint32_t vertexCount;
@@ -61,5 +81,10 @@ namespace lve {
 		bool hasIndexBuffer = false;
 		std::unique_ptr<Lve_Buffer> indexBuffer;
 		uint32_t indexCount;
+
+		glm::vec3 boundsCenter;
+		float boundsRadius;
+		glm::vec3 boundsMin;
+		glm::vec3 boundsMax;
 	};
 }
\ No newline at end of file
@@ -0,0 +1,77 @@
+#include "LvePipelineCompiler.h"
+
+// std
+#include <algorithm>
+#include <chrono>
+#include <exception>
+
+namespace lve {
+
+	LvePipelineCompiler::LvePipelineCompiler(LveDevice& device, uint32_t threadCount) : lveDevice{ device }, workers{ threadCount }
+	{
+		if (LvePipelineLibrary::isSupported(lveDevice))
+		{
+			library = std::make_unique<LvePipelineLibrary>(lveDevice);
+		}
+	}
+
+	LvePipelineCompiler::~LvePipelineCompiler()
+	{
+		workers.wait();
+	}
+
+	uint32_t LvePipelineCompiler::defaultThreadCount()
+	{
+		return std::max(1u, LveThreadPool::defaultThreadCount() / 2);
+	}
+
+	LvePipelineCompiler::PipelineFuture LvePipelineCompiler::compile(const std::string& vertFilePath, const std::string& fragFilePath, const PipelineConfigInfo& configInfo)
+	{
+		// std::function needs a copyable task, so the promise is shared
+		auto promise = std::make_shared<std::promise<std::shared_ptr<Pipeline>>>();
+		PipelineFuture future = promise->get_future().share();
+
+		workers.submit([this, promise, vertFilePath, fragFilePath, configInfo]()
+			{
+				try
+				{
+					if (library)
+					{
+						promise->set_value(std::make_shared<Pipeline>(lveDevice, library->link(vertFilePath, fragFilePath, configInfo, true)));
+					}
+					else
+					{
+						promise->set_value(std::make_shared<Pipeline>(lveDevice, vertFilePath, fragFilePath, configInfo));
+					}
+				}
+				catch (...)
+				{
+					promise->set_exception(std::current_exception());
+				}
+			});
+
+		return future;
+	}
+
+	std::shared_ptr<Pipeline> LvePipelineCompiler::linkFast(const std::string& vertFilePath, const std::string& fragFilePath, const PipelineConfigInfo& configInfo)
+	{
+		if (!library)
+		{
+			return nullptr;
+		}
+		return std::make_shared<Pipeline>(lveDevice, library->link(vertFilePath, fragFilePath, configInfo, false));
+	}
+
+	void LvePipelineCompiler::releaseStaleParts()
+	{
+		if (library)
+		{
+			library->releaseStaleParts();
+		}
+	}
+
+	bool LvePipelineCompiler::isReady(const PipelineFuture& future)
+	{
+		return future.valid() && future.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+	}
+}
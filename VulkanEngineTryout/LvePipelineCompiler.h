@@ -0,0 +1,51 @@
+#pragma once
+
+#include "LveDevice.h"
+#include "LveThreadPool.h"
+#include "Pipeline.h"
+#include "LvePipelineLibrary.h"
+
+// std
+#include <future>
+#include <memory>
+#include <string>
+
+namespace lve {
+	// Creates graphics pipelines on worker threads of its own, so a frame never waits behind a compile and
+	// compiles never wait behind frame work on the shared pool. All pipelines go through the device's pipeline cache.
+	// With VK_EXT_graphics_pipeline_library the workers do optimized links of cached library parts instead of full
+	// compiles, and linkFast can hand out a usable pipeline right away.
+	class LvePipelineCompiler
+	{
+	public:
+		// Holds the pipeline once compiled, get() rethrows a failed compile
+		using PipelineFuture = std::shared_future<std::shared_ptr<Pipeline>>;
+
+		explicit LvePipelineCompiler(LveDevice& device, uint32_t threadCount = defaultThreadCount());
+		// Waits for the compiles still running, the device has to outlive them
+		~LvePipelineCompiler();
+
+		LvePipelineCompiler(const LvePipelineCompiler&) = delete;
+		LvePipelineCompiler& operator=(const LvePipelineCompiler&) = delete;
+
+		// Half of the worker threads, the other half stays free for frame work
+		static uint32_t defaultThreadCount();
+
+		// configInfo is copied, the layout and render pass it names have to stay alive until the future is ready.
+		// LveRenderer::getSwapChainRenderPass does, resizes don't destroy it.
+		PipelineFuture compile(const std::string& vertFilePath, const std::string& fragFilePath, const PipelineConfigInfo& configInfo);
+		// Links on the calling thread without link time optimization, only compiling the library parts not seen yet.
+		// Meant as a stand-in until compile() delivers. Null without graphics pipeline library support.
+		std::shared_ptr<Pipeline> linkFast(const std::string& vertFilePath, const std::string& fragFilePath, const PipelineConfigInfo& configInfo);
+		bool canLinkFast() const { return library != nullptr; }
+		// After a shader reload, frees the library parts compiled from the old SPIR-V
+		void releaseStaleParts();
+
+		static bool isReady(const PipelineFuture& future);
+
+	private:
+		LveDevice& lveDevice;
+		std::unique_ptr<LvePipelineLibrary> library;
+		LveThreadPool workers;
+	};
+}
@@ -0,0 +1,338 @@
+#include "LvePipelineLibrary.h"
+
+// std
+#include <array>
+#include <cassert>
+#include <chrono>
+#include <exception>
+#include <stdexcept>
+#include <type_traits>
+#include <unordered_set>
+
+namespace lve {
+
+	namespace {
+		// Raw bytes of the state a part depends on, only fed with structs that have no padding or pointers
+		class PartKey
+		{
+		public:
+			template<typename T>
+			PartKey& add(const T& value)
+			{
+				static_assert(std::is_trivially_copyable<T>::value, "Part keys are built from plain values");
+				bytes.append(reinterpret_cast<const char*>(&value), sizeof(T));
+				return *this;
+			}
+
+			PartKey& add(const std::string& value)
+			{
+				add(value.size());
+				bytes += value;
+				return *this;
+			}
+
+			template<typename T>
+			PartKey& addAll(const std::vector<T>& values)
+			{
+				add(values.size());
+				for (auto& value : values)
+				{
+					add(value);
+				}
+				return *this;
+			}
+
+			std::string bytes;
+		};
+
+		void addRenderPass(PartKey& key, const PipelineConfigInfo& configInfo)
+		{
+			key.add(configInfo.renderPass).add(configInfo.subpass).addAll(configInfo.dynamicStateEnables);
+		}
+
+		void addMultisample(PartKey& key, const PipelineConfigInfo& configInfo)
+		{
+			auto& multisample = configInfo.multisampleInfo;
+			key.add(multisample.rasterizationSamples).add(multisample.sampleShadingEnable).add(multisample.minSampleShading)
+				.add(multisample.alphaToCoverageEnable).add(multisample.alphaToOneEnable);
+		}
+	}
+
+	LvePipelineLibrary::LvePipelineLibrary(LveDevice& device) : lveDevice{ device }
+	{
+		assert(isSupported(lveDevice) && "VK_EXT_graphics_pipeline_library is not enabled");
+	}
+
+	LvePipelineLibrary::Part::~Part()
+	{
+		vkDestroyPipeline(lveDevice.device(), pipeline, nullptr);
+	}
+
+	VkPipeline LvePipelineLibrary::link(const std::string& vertFilePath, const std::string& fragFilePath, const PipelineConfigInfo& configInfo, bool optimize)
+	{
+		assert(configInfo.pipelineLayout != VK_NULL_HANDLE && "Cannot link graphics pipeline:: no pipelineLayout provided in configInfo");
+		assert(configInfo.renderPass != VK_NULL_HANDLE && "Cannot link graphics pipeline:: no renderPass provided in configInfo");
+
+		// Held until the link is done, releaseStaleParts may drop them from the cache meanwhile
+		std::array<std::shared_ptr<const Part>, 4> usedParts{
+			getPart(PartType::VertexInput, "", configInfo),
+			getPart(PartType::PreRasterization, vertFilePath, configInfo),
+			getPart(PartType::FragmentShader, fragFilePath, configInfo),
+			getPart(PartType::FragmentOutput, "", configInfo),
+		};
+		std::array<VkPipeline, 4> libraries{};
+		for (size_t i = 0; i < usedParts.size(); i++)
+		{
+			libraries[i] = usedParts[i]->pipeline;
+		}
+
+		VkPipelineLibraryCreateInfoKHR linkInfo{};
+		linkInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LIBRARY_CREATE_INFO_KHR;
+		linkInfo.libraryCount = static_cast<uint32_t>(libraries.size());
+		linkInfo.pLibraries = libraries.data();
+
+		VkGraphicsPipelineCreateInfo pipelineInfo{};
+		pipelineInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+		pipelineInfo.pNext = &linkInfo;
+		pipelineInfo.flags = optimize ? VK_PIPELINE_CREATE_LINK_TIME_OPTIMIZATION_BIT_EXT : 0;
+		pipelineInfo.layout = configInfo.pipelineLayout;
+		pipelineInfo.basePipelineIndex = -1;
+		pipelineInfo.basePipelineHandle = VK_NULL_HANDLE;
+
+		VkPipeline pipeline;
+		if (vkCreateGraphicsPipelines(lveDevice.device(), lveDevice.pipelineCache(), 1, &pipelineInfo, nullptr, &pipeline) != VK_SUCCESS)
+		{
+			throw std::runtime_error("Failed to link graphics pipeline");
+		}
+		return pipeline;
+	}
+
+	void LvePipelineLibrary::releaseStaleParts()
+	{
+		std::unordered_set<std::string> shaderFilePaths;
+		{
+			std::lock_guard<std::mutex> lock{ mutex };
+			for (auto& [key, future] : parts)
+			{
+				if (future.wait_for(std::chrono::seconds(0)) == std::future_status::ready && !future.get()->shaderFilePath.empty())
+				{
+					shaderFilePaths.insert(future.get()->shaderFilePath);
+				}
+			}
+		}
+
+		// What the files hold now, loaded outside the lock
+		std::unordered_map<std::string, uint64_t> currentHashes;
+		for (auto& shaderFilePath : shaderFilePaths)
+		{
+			try
+			{
+				currentHashes.emplace(shaderFilePath, lveDevice.getShaderCache().acquire(shaderFilePath)->getHash());
+			}
+			catch (const std::exception&)
+			{
+				// Unreadable right now, e.g. mid-write, its parts stay until the next release
+			}
+		}
+
+		std::lock_guard<std::mutex> lock{ mutex };
+		for (auto it = parts.begin(); it != parts.end();)
+		{
+			bool stale = false;
+			if (it->second.wait_for(std::chrono::seconds(0)) == std::future_status::ready)
+			{
+				auto& part = it->second.get();
+				auto current = currentHashes.find(part->shaderFilePath);
+				stale = current != currentHashes.end() && current->second != part->shader->getHash();
+			}
+			it = stale ? parts.erase(it) : std::next(it);
+		}
+	}
+
+	std::shared_ptr<const LvePipelineLibrary::Part> LvePipelineLibrary::getPart(PartType type, const std::string& shaderFilePath, const PipelineConfigInfo& configInfo)
+	{
+		// Keyed by the shader contents rather than the path, a reloaded shader gets new parts
+		std::shared_ptr<const LveShaderCache::Shader> shader;
+		if (!shaderFilePath.empty())
+		{
+			shader = lveDevice.getShaderCache().acquire(shaderFilePath);
+		}
+		uint64_t shaderHash = shader ? shader->getHash() : 0;
+
+		PartKey key;
+		key.add(type);
+		switch (type)
+		{
+		case PartType::VertexInput:
+			key.addAll(configInfo.bindingDescriptions).addAll(configInfo.attributeDescriptions)
+				.add(configInfo.inputAssemblyInfo.topology).add(configInfo.inputAssemblyInfo.primitiveRestartEnable);
+			break;
+		case PartType::PreRasterization:
+		{
+			auto& rasterization = configInfo.rasterizationInfo;
+			key.add(shaderHash).add(configInfo.vertexSpecialization.getKey()).add(configInfo.pipelineLayout);
+			addRenderPass(key, configInfo);
+			key.add(configInfo.viewportInfo.viewportCount).add(configInfo.viewportInfo.scissorCount)
+				.add(rasterization.depthClampEnable).add(rasterization.rasterizerDiscardEnable).add(rasterization.polygonMode)
+				.add(rasterization.cullMode).add(rasterization.frontFace).add(rasterization.depthBiasEnable)
+				.add(rasterization.depthBiasConstantFactor).add(rasterization.depthBiasClamp).add(rasterization.depthBiasSlopeFactor)
+				.add(rasterization.lineWidth);
+			break;
+		}
+		case PartType::FragmentShader:
+		{
+			auto& depthStencil = configInfo.depthStencilInfo;
+			key.add(shaderHash).add(configInfo.fragmentSpecialization.getKey()).add(configInfo.pipelineLayout);
+			addRenderPass(key, configInfo);
+			addMultisample(key, configInfo);
+			key.add(depthStencil.depthTestEnable).add(depthStencil.depthWriteEnable).add(depthStencil.depthCompareOp)
+				.add(depthStencil.depthBoundsTestEnable).add(depthStencil.minDepthBounds).add(depthStencil.maxDepthBounds)
+				.add(depthStencil.stencilTestEnable).add(depthStencil.front).add(depthStencil.back);
+			break;
+		}
+		case PartType::FragmentOutput:
+		{
+			auto& colorBlend = configInfo.colorBlendInfo;
+			addRenderPass(key, configInfo);
+			addMultisample(key, configInfo);
+			key.add(colorBlend.logicOpEnable).add(colorBlend.logicOp).add(colorBlend.attachmentCount)
+				.add(configInfo.colorBlendAttachment).add(colorBlend.blendConstants);
+			break;
+		}
+		}
+
+		std::promise<std::shared_ptr<const Part>> promise;
+		PartFuture existing;
+		{
+			std::lock_guard<std::mutex> lock{ mutex };
+			auto found = parts.find(key.bytes);
+			if (found != parts.end())
+			{
+				existing = found->second;
+			}
+			else
+			{
+				parts.emplace(key.bytes, promise.get_future().share());
+			}
+		}
+		if (existing.valid())
+		{
+			// Compiled, or being compiled by another thread. Rethrows if that compile failed.
+			return existing.get();
+		}
+
+		try
+		{
+			auto part = createPart(type, shaderFilePath, std::move(shader), configInfo);
+			promise.set_value(part);
+			return part;
+		}
+		catch (...)
+		{
+			// Threads already waiting get the error, later requests try again
+			{
+				std::lock_guard<std::mutex> lock{ mutex };
+				parts.erase(key.bytes);
+			}
+			promise.set_exception(std::current_exception());
+			throw;
+		}
+	}
+
+	std::shared_ptr<const LvePipelineLibrary::Part> LvePipelineLibrary::createPart(PartType type, const std::string& shaderFilePath, std::shared_ptr<const LveShaderCache::Shader> shader, const PipelineConfigInfo& configInfo)
+	{
+		// Link time optimization needs the intermediate representation kept in the parts
+		VkGraphicsPipelineCreateInfo pipelineInfo{};
+		pipelineInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+		pipelineInfo.flags = VK_PIPELINE_CREATE_LIBRARY_BIT_KHR | VK_PIPELINE_CREATE_RETAIN_LINK_TIME_OPTIMIZATION_INFO_BIT_EXT;
+		pipelineInfo.basePipelineIndex = -1;
+		pipelineInfo.basePipelineHandle = VK_NULL_HANDLE;
+
+		VkGraphicsPipelineLibraryCreateInfoEXT libraryInfo{};
+		libraryInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_LIBRARY_CREATE_INFO_EXT;
+		pipelineInfo.pNext = &libraryInfo;
+
+		// Same fix up as Pipeline::CreateGraphicsPipeline, configInfo may be a copy
+		VkPipelineColorBlendStateCreateInfo colorBlendInfo = configInfo.colorBlendInfo;
+		colorBlendInfo.pAttachments = &configInfo.colorBlendAttachment;
+		VkPipelineDynamicStateCreateInfo dynamicStateInfo = configInfo.dynamicStateInfo;
+		dynamicStateInfo.dynamicStateCount = static_cast<uint32_t>(configInfo.dynamicStateEnables.size());
+		dynamicStateInfo.pDynamicStates = configInfo.dynamicStateEnables.data();
+
+		VkPipelineVertexInputStateCreateInfo vertexInputInfo{};
+		vertexInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+		vertexInputInfo.vertexAttributeDescriptionCount = static_cast<uint32_t>(configInfo.attributeDescriptions.size());
+		vertexInputInfo.vertexBindingDescriptionCount = static_cast<uint32_t>(configInfo.bindingDescriptions.size());
+		vertexInputInfo.pVertexAttributeDescriptions = configInfo.attributeDescriptions.data();
+		vertexInputInfo.pVertexBindingDescriptions = configInfo.bindingDescriptions.data();
+
+		auto part = std::make_shared<Part>(lveDevice);
+		part->shaderFilePath = shaderFilePath;
+		VkSpecializationInfo specializationInfo;
+		VkPipelineShaderStageCreateInfo shaderStage{};
+		shaderStage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+		shaderStage.pName = "main";
+
+		switch (type)
+		{
+		case PartType::VertexInput:
+			libraryInfo.flags = VK_GRAPHICS_PIPELINE_LIBRARY_VERTEX_INPUT_INTERFACE_BIT_EXT;
+			pipelineInfo.pVertexInputState = &vertexInputInfo;
+			pipelineInfo.pInputAssemblyState = &configInfo.inputAssemblyInfo;
+			break;
+		case PartType::PreRasterization:
+			libraryInfo.flags = VK_GRAPHICS_PIPELINE_LIBRARY_PRE_RASTERIZATION_SHADERS_BIT_EXT;
+			part->shader = std::move(shader);
+			if (std::string error = part->shader->getReflection().checkVertexInput(configInfo.attributeDescriptions); !error.empty())
+			{
+				throw std::runtime_error(shaderFilePath + ": " + error);
+			}
+			shaderStage.stage = VK_SHADER_STAGE_VERTEX_BIT;
+			shaderStage.pSpecializationInfo = configInfo.vertexSpecialization.getInfo(specializationInfo);
+			part->shader->attach(shaderStage);
+			pipelineInfo.stageCount = 1;
+			pipelineInfo.pStages = &shaderStage;
+			pipelineInfo.pViewportState = &configInfo.viewportInfo;
+			pipelineInfo.pRasterizationState = &configInfo.rasterizationInfo;
+			pipelineInfo.pDynamicState = &dynamicStateInfo;
+			pipelineInfo.layout = configInfo.pipelineLayout;
+			break;
+		case PartType::FragmentShader:
+			// Without a fragment shader (depth only) the part still carries the depth state
+			libraryInfo.flags = VK_GRAPHICS_PIPELINE_LIBRARY_FRAGMENT_SHADER_BIT_EXT;
+			if (shader)
+			{
+				part->shader = std::move(shader);
+				shaderStage.stage = VK_SHADER_STAGE_FRAGMENT_BIT;
+				shaderStage.pSpecializationInfo = configInfo.fragmentSpecialization.getInfo(specializationInfo);
+				part->shader->attach(shaderStage);
+				pipelineInfo.stageCount = 1;
+				pipelineInfo.pStages = &shaderStage;
+			}
+			pipelineInfo.pMultisampleState = &configInfo.multisampleInfo;
+			pipelineInfo.pDepthStencilState = &configInfo.depthStencilInfo;
+			pipelineInfo.pDynamicState = &dynamicStateInfo;
+			pipelineInfo.layout = configInfo.pipelineLayout;
+			break;
+		case PartType::FragmentOutput:
+			libraryInfo.flags = VK_GRAPHICS_PIPELINE_LIBRARY_FRAGMENT_OUTPUT_INTERFACE_BIT_EXT;
+			pipelineInfo.pMultisampleState = &configInfo.multisampleInfo;
+			pipelineInfo.pColorBlendState = &colorBlendInfo;
+			pipelineInfo.pDynamicState = &dynamicStateInfo;
+			break;
+		}
+
+		// Every part but the vertex input one is tied to the render pass
+		if (type != PartType::VertexInput)
+		{
+			pipelineInfo.renderPass = configInfo.renderPass;
+			pipelineInfo.subpass = configInfo.subpass;
+		}
+
+		if (vkCreateGraphicsPipelines(lveDevice.device(), lveDevice.pipelineCache(), 1, &pipelineInfo, nullptr, &part->pipeline) != VK_SUCCESS)
+		{
+			throw std::runtime_error("Failed to create graphics pipeline library");
+		}
+		return part;
+	}
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include "LveDevice.h"
+#include "Pipeline.h"
+
+// std
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace lve {
+	// VK_EXT_graphics_pipeline_library: a graphics pipeline is split into vertex input, pre-rasterization,
+	// fragment shader and fragment output parts. Parts are compiled once per distinct state and cached, complete
+	// pipelines are linked from them. A variant that only changes blending reuses three parts and only compiles
+	// the cheap fragment output part, one that only changes depth state recompiles just the fragment shader part.
+	// Linked pipelines don't need their parts any more, parts of shaders that were reloaded can be released.
+	class LvePipelineLibrary
+	{
+	public:
+		static bool isSupported(LveDevice& device) { return device.graphicsPipelineLibrary; }
+
+		explicit LvePipelineLibrary(LveDevice& device);
+
+		LvePipelineLibrary(const LvePipelineLibrary&) = delete;
+		LvePipelineLibrary& operator=(const LvePipelineLibrary&) = delete;
+
+		// Thread safe. Without optimize the link is fast but the code may run slower than a monolithic pipeline,
+		// with optimize it takes about as long as a full compile and runs as fast.
+		VkPipeline link(const std::string& vertFilePath, const std::string& fragFilePath, const PipelineConfigInfo& configInfo, bool optimize);
+
+		// Thread safe. Drops the parts built from an older version of their shader file, after a reload nothing
+		// links them any more. Parts still compiling or used by a link in progress stay until they are done.
+		void releaseStaleParts();
+
+	private:
+		enum class PartType : uint8_t {
+			VertexInput,
+			PreRasterization,
+			FragmentShader,
+			FragmentOutput,
+		};
+
+		// Destroys its pipeline with the last reference, links hold their parts while they run
+		struct Part {
+			explicit Part(LveDevice& device) : lveDevice{ device } {}
+			~Part();
+
+			Part(const Part&) = delete;
+			Part& operator=(const Part&) = delete;
+
+			LveDevice& lveDevice;
+			VkPipeline pipeline = VK_NULL_HANDLE;
+			std::string shaderFilePath;
+			std::shared_ptr<const LveShaderCache::Shader> shader;
+		};
+		using PartFuture = std::shared_future<std::shared_ptr<const Part>>;
+
+		// Keyed by the state that goes into the part. The first thread asking for a key compiles it outside the
+		// lock, others asking for the same key wait for it, compiles of different keys run in parallel.
+		std::shared_ptr<const Part> getPart(PartType type, const std::string& shaderFilePath, const PipelineConfigInfo& configInfo);
+		std::shared_ptr<const Part> createPart(PartType type, const std::string& shaderFilePath, std::shared_ptr<const LveShaderCache::Shader> shader, const PipelineConfigInfo& configInfo);
+
+		LveDevice& lveDevice;
+
+		std::mutex mutex;
+		// Entries that are not ready yet are being compiled
+		std::unordered_map<std::string, PartFuture> parts;
+	};
+}
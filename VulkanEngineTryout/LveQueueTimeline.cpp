@@ -0,0 +1,153 @@
+#include "LveQueueTimeline.h"
+
+// std
+#include <limits>
+#include <stdexcept>
+
+namespace lve {
+
+	LveQueueTimeline::LveQueueTimeline(VkDevice device, VkQueue queue, PFN_vkQueueSubmit2KHR queueSubmit2)
+		: device{ device }, queue{ queue }, queueSubmit2{ queueSubmit2 }
+	{
+		VkSemaphoreTypeCreateInfo typeInfo{};
+		typeInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO;
+		typeInfo.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE;
+		typeInfo.initialValue = 0;
+
+		VkSemaphoreCreateInfo createInfo{};
+		createInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+		createInfo.pNext = &typeInfo;
+
+		if (vkCreateSemaphore(device, &createInfo, nullptr, &semaphore) != VK_SUCCESS)
+		{
+			throw std::runtime_error("failed to create timeline semaphore");
+		}
+	}
+
+	LveQueueTimeline::~LveQueueTimeline()
+	{
+		vkDestroySemaphore(device, semaphore, nullptr);
+	}
+
+	uint64_t LveQueueTimeline::submit(const std::vector<VkCommandBuffer>& commandBuffers, const std::vector<Wait>& waits, const std::vector<VkSemaphore>& signalSemaphores)
+	{
+		// Values have to reach the queue in increasing order, so picking one and submitting it is one step
+		std::lock_guard<std::mutex> lock{ submitMutex };
+		uint64_t value = submittedValue + 1;
+		VkResult result;
+
+		if (queueSubmit2 != nullptr)
+		{
+			std::vector<VkSemaphoreSubmitInfoKHR> waitInfos;
+			for (auto& wait : waits)
+			{
+				VkSemaphoreSubmitInfoKHR waitInfo{};
+				waitInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_SUBMIT_INFO_KHR;
+				waitInfo.semaphore = wait.semaphore;
+				waitInfo.value = wait.value;
+				waitInfo.stageMask = wait.stages;
+				waitInfos.push_back(waitInfo);
+			}
+
+			std::vector<VkSemaphoreSubmitInfoKHR> signalInfos(signalSemaphores.size() + 1);
+			for (size_t i = 0; i < signalInfos.size(); i++)
+			{
+				signalInfos[i].sType = VK_STRUCTURE_TYPE_SEMAPHORE_SUBMIT_INFO_KHR;
+				signalInfos[i].semaphore = i < signalSemaphores.size() ? signalSemaphores[i] : semaphore;
+				signalInfos[i].value = i < signalSemaphores.size() ? 0 : value;
+				signalInfos[i].stageMask = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT_KHR;
+			}
+
+			std::vector<VkCommandBufferSubmitInfoKHR> commandBufferInfos;
+			for (auto commandBuffer : commandBuffers)
+			{
+				VkCommandBufferSubmitInfoKHR commandBufferInfo{};
+				commandBufferInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_SUBMIT_INFO_KHR;
+				commandBufferInfo.commandBuffer = commandBuffer;
+				commandBufferInfos.push_back(commandBufferInfo);
+			}
+
+			VkSubmitInfo2KHR submitInfo{};
+			submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO_2_KHR;
+			submitInfo.waitSemaphoreInfoCount = static_cast<uint32_t>(waitInfos.size());
+			submitInfo.pWaitSemaphoreInfos = waitInfos.data();
+			submitInfo.commandBufferInfoCount = static_cast<uint32_t>(commandBufferInfos.size());
+			submitInfo.pCommandBufferInfos = commandBufferInfos.data();
+			submitInfo.signalSemaphoreInfoCount = static_cast<uint32_t>(signalInfos.size());
+			submitInfo.pSignalSemaphoreInfos = signalInfos.data();
+
+			result = queueSubmit2(queue, 1, &submitInfo, VK_NULL_HANDLE);
+		}
+		else
+		{
+			std::vector<VkSemaphore> waitSemaphores;
+			std::vector<VkPipelineStageFlags> waitStages;
+			std::vector<uint64_t> waitValues;
+			for (auto& wait : waits)
+			{
+				waitSemaphores.push_back(wait.semaphore);
+				// The synchronization2 stage bits below 32 are the same as the original ones
+				waitStages.push_back(static_cast<VkPipelineStageFlags>(wait.stages));
+				waitValues.push_back(wait.value);
+			}
+
+			std::vector<VkSemaphore> signals = signalSemaphores;
+			signals.push_back(semaphore);
+			std::vector<uint64_t> signalValues(signals.size(), 0);
+			signalValues.back() = value;
+
+			VkTimelineSemaphoreSubmitInfo timelineInfo{};
+			timelineInfo.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+			timelineInfo.waitSemaphoreValueCount = static_cast<uint32_t>(waitValues.size());
+			timelineInfo.pWaitSemaphoreValues = waitValues.data();
+			timelineInfo.signalSemaphoreValueCount = static_cast<uint32_t>(signalValues.size());
+			timelineInfo.pSignalSemaphoreValues = signalValues.data();
+
+			VkSubmitInfo submitInfo{};
+			submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+			submitInfo.pNext = &timelineInfo;
+			submitInfo.waitSemaphoreCount = static_cast<uint32_t>(waitSemaphores.size());
+			submitInfo.pWaitSemaphores = waitSemaphores.data();
+			submitInfo.pWaitDstStageMask = waitStages.data();
+			submitInfo.commandBufferCount = static_cast<uint32_t>(commandBuffers.size());
+			submitInfo.pCommandBuffers = commandBuffers.data();
+			submitInfo.signalSemaphoreCount = static_cast<uint32_t>(signals.size());
+			submitInfo.pSignalSemaphores = signals.data();
+
+			result = vkQueueSubmit(queue, 1, &submitInfo, VK_NULL_HANDLE);
+		}
+
+		if (result != VK_SUCCESS)
+		{
+			throw std::runtime_error("failed to submit command buffers");
+		}
+		submittedValue = value;
+		return value;
+	}
+
+	void LveQueueTimeline::wait(uint64_t value)
+	{
+		if (value == 0) return;
+
+		VkSemaphoreWaitInfo waitInfo{};
+		waitInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO;
+		waitInfo.semaphoreCount = 1;
+		waitInfo.pSemaphores = &semaphore;
+		waitInfo.pValues = &value;
+
+		if (vkWaitSemaphores(device, &waitInfo, std::numeric_limits<uint64_t>::max()) != VK_SUCCESS)
+		{
+			throw std::runtime_error("failed to wait for timeline semaphore");
+		}
+	}
+
+	uint64_t LveQueueTimeline::getCompletedValue()
+	{
+		uint64_t value = 0;
+		if (vkGetSemaphoreCounterValue(device, semaphore, &value) != VK_SUCCESS)
+		{
+			throw std::runtime_error("failed to read timeline semaphore");
+		}
+		return value;
+	}
+}
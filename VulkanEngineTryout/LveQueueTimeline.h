@@ -0,0 +1,52 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+// std
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+namespace lve {
+
+	// One timeline semaphore for a queue. Every submission signals the next value, so a single counter orders
+	// all work on the queue: once a value has been reached, everything submitted up to it has finished.
+	// Frame pacing, deferred destruction and uploads all wait on these values instead of fences.
+	class LveQueueTimeline
+	{
+	public:
+		struct Wait {
+			VkSemaphore semaphore;
+			VkPipelineStageFlags2KHR stages;
+			uint64_t value = 0;  // timeline semaphores only, ignored for binary ones
+		};
+
+		// queueSubmit2 may be null, submissions go through vkQueueSubmit with timeline values then
+		LveQueueTimeline(VkDevice device, VkQueue queue, PFN_vkQueueSubmit2KHR queueSubmit2);
+		~LveQueueTimeline();
+
+		LveQueueTimeline(const LveQueueTimeline&) = delete;
+		LveQueueTimeline& operator=(const LveQueueTimeline&) = delete;
+
+		// Submits after waits and signals the returned value, plus the binary signalSemaphores (e.g. for presentation).
+		// Thread safe, submissions from several threads are serialized.
+		uint64_t submit(const std::vector<VkCommandBuffer>& commandBuffers, const std::vector<Wait>& waits = {}, const std::vector<VkSemaphore>& signalSemaphores = {});
+
+		// Blocks until value has been reached, returns right away for 0
+		void wait(uint64_t value);
+		uint64_t getCompletedValue();
+		uint64_t getSubmittedValue() const { return submittedValue; }
+
+		VkSemaphore getSemaphore() const { return semaphore; }
+
+	private:
+		VkDevice device;
+		VkQueue queue;
+		PFN_vkQueueSubmit2KHR queueSubmit2;
+		VkSemaphore semaphore = VK_NULL_HANDLE;
+
+		std::mutex submitMutex;
+		std::atomic<uint64_t> submittedValue{ 0 };
+	};
+}
@@ -0,0 +1,814 @@
+#include "LveRenderGraph.h"
+
+// std
+#include <algorithm>
+#include <cassert>
+#include <stdexcept>
+
+namespace lve {
+
+	// Accesses that have to be made available before anyone else touches the resource
+	constexpr VkAccessFlags2KHR WRITE_ACCESS =
+		VK_ACCESS_2_SHADER_WRITE_BIT_KHR |
+		VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT_KHR |
+		VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT_KHR |
+		VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT_KHR |
+		VK_ACCESS_2_TRANSFER_WRITE_BIT_KHR |
+		VK_ACCESS_2_HOST_WRITE_BIT_KHR |
+		VK_ACCESS_2_MEMORY_WRITE_BIT_KHR;
+
+	static VkPipelineStageFlags toLegacyStages(VkPipelineStageFlags2KHR stages)
+	{
+		assert((stages >> 32) == 0 && "Stage has no equivalent without synchronization2");
+		return static_cast<VkPipelineStageFlags>(stages);
+	}
+
+	static VkAccessFlags toLegacyAccess(VkAccessFlags2KHR access)
+	{
+		assert((access >> 32) == 0 && "Access has no equivalent without synchronization2");
+		return static_cast<VkAccessFlags>(access);
+	}
+
+	static bool sameImageDesc(const LveRenderGraph::ImageDesc& a, const LveRenderGraph::ImageDesc& b)
+	{
+		return a.extent.width == b.extent.width && a.extent.height == b.extent.height &&
+			a.format == b.format && a.usage == b.usage && a.aspect == b.aspect && a.mipLevels == b.mipLevels;
+	}
+
+	static bool sameBufferDesc(const LveRenderGraph::BufferDesc& a, const LveRenderGraph::BufferDesc& b)
+	{
+		return a.size == b.size && a.usage == b.usage;
+	}
+
+	void LveRenderGraph::PassBuilder::readImage(ResourceId image, VkPipelineStageFlags2KHR stages, VkAccessFlags2KHR access, VkImageLayout layout)
+	{
+		assert(graph.resources[image].type == ResourceType::Image && "Resource is not an image");
+		use(image, stages, access, layout, false);
+	}
+
+	void LveRenderGraph::PassBuilder::writeImage(ResourceId image, VkPipelineStageFlags2KHR stages, VkAccessFlags2KHR access, VkImageLayout layout)
+	{
+		assert(graph.resources[image].type == ResourceType::Image && "Resource is not an image");
+		use(image, stages, access, layout, true);
+	}
+
+	void LveRenderGraph::PassBuilder::readBuffer(ResourceId buffer, VkPipelineStageFlags2KHR stages, VkAccessFlags2KHR access)
+	{
+		assert(graph.resources[buffer].type == ResourceType::Buffer && "Resource is not a buffer");
+		use(buffer, stages, access, VK_IMAGE_LAYOUT_UNDEFINED, false);
+	}
+
+	void LveRenderGraph::PassBuilder::writeBuffer(ResourceId buffer, VkPipelineStageFlags2KHR stages, VkAccessFlags2KHR access)
+	{
+		assert(graph.resources[buffer].type == ResourceType::Buffer && "Resource is not a buffer");
+		use(buffer, stages, access, VK_IMAGE_LAYOUT_UNDEFINED, true);
+	}
+
+	void LveRenderGraph::PassBuilder::readToken(ResourceId token)
+	{
+		assert(graph.resources[token].type == ResourceType::Token && "Resource is not a token");
+		use(token, 0, 0, VK_IMAGE_LAYOUT_UNDEFINED, false);
+	}
+
+	void LveRenderGraph::PassBuilder::writeToken(ResourceId token)
+	{
+		assert(graph.resources[token].type == ResourceType::Token && "Resource is not a token");
+		use(token, 0, 0, VK_IMAGE_LAYOUT_UNDEFINED, true);
+	}
+
+	void LveRenderGraph::PassBuilder::setSideEffect()
+	{
+		graph.passes[passIndex].sideEffect = true;
+	}
+
+	void LveRenderGraph::PassBuilder::use(ResourceId resource, VkPipelineStageFlags2KHR stages, VkAccessFlags2KHR access, VkImageLayout layout, bool write)
+	{
+		auto& pass = graph.passes[passIndex];
+
+		// A pass touching a resource several times needs a single barrier covering all of it
+		for (auto& usage : pass.usages)
+		{
+			if (usage.resource == resource)
+			{
+				assert(usage.layout == layout && "A pass can only use an image in one layout");
+				usage.stages |= stages;
+				usage.access |= access;
+				usage.write = usage.write || write;
+				return;
+			}
+		}
+
+		pass.usages.push_back({ resource, stages, access, layout, write });
+	}
+
+	LveRenderGraph::LveRenderGraph(LveDevice& device) : lveDevice{ device }
+	{
+	}
+
+	LveRenderGraph::~LveRenderGraph()
+	{
+		destroyPhysicalResources(false);
+	}
+
+	void LveRenderGraph::reset()
+	{
+		resources.clear();
+		passes.clear();
+		finalBarriers = {};
+		compiled = false;
+	}
+
+	LveRenderGraph::ResourceId LveRenderGraph::addResource(Resource&& resource)
+	{
+		assert(!compiled && "Cannot add resources after compile, call reset first");
+
+		resources.push_back(std::move(resource));
+		return static_cast<ResourceId>(resources.size() - 1);
+	}
+
+	LveRenderGraph::ResourceId LveRenderGraph::importImage(const std::string& name, VkImage image, VkImageView view, VkImageAspectFlags aspect, const LveResourceState& initialState)
+	{
+		Resource resource{};
+		resource.name = name;
+		resource.type = ResourceType::Image;
+		resource.image = image;
+		resource.view = view;
+		resource.aspect = aspect;
+		resource.initialState = initialState;
+		return addResource(std::move(resource));
+	}
+
+	LveRenderGraph::ResourceId LveRenderGraph::importBuffer(const std::string& name, VkBuffer buffer, const LveResourceState& initialState)
+	{
+		Resource resource{};
+		resource.name = name;
+		resource.type = ResourceType::Buffer;
+		resource.buffer = buffer;
+		resource.initialState = initialState;
+		return addResource(std::move(resource));
+	}
+
+	LveRenderGraph::ResourceId LveRenderGraph::createImage(const std::string& name, const ImageDesc& desc)
+	{
+		Resource resource{};
+		resource.name = name;
+		resource.type = ResourceType::Image;
+		resource.transient = true;
+		resource.imageDesc = desc;
+		resource.aspect = desc.aspect;
+		return addResource(std::move(resource));
+	}
+
+	LveRenderGraph::ResourceId LveRenderGraph::createBuffer(const std::string& name, const BufferDesc& desc)
+	{
+		Resource resource{};
+		resource.name = name;
+		resource.type = ResourceType::Buffer;
+		resource.transient = true;
+		resource.bufferDesc = desc;
+		return addResource(std::move(resource));
+	}
+
+	LveRenderGraph::ResourceId LveRenderGraph::createToken(const std::string& name)
+	{
+		Resource resource{};
+		resource.name = name;
+		resource.type = ResourceType::Token;
+		return addResource(std::move(resource));
+	}
+
+	void LveRenderGraph::exportResource(ResourceId resource, const LveResourceState& finalState)
+	{
+		assert(!resources[resource].transient && "Transient resources do not outlive the frame");
+
+		resources[resource].exported = true;
+		resources[resource].finalState = finalState;
+	}
+
+	void LveRenderGraph::addPass(const std::string& name, const std::function<void(PassBuilder&)>& setup, ExecuteFunction execute)
+	{
+		assert(!compiled && "Cannot add passes after compile, call reset first");
+
+		Pass pass{};
+		pass.name = name;
+		pass.execute = std::move(execute);
+		passes.push_back(std::move(pass));
+
+		PassBuilder builder{ *this, static_cast<uint32_t>(passes.size() - 1) };
+		setup(builder);
+	}
+
+	void LveRenderGraph::compile()
+	{
+		assert(!compiled && "Render graph is already compiled");
+
+		cullPasses();
+		computeLifetimes();
+		placeTransientResources();
+		planBarriers();
+
+		stats.passCount = static_cast<uint32_t>(passes.size());
+		stats.culledPassCount = 0;
+		stats.barrierCount = static_cast<uint32_t>(finalBarriers.imageBarriers.size() + finalBarriers.bufferBarriers.size());
+		for (const auto& pass : passes)
+		{
+			stats.culledPassCount += pass.culled ? 1 : 0;
+			stats.barrierCount += static_cast<uint32_t>(pass.barriers.imageBarriers.size() + pass.barriers.bufferBarriers.size());
+		}
+
+		compiled = true;
+	}
+
+	void LveRenderGraph::cullPasses()
+	{
+		// Walk backwards from what leaves the graph. Writes count as read-modify-write (a render pass that
+		// loads its attachments builds on the previous writer), so earlier writers of a needed resource stay.
+		std::vector<bool> needed(resources.size(), false);
+		for (ResourceId id = 0; id < resources.size(); id++)
+		{
+			needed[id] = resources[id].exported;
+		}
+
+		for (size_t i = passes.size(); i-- > 0;)
+		{
+			auto& pass = passes[i];
+
+			bool writesNeeded = false;
+			for (const auto& usage : pass.usages)
+			{
+				writesNeeded = writesNeeded || (usage.write && needed[usage.resource]);
+			}
+
+			pass.culled = !pass.sideEffect && !writesNeeded;
+			if (pass.culled)
+			{
+				continue;
+			}
+
+			for (const auto& usage : pass.usages)
+			{
+				needed[usage.resource] = true;
+			}
+		}
+	}
+
+	void LveRenderGraph::computeLifetimes()
+	{
+		for (uint32_t i = 0; i < passes.size(); i++)
+		{
+			if (passes[i].culled)
+			{
+				continue;
+			}
+
+			for (const auto& usage : passes[i].usages)
+			{
+				auto& resource = resources[usage.resource];
+				resource.firstPass = std::min(resource.firstPass, i);
+				resource.lastPass = std::max(resource.lastPass, i);
+			}
+		}
+	}
+
+	void LveRenderGraph::placeTransientResources()
+	{
+		// Transient resources that survived culling, in creation order
+		std::vector<ResourceId> transients;
+		for (ResourceId id = 0; id < resources.size(); id++)
+		{
+			if (resources[id].transient && resources[id].firstPass != UINT32_MAX)
+			{
+				transients.push_back(id);
+			}
+		}
+
+		// Same resources with the same lifetimes as last frame, the memory layout still holds
+		bool sameShape = transients.size() == physicalResources.size();
+		for (size_t i = 0; sameShape && i < transients.size(); i++)
+		{
+			const auto& resource = resources[transients[i]];
+			const auto& physical = physicalResources[i];
+			sameShape = resource.type == physical.type &&
+				(resource.type == ResourceType::Image ? sameImageDesc(resource.imageDesc, physical.imageDesc) : sameBufferDesc(resource.bufferDesc, physical.bufferDesc)) &&
+				resource.firstPass == physical.firstPass && resource.lastPass == physical.lastPass;
+		}
+
+		if (!sameShape)
+		{
+			// Frames in flight may still use the old placement
+			destroyPhysicalResources(true);
+
+			physicalResources.resize(transients.size());
+			for (size_t i = 0; i < transients.size(); i++)
+			{
+				const auto& resource = resources[transients[i]];
+				auto& physical = physicalResources[i];
+				physical.type = resource.type;
+				physical.imageDesc = resource.imageDesc;
+				physical.bufferDesc = resource.bufferDesc;
+				physical.firstPass = resource.firstPass;
+				physical.lastPass = resource.lastPass;
+			}
+			createPhysicalResources();
+		}
+
+		for (size_t i = 0; i < transients.size(); i++)
+		{
+			auto& resource = resources[transients[i]];
+			const auto& physical = physicalResources[i];
+			resource.physicalIndex = static_cast<uint32_t>(i);
+			resource.image = physical.image;
+			resource.view = physical.view;
+			resource.buffer = physical.buffer;
+		}
+
+		stats.transientMemory = 0;
+		stats.transientMemoryWithoutAliasing = 0;
+		for (const auto& block : memoryBlocks)
+		{
+			stats.transientMemory += block.size;
+		}
+		for (const auto& physical : physicalResources)
+		{
+			stats.transientMemoryWithoutAliasing += physical.memoryRequirements.size;
+		}
+	}
+
+	void LveRenderGraph::createPhysicalResources()
+	{
+		for (auto& physical : physicalResources)
+		{
+			if (physical.type == ResourceType::Image)
+			{
+				VkImageCreateInfo imageInfo{};
+				imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+				imageInfo.imageType = VK_IMAGE_TYPE_2D;
+				imageInfo.format = physical.imageDesc.format;
+				imageInfo.extent = { physical.imageDesc.extent.width, physical.imageDesc.extent.height, 1 };
+				imageInfo.mipLevels = physical.imageDesc.mipLevels;
+				imageInfo.arrayLayers = 1;
+				imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+				imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+				imageInfo.usage = physical.imageDesc.usage;
+				imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+				imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+				if (vkCreateImage(lveDevice.device(), &imageInfo, nullptr, &physical.image) != VK_SUCCESS)
+				{
+					throw std::runtime_error("failed to create render graph image");
+				}
+				vkGetImageMemoryRequirements(lveDevice.device(), physical.image, &physical.memoryRequirements);
+			}
+			else
+			{
+				VkBufferCreateInfo bufferInfo{};
+				bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+				bufferInfo.size = physical.bufferDesc.size;
+				bufferInfo.usage = physical.bufferDesc.usage;
+				bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+				if (vkCreateBuffer(lveDevice.device(), &bufferInfo, nullptr, &physical.buffer) != VK_SUCCESS)
+				{
+					throw std::runtime_error("failed to create render graph buffer");
+				}
+				vkGetBufferMemoryRequirements(lveDevice.device(), physical.buffer, &physical.memoryRequirements);
+			}
+		}
+
+		// Largest first, each resource goes into the first block of its kind it is compatible with and whose
+		// occupants are all dead before it starts or born after it ends. Everything is bound at offset 0.
+		std::vector<uint32_t> order(physicalResources.size());
+		for (uint32_t i = 0; i < order.size(); i++)
+		{
+			order[i] = i;
+		}
+		std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b)
+		{
+			return physicalResources[a].memoryRequirements.size > physicalResources[b].memoryRequirements.size;
+		});
+
+		std::vector<ResourceType> blockTypes;
+		for (uint32_t index : order)
+		{
+			auto& physical = physicalResources[index];
+
+			bool placed = false;
+			for (uint32_t b = 0; b < memoryBlocks.size() && !placed; b++)
+			{
+				auto& block = memoryBlocks[b];
+				if (blockTypes[b] != physical.type || !(physical.memoryRequirements.memoryTypeBits & (1u << block.memoryTypeIndex)))
+				{
+					continue;
+				}
+
+				bool overlaps = false;
+				for (uint32_t other : block.physicalResources)
+				{
+					const auto& occupant = physicalResources[other];
+					overlaps = overlaps || (physical.firstPass <= occupant.lastPass && occupant.firstPass <= physical.lastPass);
+				}
+				if (overlaps)
+				{
+					continue;
+				}
+
+				block.size = std::max(block.size, physical.memoryRequirements.size);
+				block.physicalResources.push_back(index);
+				physical.block = b;
+				placed = true;
+			}
+
+			if (!placed)
+			{
+				MemoryBlock block{};
+				block.size = physical.memoryRequirements.size;
+				block.memoryTypeIndex = lveDevice.findMemoryType(physical.memoryRequirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+				block.physicalResources.push_back(index);
+				physical.block = static_cast<uint32_t>(memoryBlocks.size());
+				memoryBlocks.push_back(std::move(block));
+				blockTypes.push_back(physical.type);
+			}
+		}
+
+		for (auto& block : memoryBlocks)
+		{
+			std::sort(block.physicalResources.begin(), block.physicalResources.end(), [&](uint32_t a, uint32_t b)
+			{
+				return physicalResources[a].firstPass < physicalResources[b].firstPass;
+			});
+
+			VkMemoryAllocateInfo allocInfo{};
+			allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+			allocInfo.allocationSize = block.size;
+			allocInfo.memoryTypeIndex = block.memoryTypeIndex;
+
+			if (vkAllocateMemory(lveDevice.device(), &allocInfo, nullptr, &block.memory) != VK_SUCCESS)
+			{
+				throw std::runtime_error("failed to allocate render graph memory");
+			}
+		}
+
+		for (auto& physical : physicalResources)
+		{
+			VkDeviceMemory memory = memoryBlocks[physical.block].memory;
+			if (physical.type == ResourceType::Buffer)
+			{
+				vkBindBufferMemory(lveDevice.device(), physical.buffer, memory, 0);
+				continue;
+			}
+
+			vkBindImageMemory(lveDevice.device(), physical.image, memory, 0);
+
+			VkImageViewCreateInfo viewInfo{};
+			viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+			viewInfo.image = physical.image;
+			viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+			viewInfo.format = physical.imageDesc.format;
+			viewInfo.subresourceRange.aspectMask = physical.imageDesc.aspect;
+			viewInfo.subresourceRange.baseMipLevel = 0;
+			viewInfo.subresourceRange.levelCount = physical.imageDesc.mipLevels;
+			viewInfo.subresourceRange.baseArrayLayer = 0;
+			viewInfo.subresourceRange.layerCount = 1;
+
+			if (vkCreateImageView(lveDevice.device(), &viewInfo, nullptr, &physical.view) != VK_SUCCESS)
+			{
+				throw std::runtime_error("failed to create render graph image view");
+			}
+		}
+	}
+
+	void LveRenderGraph::destroyPhysicalResources(bool deferred)
+	{
+		std::vector<VkImageView> views;
+		std::vector<VkImage> images;
+		std::vector<VkBuffer> buffers;
+		std::vector<VkDeviceMemory> memories;
+		for (const auto& physical : physicalResources)
+		{
+			if (physical.view != VK_NULL_HANDLE) views.push_back(physical.view);
+			if (physical.image != VK_NULL_HANDLE) images.push_back(physical.image);
+			if (physical.buffer != VK_NULL_HANDLE) buffers.push_back(physical.buffer);
+		}
+		for (const auto& block : memoryBlocks)
+		{
+			memories.push_back(block.memory);
+		}
+		physicalResources.clear();
+		memoryBlocks.clear();
+
+		VkDevice device = lveDevice.device();
+		auto destroy = [device, views, images, buffers, memories]()
+		{
+			for (auto view : views) vkDestroyImageView(device, view, nullptr);
+			for (auto image : images) vkDestroyImage(device, image, nullptr);
+			for (auto buffer : buffers) vkDestroyBuffer(device, buffer, nullptr);
+			for (auto memory : memories) vkFreeMemory(device, memory, nullptr);
+		};
+
+		if (deferred)
+		{
+			lveDevice.getDeletionQueue().push(destroy);
+		}
+		else
+		{
+			destroy();
+		}
+	}
+
+	void LveRenderGraph::planBarriers()
+	{
+		// Every stage and write access a resource sees during the frame, what the next occupant of its memory waits for
+		std::vector<VkPipelineStageFlags2KHR> allStages(resources.size(), 0);
+		std::vector<VkAccessFlags2KHR> allWrites(resources.size(), 0);
+		for (const auto& pass : passes)
+		{
+			if (pass.culled)
+			{
+				continue;
+			}
+			for (const auto& usage : pass.usages)
+			{
+				allStages[usage.resource] |= usage.stages;
+				allWrites[usage.resource] |= usage.access & WRITE_ACCESS;
+			}
+		}
+
+		std::vector<TrackedState> states(resources.size());
+		for (ResourceId id = 0; id < resources.size(); id++)
+		{
+			const auto& resource = resources[id];
+			auto& state = states[id];
+
+			if (resource.transient)
+			{
+				if (resource.physicalIndex == UINT32_MAX)
+				{
+					continue;
+				}
+
+				// The previous occupant of the memory, which is the last one of the previous frame for the first occupant.
+				// The contents are never kept, so the layout starts out undefined.
+				const auto& occupants = memoryBlocks[physicalResources[resource.physicalIndex].block].physicalResources;
+				auto position = std::find(occupants.begin(), occupants.end(), resource.physicalIndex);
+				uint32_t previous = position == occupants.begin() ? occupants.back() : *(position - 1);
+
+				for (ResourceId other = 0; other < resources.size(); other++)
+				{
+					if (resources[other].transient && resources[other].physicalIndex == previous)
+					{
+						state.writeStages = allStages[other];
+						state.writeAccess = allWrites[other];
+					}
+				}
+				state.layout = VK_IMAGE_LAYOUT_UNDEFINED;
+			}
+			else
+			{
+				state.writeStages = resource.initialState.stages;
+				state.writeAccess = resource.initialState.access;
+				state.layout = resource.initialState.layout;
+			}
+		}
+
+		for (auto& pass : passes)
+		{
+			if (pass.culled)
+			{
+				continue;
+			}
+			for (const auto& usage : pass.usages)
+			{
+				if (resources[usage.resource].type != ResourceType::Token)
+				{
+					addBarrier(pass.barriers, usage.resource, states[usage.resource], usage);
+				}
+			}
+		}
+
+		for (ResourceId id = 0; id < resources.size(); id++)
+		{
+			const auto& resource = resources[id];
+			if (!resource.exported || resource.type == ResourceType::Token)
+			{
+				continue;
+			}
+
+			const auto& finalState = resource.finalState;
+			bool layoutChange = resource.type == ResourceType::Image && finalState.layout != states[id].layout;
+			if (layoutChange || finalState.stages != 0)
+			{
+				// Treated as a write so the barrier waits for the readers too
+				Usage finalUsage{ id, finalState.stages, finalState.access, resource.type == ResourceType::Image ? finalState.layout : VK_IMAGE_LAYOUT_UNDEFINED, true };
+				addBarrier(finalBarriers, id, states[id], finalUsage);
+			}
+		}
+	}
+
+	void LveRenderGraph::addBarrier(Barriers& barriers, ResourceId id, TrackedState& state, const Usage& usage)
+	{
+		const auto& resource = resources[id];
+		bool isImage = resource.type == ResourceType::Image;
+		bool layoutChange = isImage && usage.layout != state.layout;
+
+		VkPipelineStageFlags2KHR srcStages;
+		VkAccessFlags2KHR srcAccess;
+		if (layoutChange || usage.write)
+		{
+			// Write after write needs the earlier write made available, write after read only has to wait for the readers
+			srcStages = state.writeStages | state.readStages;
+			srcAccess = state.writeAccess;
+		}
+		else
+		{
+			bool visible = (usage.stages & ~state.visibleStages) == 0 && (usage.access & ~state.visibleAccess) == 0;
+			if (visible || (state.writeStages == 0 && state.writeAccess == 0))
+			{
+				// Read after read, or the last write is already visible to this reader
+				state.readStages |= usage.stages;
+				return;
+			}
+			srcStages = state.writeStages;
+			srcAccess = state.writeAccess;
+		}
+
+		if (layoutChange || srcStages != 0 || srcAccess != 0)
+		{
+			if (isImage)
+			{
+				VkImageMemoryBarrier2KHR barrier{};
+				barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2_KHR;
+				barrier.srcStageMask = srcStages;
+				barrier.srcAccessMask = srcAccess;
+				barrier.dstStageMask = usage.stages;
+				barrier.dstAccessMask = usage.access;
+				barrier.oldLayout = state.layout;
+				barrier.newLayout = usage.layout;
+				barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+				barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+				barrier.image = resource.image;
+				barrier.subresourceRange.aspectMask = resource.aspect;
+				barrier.subresourceRange.baseMipLevel = 0;
+				barrier.subresourceRange.levelCount = VK_REMAINING_MIP_LEVELS;
+				barrier.subresourceRange.baseArrayLayer = 0;
+				barrier.subresourceRange.layerCount = VK_REMAINING_ARRAY_LAYERS;
+				barriers.imageBarriers.push_back(barrier);
+			}
+			else
+			{
+				VkBufferMemoryBarrier2KHR barrier{};
+				barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER_2_KHR;
+				barrier.srcStageMask = srcStages;
+				barrier.srcAccessMask = srcAccess;
+				barrier.dstStageMask = usage.stages;
+				barrier.dstAccessMask = usage.access;
+				barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+				barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+				barrier.buffer = resource.buffer;
+				barrier.offset = 0;
+				barrier.size = VK_WHOLE_SIZE;
+				barriers.bufferBarriers.push_back(barrier);
+			}
+		}
+
+		if (usage.write)
+		{
+			// Nothing has seen the write yet, not even a later reader in the same stages
+			state.writeStages = usage.stages;
+			state.writeAccess = usage.access & WRITE_ACCESS;
+			state.readStages = 0;
+			state.visibleStages = 0;
+			state.visibleAccess = 0;
+		}
+		else if (layoutChange)
+		{
+			// The transition is a write that later readers in other stages have to wait for
+			state.writeStages = usage.stages;
+			state.writeAccess = 0;
+			state.readStages = usage.stages;
+			state.visibleStages = usage.stages;
+			state.visibleAccess = usage.access;
+		}
+		else
+		{
+			state.readStages |= usage.stages;
+			state.visibleStages |= usage.stages;
+			state.visibleAccess |= usage.access;
+		}
+		if (isImage)
+		{
+			state.layout = usage.layout;
+		}
+	}
+
+	void LveRenderGraph::execute(VkCommandBuffer commandBuffer)
+	{
+		assert(compiled && "Render graph must be compiled before it is executed");
+
+		for (auto& pass : passes)
+		{
+			if (pass.culled)
+			{
+				continue;
+			}
+
+			recordBarriers(commandBuffer, pass.barriers);
+			pass.execute(commandBuffer);
+		}
+
+		recordBarriers(commandBuffer, finalBarriers);
+	}
+
+	void LveRenderGraph::recordBarriers(VkCommandBuffer commandBuffer, const Barriers& barriers)
+	{
+		if (barriers.imageBarriers.empty() && barriers.bufferBarriers.empty())
+		{
+			return;
+		}
+
+		if (lveDevice.synchronization2)
+		{
+			VkDependencyInfoKHR dependencyInfo{};
+			dependencyInfo.sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO_KHR;
+			dependencyInfo.bufferMemoryBarrierCount = static_cast<uint32_t>(barriers.bufferBarriers.size());
+			dependencyInfo.pBufferMemoryBarriers = barriers.bufferBarriers.data();
+			dependencyInfo.imageMemoryBarrierCount = static_cast<uint32_t>(barriers.imageBarriers.size());
+			dependencyInfo.pImageMemoryBarriers = barriers.imageBarriers.data();
+			lveDevice.cmdPipelineBarrier2(commandBuffer, dependencyInfo);
+			return;
+		}
+
+		// Legacy barriers share one pair of stage masks per call
+		VkPipelineStageFlags srcStages = 0;
+		VkPipelineStageFlags dstStages = 0;
+
+		std::vector<VkImageMemoryBarrier> imageBarriers;
+		imageBarriers.reserve(barriers.imageBarriers.size());
+		for (const auto& barrier2 : barriers.imageBarriers)
+		{
+			srcStages |= toLegacyStages(barrier2.srcStageMask);
+			dstStages |= toLegacyStages(barrier2.dstStageMask);
+
+			VkImageMemoryBarrier barrier{};
+			barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+			barrier.srcAccessMask = toLegacyAccess(barrier2.srcAccessMask);
+			barrier.dstAccessMask = toLegacyAccess(barrier2.dstAccessMask);
+			barrier.oldLayout = barrier2.oldLayout;
+			barrier.newLayout = barrier2.newLayout;
+			barrier.srcQueueFamilyIndex = barrier2.srcQueueFamilyIndex;
+			barrier.dstQueueFamilyIndex = barrier2.dstQueueFamilyIndex;
+			barrier.image = barrier2.image;
+			barrier.subresourceRange = barrier2.subresourceRange;
+			imageBarriers.push_back(barrier);
+		}
+
+		std::vector<VkBufferMemoryBarrier> bufferBarriers;
+		bufferBarriers.reserve(barriers.bufferBarriers.size());
+		for (const auto& barrier2 : barriers.bufferBarriers)
+		{
+			srcStages |= toLegacyStages(barrier2.srcStageMask);
+			dstStages |= toLegacyStages(barrier2.dstStageMask);
+
+			VkBufferMemoryBarrier barrier{};
+			barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+			barrier.srcAccessMask = toLegacyAccess(barrier2.srcAccessMask);
+			barrier.dstAccessMask = toLegacyAccess(barrier2.dstAccessMask);
+			barrier.srcQueueFamilyIndex = barrier2.srcQueueFamilyIndex;
+			barrier.dstQueueFamilyIndex = barrier2.dstQueueFamilyIndex;
+			barrier.buffer = barrier2.buffer;
+			barrier.offset = barrier2.offset;
+			barrier.size = barrier2.size;
+			bufferBarriers.push_back(barrier);
+		}
+
+		// NONE has no legacy bit, top and bottom of pipe wait for nothing and block nothing
+		if (srcStages == 0) srcStages = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+		if (dstStages == 0) dstStages = VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
+
+		vkCmdPipelineBarrier(
+			commandBuffer,
+			srcStages,
+			dstStages,
+			0,
+			0, nullptr,
+			static_cast<uint32_t>(bufferBarriers.size()), bufferBarriers.data(),
+			static_cast<uint32_t>(imageBarriers.size()), imageBarriers.data());
+	}
+
+	VkImage LveRenderGraph::getImage(ResourceId image) const
+	{
+		assert(resources[image].type == ResourceType::Image && "Resource is not an image");
+		return resources[image].image;
+	}
+
+	VkImageView LveRenderGraph::getImageView(ResourceId image) const
+	{
+		assert(resources[image].type == ResourceType::Image && "Resource is not an image");
+		return resources[image].view;
+	}
+
+	VkBuffer LveRenderGraph::getBuffer(ResourceId buffer) const
+	{
+		assert(resources[buffer].type == ResourceType::Buffer && "Resource is not a buffer");
+		return resources[buffer].buffer;
+	}
+}
@@ -0,0 +1,209 @@
+#pragma once
+
+#include "LveDevice.h"
+
+// std
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace lve {
+	// How a pass touches a resource, or the state a resource is in outside of the graph.
+	// Stages and accesses use the synchronization2 bits, only the ones that also exist in the
+	// legacy flags can be used when the device lacks VK_KHR_synchronization2.
+	struct LveResourceState {
+		VkPipelineStageFlags2KHR stages = 0;
+		VkAccessFlags2KHR access = 0;
+		VkImageLayout layout = VK_IMAGE_LAYOUT_UNDEFINED;
+	};
+
+	// Frame graph: passes declare what they read and write, compile() drops passes nothing depends on,
+	// plans the barriers between the remaining ones and places transient resources in memory shared by
+	// resources whose lifetimes do not overlap. Rebuilt every frame, transient memory is kept as long as
+	// the frame keeps the same shape.
+	//
+	// Passes run in the order they were added. A pass can only depend on passes added before it,
+	// so that order is already a valid dependency order.
+	class LveRenderGraph
+	{
+	public:
+		using ResourceId = uint32_t;
+
+		struct ImageDesc {
+			VkExtent2D extent;
+			VkFormat format;
+			VkImageUsageFlags usage;
+			VkImageAspectFlags aspect = VK_IMAGE_ASPECT_COLOR_BIT;
+			uint32_t mipLevels = 1;  // the view covers all of them
+		};
+
+		struct BufferDesc {
+			VkDeviceSize size;
+			VkBufferUsageFlags usage;
+		};
+
+		struct Stats {
+			uint32_t passCount = 0;
+			uint32_t culledPassCount = 0;
+			uint32_t barrierCount = 0;
+			VkDeviceSize transientMemory = 0;
+			VkDeviceSize transientMemoryWithoutAliasing = 0;
+		};
+
+		class PassBuilder
+		{
+		public:
+			void readImage(ResourceId image, VkPipelineStageFlags2KHR stages, VkAccessFlags2KHR access, VkImageLayout layout);
+			void writeImage(ResourceId image, VkPipelineStageFlags2KHR stages, VkAccessFlags2KHR access, VkImageLayout layout);
+			void readBuffer(ResourceId buffer, VkPipelineStageFlags2KHR stages, VkAccessFlags2KHR access);
+			void writeBuffer(ResourceId buffer, VkPipelineStageFlags2KHR stages, VkAccessFlags2KHR access);
+			// Tokens only order passes and keep them alive, see createToken
+			void readToken(ResourceId token);
+			void writeToken(ResourceId token);
+			// The pass has effects outside the graph and is never culled
+			void setSideEffect();
+
+		private:
+			friend class LveRenderGraph;
+			PassBuilder(LveRenderGraph& graph, uint32_t passIndex) : graph{ graph }, passIndex{ passIndex } {}
+
+			void use(ResourceId resource, VkPipelineStageFlags2KHR stages, VkAccessFlags2KHR access, VkImageLayout layout, bool write);
+
+			LveRenderGraph& graph;
+			uint32_t passIndex;
+		};
+
+		using ExecuteFunction = std::function<void(VkCommandBuffer commandBuffer)>;
+
+		LveRenderGraph(LveDevice& device);
+		~LveRenderGraph();
+
+		LveRenderGraph(const LveRenderGraph&) = delete;
+		LveRenderGraph& operator=(const LveRenderGraph&) = delete;
+
+		// Forgets the passes and resources of the previous frame, transient memory is kept for reuse
+		void reset();
+
+		// initialState is what the graph synchronizes the first use against
+		ResourceId importImage(const std::string& name, VkImage image, VkImageView view, VkImageAspectFlags aspect, const LveResourceState& initialState);
+		ResourceId importBuffer(const std::string& name, VkBuffer buffer, const LveResourceState& initialState);
+		// Owned by the graph and only valid for the frame, the contents are undefined at the first use
+		ResourceId createImage(const std::string& name, const ImageDesc& desc);
+		ResourceId createBuffer(const std::string& name, const BufferDesc& desc);
+		// A dependency without memory, for resources a system keeps private and synchronizes itself
+		ResourceId createToken(const std::string& name);
+		// Used after the graph (for example presented): passes writing it are kept and it ends in finalState
+		void exportResource(ResourceId resource, const LveResourceState& finalState);
+
+		void addPass(const std::string& name, const std::function<void(PassBuilder&)>& setup, ExecuteFunction execute);
+
+		void compile();
+		// Records the passes that survived compile() with their barriers
+		void execute(VkCommandBuffer commandBuffer);
+
+		// Physical handles, transient ones are only known after compile()
+		VkImage getImage(ResourceId image) const;
+		VkImageView getImageView(ResourceId image) const;
+		VkBuffer getBuffer(ResourceId buffer) const;
+
+		const Stats& getStats() const { return stats; }
+
+	private:
+		enum class ResourceType { Image, Buffer, Token };
+
+		struct Resource {
+			std::string name;
+			ResourceType type;
+			bool transient = false;
+			ImageDesc imageDesc{};
+			BufferDesc bufferDesc{};
+			VkImage image = VK_NULL_HANDLE;
+			VkImageView view = VK_NULL_HANDLE;
+			VkBuffer buffer = VK_NULL_HANDLE;
+			VkImageAspectFlags aspect = 0;
+			LveResourceState initialState{};
+			bool exported = false;
+			LveResourceState finalState{};
+			uint32_t firstPass = UINT32_MAX;  // lifetime in kept passes
+			uint32_t lastPass = 0;
+			uint32_t physicalIndex = UINT32_MAX;  // into physicalResources for transient resources
+		};
+
+		struct Usage {
+			ResourceId resource;
+			VkPipelineStageFlags2KHR stages;
+			VkAccessFlags2KHR access;
+			VkImageLayout layout;
+			bool write;
+		};
+
+		struct Barriers {
+			std::vector<VkImageMemoryBarrier2KHR> imageBarriers;
+			std::vector<VkBufferMemoryBarrier2KHR> bufferBarriers;
+		};
+
+		struct Pass {
+			std::string name;
+			std::vector<Usage> usages;
+			ExecuteFunction execute;
+			bool sideEffect = false;
+			bool culled = false;
+			Barriers barriers;
+		};
+
+		// What the last write of a resource has been synchronized with so far
+		struct TrackedState {
+			VkPipelineStageFlags2KHR writeStages = 0;
+			VkAccessFlags2KHR writeAccess = 0;
+			VkPipelineStageFlags2KHR readStages = 0;
+			VkPipelineStageFlags2KHR visibleStages = 0;
+			VkAccessFlags2KHR visibleAccess = 0;
+			VkImageLayout layout = VK_IMAGE_LAYOUT_UNDEFINED;
+		};
+
+		// Memory and handles of a transient resource, reused across frames of the same shape
+		struct PhysicalResource {
+			ResourceType type;
+			ImageDesc imageDesc{};
+			BufferDesc bufferDesc{};
+			VkImage image = VK_NULL_HANDLE;
+			VkImageView view = VK_NULL_HANDLE;
+			VkBuffer buffer = VK_NULL_HANDLE;
+			VkMemoryRequirements memoryRequirements{};
+			uint32_t block = 0;
+			// Every resource of the block in frame order, the first one synchronizes against the last one of the previous frame
+			uint32_t firstPass = 0;
+			uint32_t lastPass = 0;
+		};
+
+		struct MemoryBlock {
+			VkDeviceMemory memory = VK_NULL_HANDLE;
+			VkDeviceSize size = 0;
+			uint32_t memoryTypeIndex = 0;
+			std::vector<uint32_t> physicalResources;  // ordered by firstPass
+		};
+
+		ResourceId addResource(Resource&& resource);
+		void cullPasses();
+		void computeLifetimes();
+		void placeTransientResources();
+		void createPhysicalResources();
+		void destroyPhysicalResources(bool deferred);
+		void planBarriers();
+		void addBarrier(Barriers& barriers, ResourceId resource, TrackedState& state, const Usage& usage);
+		void recordBarriers(VkCommandBuffer commandBuffer, const Barriers& barriers);
+
+		LveDevice& lveDevice;
+
+		std::vector<Resource> resources;
+		std::vector<Pass> passes;
+		bool compiled = false;
+
+		// Transient resources of the frame in creation order, with their lifetimes, decide whether the memory can be reused
+		std::vector<PhysicalResource> physicalResources;
+		std::vector<MemoryBlock> memoryBlocks;
+
+		Barriers finalBarriers;
+		Stats stats{};
+	};
+}
@@ -20,7 +20,8 @@ namespace lve {
 		alignas(16) glm::vec3 color;
 	};
 
-	LveRenderer::LveRenderer(LveWindow& window, LveDevice& device) : lveWindow{ window }, lveDevice{ device }
+	LveRenderer::LveRenderer(LveWindow& window, LveDevice& device, const SwapChainSettings& settings)
+		: lveWindow{ window }, lveDevice{ device }, swapChainSettings{ settings }
 	{
 		recreateSwapChain();
 		createCommandBuffers();
@@ -28,6 +29,7 @@ namespace lve {
 
 	LveRenderer::~LveRenderer()
 	{
+		destroySecondaryCommandPools();
 		freeCommandBuffers();
 	}
 
@@ -50,6 +52,15 @@ namespace lve {
 
 		isFrameStarted = true;
 
+		const auto& timings = lveSwapChain->getTimings();
+		frameStats.record(LveFrameStats::Metric::TimelineWait, timings.timelineWaitMilliseconds);
+		frameStats.record(LveFrameStats::Metric::Acquire, timings.acquireMilliseconds);
+		collectPresents();
+
+		// acquireNextImage waited for the timeline value of this frame slot, nothing recorded from these pools is still executing
+		resetSecondaryCommandPools();
+		lveDevice.getDeletionQueue().collect(lveDevice.getGraphicsTimeline().getCompletedValue());
+
 		auto commandBuffer = getCurrentCommandBuffer();
 
 		VkCommandBufferBeginInfo beginInfo{};
@@ -75,6 +86,16 @@ namespace lve {
 		}
 
 		auto result = lveSwapChain->submitCommandBuffers(&commandBuffer, &currentImageIndex);
+		lveDevice.getDeletionQueue().submit(lveSwapChain->getLastSubmittedValue());
+
+		const auto& timings = lveSwapChain->getTimings();
+		frameStats.record(LveFrameStats::Metric::Submit, timings.submitMilliseconds);
+		frameStats.record(LveFrameStats::Metric::Present, timings.presentMilliseconds);
+		if (lveSwapChain->getLastPresentId() != 0)
+		{
+			pendingPresents.push_back({ lveSwapChain->getLastPresentId(), frameStats.getInputTime() });
+		}
+		collectPresents();
 
 		if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR || lveWindow.wasWindowResized())
 		{
@@ -88,17 +109,58 @@ namespace lve {
 
 		isFrameStarted = false;
 
-		currentFrameIndex = (currentFrameIndex + 1) % Lve_Swap_Chain::MAX_FRAMES_IN_FLIGHT;
+		currentFrameIndex = (currentFrameIndex + 1) % getFramesInFlight();
+	}
+
+	void LveRenderer::setSwapChainSettings(const SwapChainSettings& settings)
+	{
+		assert(!isFrameStarted && "Can't change swap chain settings while frame is in progress");
+
+		// Frame indices change meaning, nothing may still be using the per frame resources of the old ones
+		bool framesInFlightChanged = settings.framesInFlight != swapChainSettings.framesInFlight;
+		if (framesInFlightChanged)
+		{
+			vkDeviceWaitIdle(lveDevice.device());
+		}
+
+		swapChainSettings = settings;
+		recreateSwapChain();
+		if (framesInFlightChanged)
+		{
+			currentFrameIndex = 0;
+		}
+	}
+
+	void LveRenderer::collectPresents()
+	{
+		// Polled, so a latency is late by at most the time since the previous call
+		auto now = std::chrono::steady_clock::now();
+		while (!pendingPresents.empty() && lveSwapChain->isPresented(pendingPresents.front().presentId))
+		{
+			float latency = std::chrono::duration<float, std::chrono::milliseconds::period>(now - pendingPresents.front().inputTime).count();
+			frameStats.record(LveFrameStats::Metric::InputToPresent, latency);
+			pendingPresents.pop_front();
+		}
+	}
+
+	VkImageAspectFlags LveRenderer::getSwapChainDepthAspect() const
+	{
+		VkFormat depthFormat = lveSwapChain->getSwapChainDepthFormat();
+		if (depthFormat == VK_FORMAT_D32_SFLOAT_S8_UINT || depthFormat == VK_FORMAT_D24_UNORM_S8_UINT)
+		{
+			return VK_IMAGE_ASPECT_DEPTH_BIT | VK_IMAGE_ASPECT_STENCIL_BIT;
+		}
+		return VK_IMAGE_ASPECT_DEPTH_BIT;
 	}
 
-	void LveRenderer::beginSwapChainRenderPass(VkCommandBuffer commandBuffer)
+	void LveRenderer::beginSwapChainRenderPass(VkCommandBuffer commandBuffer, bool preserveContents, VkSubpassContents contents)
 	{
 		assert(isFrameStarted && "Can't call beginSwapChainRenderPass if frame is not in progress");
 		assert(commandBuffer == getCurrentCommandBuffer() && "Can't begin render pass on command buffer fro m a different frame");
 
 		VkRenderPassBeginInfo renderPassInfo{};
 		renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
-		renderPassInfo.renderPass = lveSwapChain->getRenderPass();
+		renderPassInfo.renderPass = preserveContents ? lveSwapChain->getLoadRenderPass() : lveSwapChain->getRenderPass();
 		renderPassInfo.framebuffer = lveSwapChain->getFrameBuffer(currentImageIndex);
 
 		renderPassInfo.renderArea.offset = { 0, 0 };
@@ -110,8 +172,16 @@ namespace lve {
 		renderPassInfo.clearValueCount = static_cast<uint32_t>(clearValues.size());
 		renderPassInfo.pClearValues = clearValues.data();
 
-		vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+		vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, contents);
 
+		if (contents == VK_SUBPASS_CONTENTS_INLINE)
+		{
+			setViewportAndScissor(commandBuffer);
+		}
+	}
+
+	void LveRenderer::setViewportAndScissor(VkCommandBuffer commandBuffer)
+	{
 		VkViewport viewport{};
 		viewport.x = 0.0f;
 		viewport.y = 0.0f;
@@ -134,6 +204,108 @@ namespace lve {
 		vkCmdEndRenderPass(commandBuffer);
 	}
 
+	void LveRenderer::createSecondaryCommandPools(uint32_t slotCount)
+	{
+		destroySecondaryCommandPools();
+
+		VkCommandPoolCreateInfo poolInfo{};
+		poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+		poolInfo.queueFamilyIndex = lveDevice.findPhysicalQueueFamilies().graphicsFamily;
+		poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+
+		secondaryPools.resize(Lve_Swap_Chain::MAX_FRAMES_IN_FLIGHT);
+		for (auto& framePools : secondaryPools)
+		{
+			framePools.resize(slotCount);
+			for (auto& pool : framePools)
+			{
+				if (vkCreateCommandPool(lveDevice.device(), &poolInfo, nullptr, &pool.commandPool) != VK_SUCCESS)
+				{
+					throw std::runtime_error("failed to create secondary command pool");
+				}
+			}
+		}
+	}
+
+	void LveRenderer::destroySecondaryCommandPools()
+	{
+		for (auto& framePools : secondaryPools)
+		{
+			for (auto& pool : framePools)
+			{
+				// Destroying the pool frees its command buffers
+				vkDestroyCommandPool(lveDevice.device(), pool.commandPool, nullptr);
+			}
+		}
+		secondaryPools.clear();
+	}
+
+	void LveRenderer::resetSecondaryCommandPools()
+	{
+		if (secondaryPools.empty())
+		{
+			return;
+		}
+
+		for (auto& pool : secondaryPools[currentFrameIndex])
+		{
+			vkResetCommandPool(lveDevice.device(), pool.commandPool, 0);
+			pool.usedCount = 0;
+		}
+	}
+
+	VkCommandBuffer LveRenderer::beginSecondaryCommandBuffer(uint32_t slot, bool preserveContents)
+	{
+		assert(isFrameStarted && "Can't begin secondary command buffer if frame is not in progress");
+		assert(slot < getSecondarySlotCount() && "Secondary command buffer slot out of range");
+
+		auto& pool = secondaryPools[currentFrameIndex][slot];
+		if (pool.usedCount == pool.commandBuffers.size())
+		{
+			VkCommandBufferAllocateInfo allocateInfo{};
+			allocateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+			allocateInfo.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+			allocateInfo.commandPool = pool.commandPool;
+			allocateInfo.commandBufferCount = 1;
+
+			VkCommandBuffer commandBuffer;
+			if (vkAllocateCommandBuffers(lveDevice.device(), &allocateInfo, &commandBuffer) != VK_SUCCESS)
+			{
+				throw std::runtime_error("failed to allocate secondary command buffer");
+			}
+			pool.commandBuffers.push_back(commandBuffer);
+		}
+		VkCommandBuffer commandBuffer = pool.commandBuffers[pool.usedCount++];
+
+		VkCommandBufferInheritanceInfo inheritanceInfo{};
+		inheritanceInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+		inheritanceInfo.renderPass = preserveContents ? lveSwapChain->getLoadRenderPass() : lveSwapChain->getRenderPass();
+		inheritanceInfo.subpass = 0;
+		inheritanceInfo.framebuffer = lveSwapChain->getFrameBuffer(currentImageIndex);
+
+		VkCommandBufferBeginInfo beginInfo{};
+		beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+		beginInfo.flags = VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT | VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+		beginInfo.pInheritanceInfo = &inheritanceInfo;
+
+		if (vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS)
+		{
+			throw std::runtime_error("failed to begin recording secondary command buffer");
+		}
+
+		// Dynamic state is not inherited from the primary
+		setViewportAndScissor(commandBuffer);
+		return commandBuffer;
+	}
+
+	void LveRenderer::endSecondaryCommandBuffer(VkCommandBuffer commandBuffer)
+	{
+		if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS)
+		{
+			throw std::runtime_error("failed to record secondary command buffer");
+		}
+	}
+
 	void LveRenderer::createCommandBuffers()
 	{
 		commandBuffers.resize(Lve_Swap_Chain::MAX_FRAMES_IN_FLIGHT);
@@ -164,20 +336,25 @@ namespace lve {
 			extent = lveWindow.getExtent();
 			glfwWaitEvents();
 		}
-		vkDeviceWaitIdle(lveDevice.device());
 		if (lveSwapChain == nullptr)
 		{
-			lveSwapChain = std::make_unique<Lve_Swap_Chain>(lveDevice, extent);
+			lveSwapChain = std::make_unique<Lve_Swap_Chain>(lveDevice, extent, swapChainSettings);
 		}
 		else
 		{
 			std::shared_ptr<Lve_Swap_Chain> oldSwapChain = std::move(lveSwapChain);
-			lveSwapChain = std::make_unique<Lve_Swap_Chain>(lveDevice, extent, oldSwapChain);
+			lveSwapChain = std::make_unique<Lve_Swap_Chain>(lveDevice, extent, swapChainSettings, oldSwapChain);
+			// Present ids belong to the old swap chain
+			pendingPresents.clear();
 
 			if (!oldSwapChain->compareSwapFormats(*lveSwapChain.get()))
 			{
 				throw std::runtime_error("Swap chain image (or depth) format has changed");
 			}
+
+			// Frames still in flight render into the old framebuffers and depth images
+			lveDevice.getDeletionQueue().push([retired = std::move(oldSwapChain)]() mutable { retired.reset(); });
 		}
+		swapChainGeneration++;
 	}
 }
\ No newline at end of file
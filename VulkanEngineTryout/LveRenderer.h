@@ -3,24 +3,74 @@
 #include "LveWindow.h"
 #include "LveDevice.h"
 #include "Lve_Swap_Chain.h"
+#include "LveFrameStats.h"
 
 // Std
+#include <chrono>
+#include <deque>
 #include <memory>
 #include <cassert>
+#include <vector>
 
 namespace lve {
 	class LveRenderer
 	{
 	public:
-		LveRenderer(LveWindow& lveWindow, LveDevice& lveDevice);
+		LveRenderer(LveWindow& lveWindow, LveDevice& lveDevice, const SwapChainSettings& settings = {});
 		~LveRenderer();
 
 		LveRenderer(const LveRenderer&) = delete;
 		LveRenderer& operator=(const LveRenderer&) = delete;
 
+		// The same render pass for the renderer's lifetime, recreated swap chains share it. Pipelines compiling
+		// in the background can use it across resizes as long as the renderer outlives them.
 		VkRenderPass getSwapChainRenderPass() const { return lveSwapChain->getRenderPass(); }
 
 		float getAspectRatio() const { return lveSwapChain->extentAspectRatio(); }
+		VkExtent2D getSwapChainExtent() const { return lveSwapChain->getSwapChainExtent(); }
+		VkFormat getSwapChainDepthFormat() const { return lveSwapChain->getSwapChainDepthFormat(); }
+		// Present source, or transfer source for the offscreen images of a headless device
+		VkImageLayout getSwapChainPresentLayout() const { return lveSwapChain->getPresentLayout(); }
+		// Bumped whenever the swap chain is recreated, anything recorded against the old one is stale
+		uint64_t getSwapChainGeneration() const { return swapChainGeneration; }
+
+		// Recreates the swap chain, between frames only. Waits for the device when frames in flight changes,
+		// frame indices start over at 0 then.
+		void setSwapChainSettings(const SwapChainSettings& settings);
+		const SwapChainSettings& getSwapChainSettings() const { return swapChainSettings; }
+		// Frame indices run from 0 to this, per frame resources are still created for Lve_Swap_Chain::MAX_FRAMES_IN_FLIGHT
+		uint32_t getFramesInFlight() const { return swapChainSettings.framesInFlight; }
+
+		// Acquire, submit and present timings are recorded by beginFrame and endFrame, the caller starts every
+		// frame with LveFrameStats::beginFrame right after polling input
+		LveFrameStats& getFrameStats() { return frameStats; }
+
+		// Includes the stencil aspect for combined depth stencil formats
+		VkImageAspectFlags getSwapChainDepthAspect() const;
+
+		VkImage getCurrentImage() const
+		{
+			assert(isFrameStarted && "Cannot get swap chain image when frame not in progress.");
+			return lveSwapChain->getImage(currentImageIndex);
+		}
+
+		VkImageView getCurrentImageView() const
+		{
+			assert(isFrameStarted && "Cannot get swap chain image view when frame not in progress.");
+			return lveSwapChain->getImageView(currentImageIndex);
+		}
+
+		VkImage getCurrentDepthImage() const
+		{
+			assert(isFrameStarted && "Cannot get depth image when frame not in progress.");
+			return lveSwapChain->getDepthImage(currentImageIndex);
+		}
+
+		VkImageView getCurrentDepthImageView() const
+		{
+			assert(isFrameStarted && "Cannot get depth image view when frame not in progress.");
+			return lveSwapChain->getDepthImageView(currentImageIndex);
+		}
 
 		bool isFrameInProgress() const { return isFrameStarted; }
 		VkCommandBuffer getCurrentCommandBuffer() const 
@@ -38,19 +88,52 @@ namespace lve {
 		VkCommandBuffer beginFrame();
 		void endFrame();
 
-		void beginSwapChainRenderPass(VkCommandBuffer commandBuffer);
+		// Color and depth have to be in attachment layout already and stay there, see Lve_Swap_Chain::createRenderPass.
+		// preserveContents continues on top of an earlier pass of the same frame instead of clearing.
+		// With VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS the pass may only execute secondary command buffers.
+		void beginSwapChainRenderPass(VkCommandBuffer commandBuffer, bool preserveContents = false, VkSubpassContents contents = VK_SUBPASS_CONTENTS_INLINE);
 		void endSwapChainRenderPass(VkCommandBuffer commandBuffer);
 
+		// Parallel recording: every slot owns a command pool per frame in flight, so different slots can
+		// record from different threads at the same time. A slot must only be used by one thread at once.
+		void createSecondaryCommandPools(uint32_t slotCount);
+		uint32_t getSecondarySlotCount() const { return static_cast<uint32_t>(secondaryPools.empty() ? 0 : secondaryPools[0].size()); }
+		// Begins a secondary command buffer that continues the current swap chain render pass, with viewport and scissor set
+		VkCommandBuffer beginSecondaryCommandBuffer(uint32_t slot, bool preserveContents = false);
+		void endSecondaryCommandBuffer(VkCommandBuffer commandBuffer);
+		// Covers the whole swap chain extent, dynamic state has to be set again in every secondary command buffer
+		void setViewportAndScissor(VkCommandBuffer commandBuffer);
+
 	private:
+		struct PendingPresent {
+			uint64_t presentId;
+			std::chrono::steady_clock::time_point inputTime;
+		};
+
+		struct SecondaryPool {
+			VkCommandPool commandPool = VK_NULL_HANDLE;
+			std::vector<VkCommandBuffer> commandBuffers;
+			uint32_t usedCount = 0;
+		};
+
 		void createCommandBuffers();
 		void freeCommandBuffers();
+		void destroySecondaryCommandPools();
+		void resetSecondaryCommandPools();
 		void recreateSwapChain();
+		// Records the latency of every present that has reached the screen since the last call
+		void collectPresents();
 
 		LveWindow& lveWindow;
 		LveDevice& lveDevice;
+		SwapChainSettings swapChainSettings;
 		std::unique_ptr<Lve_Swap_Chain> lveSwapChain;
 		std::vector<VkCommandBuffer> commandBuffers;
+		std::vector<std::vector<SecondaryPool>> secondaryPools;  // [frame][slot]
+		LveFrameStats frameStats;
+		std::deque<PendingPresent> pendingPresents;  // oldest first
 
+		uint64_t swapChainGeneration = 0;
 		uint32_t currentImageIndex;
 		int currentFrameIndex{0};
 		bool isFrameStarted;
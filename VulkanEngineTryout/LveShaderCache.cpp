@@ -0,0 +1,176 @@
+#include "LveShaderCache.h"
+#include "LveDevice.h"
+
+// std
+#include <cassert>
+#include <stdexcept>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace lve {
+
+	namespace {
+		// FNV-1a over the words of the SPIR-V
+		uint64_t hashCode(const uint32_t* code, size_t wordCount)
+		{
+			uint64_t hash = 14695981039346656037ull;
+			for (size_t i = 0; i < wordCount; i++)
+			{
+				hash ^= code[i];
+				hash *= 1099511628211ull;
+			}
+			return hash;
+		}
+	}
+
+#ifdef _WIN32
+	LveShaderCache::MappedFile::MappedFile(const std::string& filePath)
+	{
+		// Shared for delete, so LveShaderReloader can move a new version over the file while it is being read
+		HANDLE fileHandle = CreateFileA(filePath.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+		if (fileHandle == INVALID_HANDLE_VALUE)
+		{
+			throw std::runtime_error("Failed to open file: " + filePath);
+		}
+		file = fileHandle;
+
+		LARGE_INTEGER fileSize;
+		if (!GetFileSizeEx(fileHandle, &fileSize) || fileSize.QuadPart == 0)
+		{
+			CloseHandle(fileHandle);
+			throw std::runtime_error("Failed to map file: " + filePath);
+		}
+		length = static_cast<size_t>(fileSize.QuadPart);
+
+		mapping = CreateFileMappingA(fileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		view = mapping != nullptr ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+		if (view == nullptr)
+		{
+			if (mapping != nullptr) CloseHandle(mapping);
+			CloseHandle(fileHandle);
+			throw std::runtime_error("Failed to map file: " + filePath);
+		}
+	}
+
+	LveShaderCache::MappedFile::~MappedFile()
+	{
+		UnmapViewOfFile(view);
+		CloseHandle(mapping);
+		CloseHandle(file);
+	}
+#else
+	LveShaderCache::MappedFile::MappedFile(const std::string& filePath)
+	{
+		int descriptor = open(filePath.c_str(), O_RDONLY);
+		if (descriptor < 0)
+		{
+			throw std::runtime_error("Failed to open file: " + filePath);
+		}
+
+		struct stat fileStat;
+		void* address = MAP_FAILED;
+		if (fstat(descriptor, &fileStat) == 0 && fileStat.st_size > 0)
+		{
+			length = static_cast<size_t>(fileStat.st_size);
+			address = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, descriptor, 0);
+		}
+		// The mapping stays valid without the descriptor
+		close(descriptor);
+
+		if (address == MAP_FAILED)
+		{
+			throw std::runtime_error("Failed to map file: " + filePath);
+		}
+		view = address;
+	}
+
+	LveShaderCache::MappedFile::~MappedFile()
+	{
+		munmap(const_cast<void*>(view), length);
+	}
+#endif
+
+	LveShaderCache::Shader::Shader(LveDevice& device, std::unique_ptr<MappedFile> spirv, uint64_t hash, bool chainCreateInfo) : lveDevice{ device }, hash{ hash }, reflection{ spirv->data(), spirv->size() / sizeof(uint32_t) }
+	{
+		createInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+		createInfo.codeSize = spirv->size();
+		createInfo.pCode = spirv->data();
+
+		if (chainCreateInfo)
+		{
+			// Copied rather than kept mapped, Windows cannot replace a file while a view of it exists
+			code.assign(spirv->data(), spirv->data() + spirv->size() / sizeof(uint32_t));
+			createInfo.pCode = code.data();
+			return;
+		}
+
+		if (vkCreateShaderModule(lveDevice.device(), &createInfo, nullptr, &module) != VK_SUCCESS)
+		{
+			throw std::runtime_error("Failed to create shader module");
+		}
+		// The module has its own copy, the mapping is released with spirv
+		createInfo.pCode = nullptr;
+	}
+
+	LveShaderCache::Shader::~Shader()
+	{
+		vkDestroyShaderModule(lveDevice.device(), module, nullptr);
+	}
+
+	void LveShaderCache::Shader::attach(VkPipelineShaderStageCreateInfo& stage) const
+	{
+		if (module != VK_NULL_HANDLE)
+		{
+			stage.module = module;
+			return;
+		}
+
+		assert(stage.pNext == nullptr && "Shader stage already has a pNext chain");
+		stage.module = VK_NULL_HANDLE;
+		stage.pNext = &createInfo;
+	}
+
+	LveShaderCache::LveShaderCache(LveDevice& device) : lveDevice{ device }
+	{
+	}
+
+	LveShaderCache::~LveShaderCache()
+	{
+		// Every module has to be gone before the device is destroyed
+		for (auto& [hash, shader] : shaders)
+		{
+			assert(shader.expired() && "Shader module still in use when the cache is destroyed");
+		}
+	}
+
+	std::shared_ptr<const LveShaderCache::Shader> LveShaderCache::acquire(const std::string& filePath)
+	{
+		auto code = std::make_unique<MappedFile>(filePath);
+		if (code->size() % sizeof(uint32_t) != 0)
+		{
+			throw std::runtime_error("Not a SPIR-V file: " + filePath);
+		}
+		uint64_t hash = hashCode(code->data(), code->size() / sizeof(uint32_t));
+
+		std::lock_guard<std::mutex> lock{ mutex };
+		auto& cached = shaders[hash];
+		if (auto shader = cached.lock())
+		{
+			return shader;
+		}
+
+		// Pipelines can take the SPIR-V directly with VK_EXT_graphics_pipeline_library enabled
+		std::shared_ptr<const Shader> shader{ new Shader(lveDevice, std::move(code), hash, lveDevice.graphicsPipelineLibrary) };
+		cached = shader;
+		return shader;
+	}
+}
@@ -0,0 +1,89 @@
+#pragma once
+
+#include "LveShaderReflection.h"
+
+#include <vulkan/vulkan.h>
+
+// std
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace lve {
+	class LveDevice;
+
+	// Shader modules shared by every pipeline, keyed by a hash of the SPIR-V so that the same code under
+	// different paths is only created once. A module lives as long as some pipeline holds it.
+	// SPIR-V files are memory mapped instead of read into a buffer.
+	class LveShaderCache
+	{
+	public:
+		// Read-only mapping of a whole file
+		class MappedFile
+		{
+		public:
+			explicit MappedFile(const std::string& filePath);
+			~MappedFile();
+
+			MappedFile(const MappedFile&) = delete;
+			MappedFile& operator=(const MappedFile&) = delete;
+
+			// Page aligned, so it can be passed as SPIR-V directly
+			const uint32_t* data() const { return reinterpret_cast<const uint32_t*>(view); }
+			size_t size() const { return length; }
+
+		private:
+			void* file = nullptr;
+			void* mapping = nullptr;
+			const void* view = nullptr;
+			size_t length = 0;
+		};
+
+		class Shader
+		{
+		public:
+			~Shader();
+
+			Shader(const Shader&) = delete;
+			Shader& operator=(const Shader&) = delete;
+
+			// Sets the module of stage, or chains the module create info into it when the device can create
+			// pipelines without a module object. Leaves the rest of stage alone.
+			void attach(VkPipelineShaderStageCreateInfo& stage) const;
+
+			uint64_t getHash() const { return hash; }
+			// Read once when the shader is loaded
+			const LveShaderReflection& getReflection() const { return reflection; }
+
+		private:
+			friend class LveShaderCache;
+			Shader(LveDevice& device, std::unique_ptr<MappedFile> spirv, uint64_t hash, bool chainCreateInfo);
+
+			LveDevice& lveDevice;
+			uint64_t hash;
+			LveShaderReflection reflection;
+			VkShaderModule module = VK_NULL_HANDLE;
+			// Only kept when the create info is chained, which then points into it
+			std::vector<uint32_t> code;
+			VkShaderModuleCreateInfo createInfo{};
+		};
+
+		explicit LveShaderCache(LveDevice& device);
+		~LveShaderCache();
+
+		LveShaderCache(const LveShaderCache&) = delete;
+		LveShaderCache& operator=(const LveShaderCache&) = delete;
+
+		// Thread safe
+		std::shared_ptr<const Shader> acquire(const std::string& filePath);
+
+	private:
+		LveDevice& lveDevice;
+
+		std::mutex mutex;
+		std::unordered_map<uint64_t, std::weak_ptr<const Shader>> shaders;
+	};
+}
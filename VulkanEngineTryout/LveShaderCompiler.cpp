@@ -0,0 +1,254 @@
+#include "LveShaderCompiler.h"
+
+// std
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <memory>
+#include <stdexcept>
+
+namespace lve {
+
+	namespace {
+		// Bump when something that affects the output but is not part of the key changes, e.g. the options below
+		constexpr uint32_t CACHE_FORMAT_VERSION = 1;
+
+		class KeyHash
+		{
+		public:
+			// FNV-1a
+			KeyHash& add(const void* data, size_t size)
+			{
+				auto* bytes = static_cast<const unsigned char*>(data);
+				for (size_t i = 0; i < size; i++)
+				{
+					hash ^= bytes[i];
+					hash *= 1099511628211ull;
+				}
+				return *this;
+			}
+
+			KeyHash& add(uint32_t value) { return add(&value, sizeof(value)); }
+			// Length prefixed, so adjacent strings cannot run into each other
+			KeyHash& add(const std::string& value) { return add(static_cast<uint32_t>(value.size())).add(value.data(), value.size()); }
+
+			std::string hex() const
+			{
+				static const char digits[] = "0123456789abcdef";
+				std::string text(16, '0');
+				for (int i = 0; i < 16; i++)
+				{
+					text[15 - i] = digits[(hash >> (i * 4)) & 0xf];
+				}
+				return text;
+			}
+
+		private:
+			uint64_t hash = 14695981039346656037ull;
+		};
+
+		bool readFile(const std::string& filePath, std::string& contents)
+		{
+			std::ifstream file{ filePath, std::ios::binary };
+			if (!file.is_open()) return false;
+			contents.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+			return true;
+		}
+
+		// Through a temporary file, readers never see a partial one
+		void writeFile(const std::string& filePath, const void* data, size_t size)
+		{
+			std::string temporaryPath = filePath + ".tmp";
+			{
+				std::ofstream file{ temporaryPath, std::ios::binary | std::ios::trunc };
+				if (!file.write(static_cast<const char*>(data), size))
+				{
+					throw std::runtime_error("Failed to write file: " + temporaryPath);
+				}
+			}
+
+			std::error_code error;
+			std::filesystem::rename(temporaryPath, filePath, error);
+			if (error)
+			{
+				std::filesystem::remove(temporaryPath, error);
+				throw std::runtime_error("Failed to replace file: " + filePath);
+			}
+		}
+
+		shaderc_shader_kind shaderKind(const std::string& filePath)
+		{
+			std::string extension = std::filesystem::path(filePath).extension().string();
+			if (extension == ".vert") return shaderc_vertex_shader;
+			if (extension == ".frag") return shaderc_fragment_shader;
+			if (extension == ".comp") return shaderc_compute_shader;
+			throw std::runtime_error("Unknown shader stage: " + filePath);
+		}
+
+		// #include "file" relative to the including file, <file> relative to the shader directory
+		class FileIncluder : public shaderc::CompileOptions::IncluderInterface
+		{
+		public:
+			explicit FileIncluder(std::filesystem::path rootDirectory) : rootDirectory{ std::move(rootDirectory) } {}
+
+			shaderc_include_result* GetInclude(const char* requestedSource, shaderc_include_type type, const char* requestingSource, size_t includeDepth) override
+			{
+				auto include = std::make_unique<Include>();
+				std::filesystem::path directory = type == shaderc_include_type_relative ? std::filesystem::path(requestingSource).parent_path() : rootDirectory;
+				include->name = (directory / requestedSource).generic_string();
+				if (!readFile(include->name, include->content))
+				{
+					// An empty name tells the compiler the include failed, content is the message
+					include->content = "cannot open " + include->name;
+					include->name.clear();
+				}
+
+				include->result.source_name = include->name.c_str();
+				include->result.source_name_length = include->name.size();
+				include->result.content = include->content.c_str();
+				include->result.content_length = include->content.size();
+				include->result.user_data = include.get();
+				return &include.release()->result;
+			}
+
+			void ReleaseInclude(shaderc_include_result* data) override
+			{
+				delete static_cast<Include*>(data->user_data);
+			}
+
+		private:
+			struct Include {
+				std::string name;
+				std::string content;
+				shaderc_include_result result{};
+			};
+
+			std::filesystem::path rootDirectory;
+		};
+	}
+
+	LveShaderCompiler::LveShaderCompiler(const std::string& cacheDirectory) : cacheDirectory{ cacheDirectory }
+	{
+		if (!compiler.IsValid())
+		{
+			throw std::runtime_error("Failed to create shader compiler");
+		}
+		shaderc_get_spv_version(&spirvVersion, &spirvRevision);
+
+		std::error_code error;
+		std::filesystem::create_directories(cacheDirectory, error);
+	}
+
+	bool LveShaderCompiler::isShaderStage(const std::string& filePath)
+	{
+		std::string extension = std::filesystem::path(filePath).extension().string();
+		return extension == ".vert" || extension == ".frag" || extension == ".comp";
+	}
+
+	bool LveShaderCompiler::compile(const std::string& sourcePath, const Defines& defines)
+	{
+		std::string source;
+		if (!readFile(sourcePath, source))
+		{
+			throw std::runtime_error("Failed to open file: " + sourcePath);
+		}
+		shaderc_shader_kind kind = shaderKind(sourcePath);
+
+		shaderc::CompileOptions options;
+		options.SetTargetEnvironment(shaderc_target_env_vulkan, shaderc_env_version_vulkan_1_2);
+		options.SetOptimizationLevel(shaderc_optimization_level_performance);
+		options.SetIncluder(std::make_unique<FileIncluder>(std::filesystem::path(sourcePath).parent_path()));
+		for (auto& [name, value] : defines)
+		{
+			options.AddMacroDefinition(name, value);
+		}
+
+		// Includes and defines are resolved by preprocessing, so the key covers them
+		auto preprocessed = compiler.PreprocessGlsl(source, kind, sourcePath.c_str(), options);
+		if (preprocessed.GetCompilationStatus() != shaderc_compilation_status_success)
+		{
+			throw std::runtime_error(preprocessed.GetErrorMessage());
+		}
+
+		KeyHash key;
+		key.add(CACHE_FORMAT_VERSION).add(spirvVersion).add(spirvRevision).add(static_cast<uint32_t>(kind))
+			.add(std::string(preprocessed.cbegin(), preprocessed.cend()));
+		for (auto& [name, value] : defines)
+		{
+			key.add(name).add(value);
+		}
+		std::string cachePath = (std::filesystem::path(cacheDirectory) / (key.hex() + ".spv")).string();
+
+		std::string spirv;
+		bool cached = readFile(cachePath, spirv) && !spirv.empty();
+		if (!cached)
+		{
+			auto result = compiler.CompileGlslToSpv(source, kind, sourcePath.c_str(), options);
+			if (result.GetCompilationStatus() != shaderc_compilation_status_success)
+			{
+				throw std::runtime_error(result.GetErrorMessage());
+			}
+			spirv.assign(reinterpret_cast<const char*>(result.cbegin()), reinterpret_cast<const char*>(result.cend()));
+
+			// Only a cache, a failed write just means compiling again next time
+			try
+			{
+				writeFile(cachePath, spirv.data(), spirv.size());
+			}
+			catch (const std::runtime_error& e)
+			{
+				std::cout << "Shader cache: " << e.what() << std::endl;
+			}
+		}
+
+		{
+			std::lock_guard<std::mutex> lock{ mutex };
+			(cached ? stats.cached : stats.compiled)++;
+		}
+
+		// Left alone when unchanged, so its timestamp and any mapping of it stay valid
+		std::string spirvPath = sourcePath + ".spv";
+		std::string current;
+		if (readFile(spirvPath, current) && current == spirv)
+		{
+			return false;
+		}
+		writeFile(spirvPath, spirv.data(), spirv.size());
+		return true;
+	}
+
+	std::vector<std::string> LveShaderCompiler::compileDirectory(const std::string& directory)
+	{
+		std::vector<std::string> changed;
+		std::error_code error;
+		for (auto& entry : std::filesystem::directory_iterator(directory, error))
+		{
+			std::string sourcePath = entry.path().generic_string();
+			if (!entry.is_regular_file() || !isShaderStage(sourcePath)) continue;
+
+			try
+			{
+				if (compile(sourcePath))
+				{
+					changed.push_back(entry.path().filename().string());
+				}
+			}
+			catch (const std::runtime_error& e)
+			{
+				std::cout << "Shader compile failed, keeping the previous version: " << e.what() << std::endl;
+			}
+		}
+		if (error)
+		{
+			throw std::runtime_error("Failed to read shader directory: " + directory);
+		}
+		return changed;
+	}
+
+	LveShaderCompiler::Stats LveShaderCompiler::getStats()
+	{
+		std::lock_guard<std::mutex> lock{ mutex };
+		return stats;
+	}
+}
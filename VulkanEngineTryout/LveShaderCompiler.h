@@ -0,0 +1,54 @@
+#pragma once
+
+#include <shaderc/shaderc.hpp>
+
+// std
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace lve {
+
+	// GLSL to SPIR-V in the engine (libshaderc), so no platform specific build step is needed.
+	// Results are kept in a disk cache keyed by a hash of the preprocessed source, the defines and the
+	// compiler, an unchanged shader is only preprocessed, never compiled again.
+	class LveShaderCompiler
+	{
+	public:
+		using Defines = std::vector<std::pair<std::string, std::string>>;
+
+		struct Stats {
+			uint32_t compiled = 0;
+			uint32_t cached = 0;
+		};
+
+		static constexpr const char* CACHE_DIRECTORY = "shader_cache";
+
+		explicit LveShaderCompiler(const std::string& cacheDirectory = CACHE_DIRECTORY);
+
+		LveShaderCompiler(const LveShaderCompiler&) = delete;
+		LveShaderCompiler& operator=(const LveShaderCompiler&) = delete;
+
+		// Writes sourcePath + ".spv", the stage comes from the extension. True when the .spv changed.
+		// Throws std::runtime_error with the compiler messages when the shader does not compile. Thread safe.
+		bool compile(const std::string& sourcePath, const Defines& defines = {});
+		// Every shader in directory. Returns the sources whose .spv changed, failures are reported on
+		// std::cout and keep their previous .spv.
+		std::vector<std::string> compileDirectory(const std::string& directory);
+
+		// .vert, .frag or .comp
+		static bool isShaderStage(const std::string& filePath);
+
+		Stats getStats();
+
+	private:
+		std::string cacheDirectory;
+		shaderc::Compiler compiler;
+		uint32_t spirvVersion = 0;
+		uint32_t spirvRevision = 0;
+
+		std::mutex mutex;
+		Stats stats{};
+	};
+}
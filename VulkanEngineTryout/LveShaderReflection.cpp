@@ -0,0 +1,500 @@
+#include "LveShaderReflection.h"
+
+// std
+#include <algorithm>
+#include <stdexcept>
+
+namespace lve {
+
+	namespace {
+		constexpr uint32_t SPIRV_MAGIC = 0x07230203;
+		constexpr size_t SPIRV_HEADER_WORDS = 5;
+
+		// Opcodes, decorations and enums of the SPIR-V specification that reflection needs
+		enum Op : uint32_t {
+			OpEntryPoint = 15,
+			OpTypeBool = 20,
+			OpTypeInt = 21,
+			OpTypeFloat = 22,
+			OpTypeVector = 23,
+			OpTypeMatrix = 24,
+			OpTypeImage = 25,
+			OpTypeSampler = 26,
+			OpTypeSampledImage = 27,
+			OpTypeArray = 28,
+			OpTypeRuntimeArray = 29,
+			OpTypeStruct = 30,
+			OpTypePointer = 32,
+			OpConstant = 43,
+			OpSpecConstant = 50,
+			OpVariable = 59,
+			OpDecorate = 71,
+			OpMemberDecorate = 72,
+			OpTypeAccelerationStructureKHR = 5341,
+		};
+
+		enum Decoration : uint32_t {
+			DecorationBlock = 2,
+			DecorationBufferBlock = 3,
+			DecorationArrayStride = 6,
+			DecorationMatrixStride = 7,
+			DecorationBuiltIn = 11,
+			DecorationLocation = 30,
+			DecorationBinding = 33,
+			DecorationDescriptorSet = 34,
+			DecorationOffset = 35,
+		};
+
+		enum StorageClass : uint32_t {
+			StorageClassUniformConstant = 0,
+			StorageClassInput = 1,
+			StorageClassUniform = 2,
+			StorageClassPushConstant = 9,
+			StorageClassStorageBuffer = 12,
+		};
+
+		constexpr uint32_t DIM_BUFFER = 5;
+		constexpr uint32_t DIM_SUBPASS_DATA = 6;
+		constexpr uint32_t IMAGE_STORAGE = 2;  // "sampled" operand of OpTypeImage
+
+		VkShaderStageFlagBits executionModelStage(uint32_t executionModel)
+		{
+			switch (executionModel)
+			{
+			case 0: return VK_SHADER_STAGE_VERTEX_BIT;
+			case 1: return VK_SHADER_STAGE_TESSELLATION_CONTROL_BIT;
+			case 2: return VK_SHADER_STAGE_TESSELLATION_EVALUATION_BIT;
+			case 3: return VK_SHADER_STAGE_GEOMETRY_BIT;
+			case 4: return VK_SHADER_STAGE_FRAGMENT_BIT;
+			case 5: return VK_SHADER_STAGE_COMPUTE_BIT;
+			default: return static_cast<VkShaderStageFlagBits>(0);
+			}
+		}
+
+		// 32 bit vertex formats by component type (float, signed, unsigned) and component count
+		constexpr VkFormat VERTEX_FORMATS[3][4] = {
+			{ VK_FORMAT_R32_SFLOAT, VK_FORMAT_R32G32_SFLOAT, VK_FORMAT_R32G32B32_SFLOAT, VK_FORMAT_R32G32B32A32_SFLOAT },
+			{ VK_FORMAT_R32_SINT, VK_FORMAT_R32G32_SINT, VK_FORMAT_R32G32B32_SINT, VK_FORMAT_R32G32B32A32_SINT },
+			{ VK_FORMAT_R32_UINT, VK_FORMAT_R32G32_UINT, VK_FORMAT_R32G32B32_UINT, VK_FORMAT_R32G32B32A32_UINT },
+		};
+
+		// Row of VERTEX_FORMATS, or -1 for formats outside the table
+		int vertexFormatClass(VkFormat format)
+		{
+			for (int i = 0; i < 3; i++)
+			{
+				if (std::find(std::begin(VERTEX_FORMATS[i]), std::end(VERTEX_FORMATS[i]), format) != std::end(VERTEX_FORMATS[i])) return i;
+			}
+			return -1;
+		}
+
+		// The declarations of one module, indexed by result id
+		struct Module {
+			struct Type {
+				uint32_t opcode;
+				std::vector<uint32_t> operands;  // the words after the result id
+			};
+
+			struct Variable {
+				uint32_t id;
+				uint32_t pointerType;
+				uint32_t storageClass;
+			};
+
+			std::unordered_map<uint32_t, Type> types;
+			std::unordered_map<uint32_t, uint32_t> constants;  // first word of the value
+			std::unordered_map<uint32_t, std::unordered_map<uint32_t, uint32_t>> decorations;
+			std::unordered_map<uint32_t, std::vector<std::unordered_map<uint32_t, uint32_t>>> memberDecorations;
+			std::vector<Variable> variables;
+
+			const Type& type(uint32_t id) const
+			{
+				auto found = types.find(id);
+				if (found == types.end())
+				{
+					throw std::runtime_error("SPIR-V references an undeclared type");
+				}
+				return found->second;
+			}
+
+			bool hasDecoration(uint32_t id, uint32_t decoration) const
+			{
+				auto found = decorations.find(id);
+				return found != decorations.end() && found->second.count(decoration) != 0;
+			}
+
+			uint32_t decoration(uint32_t id, uint32_t decoration, uint32_t fallback) const
+			{
+				auto found = decorations.find(id);
+				if (found == decorations.end()) return fallback;
+				auto value = found->second.find(decoration);
+				return value != found->second.end() ? value->second : fallback;
+			}
+
+			uint32_t memberDecoration(uint32_t structId, uint32_t member, uint32_t decoration, uint32_t fallback) const
+			{
+				auto found = memberDecorations.find(structId);
+				if (found == memberDecorations.end() || member >= found->second.size()) return fallback;
+				auto value = found->second[member].find(decoration);
+				return value != found->second[member].end() ? value->second : fallback;
+			}
+
+			// Array lengths may be specialization constants, their default is used
+			uint32_t arrayLength(const Type& array) const
+			{
+				auto found = constants.find(array.operands[1]);
+				return found != constants.end() ? found->second : 1;
+			}
+
+			// Bytes the type occupies with its explicit layout, matrixStride comes from the enclosing member
+			uint32_t size(uint32_t id, uint32_t matrixStride = 0) const
+			{
+				const Type& t = type(id);
+				switch (t.opcode)
+				{
+				case OpTypeBool:
+					return 4;
+				case OpTypeInt:
+				case OpTypeFloat:
+					return t.operands[0] / 8;
+				case OpTypeVector:
+					return t.operands[1] * size(t.operands[0]);
+				case OpTypeMatrix:
+					return t.operands[1] * (matrixStride != 0 ? matrixStride : size(t.operands[0]));
+				case OpTypeArray:
+					return arrayLength(t) * decoration(id, DecorationArrayStride, size(t.operands[0], matrixStride));
+				case OpTypeRuntimeArray:
+					return 0;
+				case OpTypeStruct:
+				{
+					uint32_t end = 0;
+					for (uint32_t member = 0; member < t.operands.size(); member++)
+					{
+						uint32_t offset = memberDecoration(id, member, DecorationOffset, 0);
+						uint32_t stride = memberDecoration(id, member, DecorationMatrixStride, 0);
+						end = std::max(end, offset + size(t.operands[member], stride));
+					}
+					return end;
+				}
+				case OpTypePointer:
+					return 8;  // physical storage buffer address
+				default:
+					throw std::runtime_error("SPIR-V type without a size in an explicit layout");
+				}
+			}
+		};
+	}
+
+	LveShaderReflection::LveShaderReflection(const uint32_t* code, size_t wordCount)
+	{
+		parse(code, wordCount);
+	}
+
+	void LveShaderReflection::parse(const uint32_t* code, size_t wordCount)
+	{
+		if (wordCount < SPIRV_HEADER_WORDS || code[0] != SPIRV_MAGIC)
+		{
+			throw std::runtime_error("Not a SPIR-V module");
+		}
+
+		Module module;
+		for (size_t i = SPIRV_HEADER_WORDS; i < wordCount;)
+		{
+			uint32_t instructionWords = code[i] >> 16;
+			uint32_t opcode = code[i] & 0xffff;
+			if (instructionWords == 0 || i + instructionWords > wordCount)
+			{
+				throw std::runtime_error("Truncated SPIR-V module");
+			}
+			const uint32_t* operands = code + i + 1;
+			uint32_t operandCount = instructionWords - 1;
+			i += instructionWords;
+
+			switch (opcode)
+			{
+			case OpEntryPoint:
+				if (operandCount >= 1) stages |= executionModelStage(operands[0]);
+				break;
+			case OpTypeBool:
+			case OpTypeInt:
+			case OpTypeFloat:
+			case OpTypeVector:
+			case OpTypeMatrix:
+			case OpTypeImage:
+			case OpTypeSampler:
+			case OpTypeSampledImage:
+			case OpTypeArray:
+			case OpTypeRuntimeArray:
+			case OpTypeStruct:
+			case OpTypePointer:
+			case OpTypeAccelerationStructureKHR:
+				if (operandCount >= 1) module.types[operands[0]] = { opcode, std::vector<uint32_t>(operands + 1, operands + operandCount) };
+				break;
+			case OpConstant:
+			case OpSpecConstant:
+				if (operandCount >= 3) module.constants[operands[1]] = operands[2];
+				break;
+			case OpVariable:
+				if (operandCount >= 3) module.variables.push_back({ operands[1], operands[0], operands[2] });
+				break;
+			case OpDecorate:
+				if (operandCount >= 2) module.decorations[operands[0]][operands[1]] = operandCount >= 3 ? operands[2] : 0;
+				break;
+			case OpMemberDecorate:
+				if (operandCount >= 3)
+				{
+					auto& members = module.memberDecorations[operands[0]];
+					if (members.size() <= operands[1]) members.resize(operands[1] + 1);
+					members[operands[1]][operands[2]] = operandCount >= 4 ? operands[3] : 0;
+				}
+				break;
+			default:
+				break;
+			}
+		}
+
+		for (const auto& variable : module.variables)
+		{
+			const auto& pointer = module.type(variable.pointerType);
+			uint32_t typeId = pointer.operands[1];
+
+			switch (variable.storageClass)
+			{
+			case StorageClassUniformConstant:
+			case StorageClassUniform:
+			case StorageClassStorageBuffer:
+			{
+				if (!module.hasDecoration(variable.id, DecorationDescriptorSet) || !module.hasDecoration(variable.id, DecorationBinding)) break;
+
+				DescriptorBinding binding{};
+				binding.set = module.decoration(variable.id, DecorationDescriptorSet, 0);
+				binding.binding = module.decoration(variable.id, DecorationBinding, 0);
+				binding.count = 1;
+				binding.stages = stages;
+
+				const Module::Type* type = &module.type(typeId);
+				while (type->opcode == OpTypeArray || type->opcode == OpTypeRuntimeArray)
+				{
+					binding.count = type->opcode == OpTypeArray ? binding.count * module.arrayLength(*type) : 0;
+					typeId = type->operands[0];
+					type = &module.type(typeId);
+				}
+
+				switch (type->opcode)
+				{
+				case OpTypeSampler:
+					binding.type = VK_DESCRIPTOR_TYPE_SAMPLER;
+					break;
+				case OpTypeSampledImage:
+					binding.type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+					break;
+				case OpTypeImage:
+				{
+					uint32_t dim = type->operands[1];
+					bool storage = type->operands[5] == IMAGE_STORAGE;
+					if (dim == DIM_BUFFER) binding.type = storage ? VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER : VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER;
+					else if (dim == DIM_SUBPASS_DATA) binding.type = VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT;
+					else binding.type = storage ? VK_DESCRIPTOR_TYPE_STORAGE_IMAGE : VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+					break;
+				}
+				case OpTypeAccelerationStructureKHR:
+					binding.type = VK_DESCRIPTOR_TYPE_ACCELERATION_STRUCTURE_KHR;
+					break;
+				case OpTypeStruct:
+					// Before SPIR-V 1.3 storage buffers are Uniform blocks decorated BufferBlock
+					binding.type = variable.storageClass == StorageClassStorageBuffer || module.hasDecoration(typeId, DecorationBufferBlock)
+						? VK_DESCRIPTOR_TYPE_STORAGE_BUFFER
+						: VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+					break;
+				default:
+					throw std::runtime_error("SPIR-V descriptor of an unsupported type");
+				}
+				bindings.push_back(binding);
+				break;
+			}
+			case StorageClassPushConstant:
+			{
+				const auto& block = module.type(typeId);
+				uint32_t offset = UINT32_MAX;
+				for (uint32_t member = 0; member < block.operands.size(); member++)
+				{
+					offset = std::min(offset, module.memberDecoration(typeId, member, DecorationOffset, 0));
+				}
+				if (offset == UINT32_MAX) break;
+
+				pushConstantStages = stages;
+				pushConstantOffset = offset;
+				pushConstantSize = module.size(typeId) - offset;
+				break;
+			}
+			case StorageClassInput:
+			{
+				if ((stages & VK_SHADER_STAGE_VERTEX_BIT) == 0 || !module.hasDecoration(variable.id, DecorationLocation)) break;
+				if (module.hasDecoration(variable.id, DecorationBuiltIn)) break;
+
+				uint32_t location = module.decoration(variable.id, DecorationLocation, 0);
+				uint32_t repeat = 1;
+				const Module::Type* type = &module.type(typeId);
+				// Arrays and matrix columns take one location each
+				while (type->opcode == OpTypeArray || type->opcode == OpTypeMatrix)
+				{
+					repeat *= type->opcode == OpTypeArray ? module.arrayLength(*type) : type->operands[1];
+					type = &module.type(type->operands[0]);
+				}
+
+				uint32_t componentCount = 1;
+				if (type->opcode == OpTypeVector)
+				{
+					componentCount = type->operands[1];
+					type = &module.type(type->operands[0]);
+				}
+
+				VkFormat format = VK_FORMAT_UNDEFINED;
+				if ((type->opcode == OpTypeFloat || type->opcode == OpTypeInt) && type->operands[0] == 32 && componentCount <= 4)
+				{
+					int formatClass = type->opcode == OpTypeFloat ? 0 : (type->operands[1] != 0 ? 1 : 2);
+					format = VERTEX_FORMATS[formatClass][componentCount - 1];
+				}
+
+				for (uint32_t i = 0; i < repeat; i++)
+				{
+					vertexInputs.push_back({ location + i, format });
+				}
+				break;
+			}
+			default:
+				break;
+			}
+		}
+
+		std::sort(bindings.begin(), bindings.end(), [](const DescriptorBinding& a, const DescriptorBinding& b) {
+			return a.set != b.set ? a.set < b.set : a.binding < b.binding;
+		});
+		std::sort(vertexInputs.begin(), vertexInputs.end(), [](const VertexInput& a, const VertexInput& b) { return a.location < b.location; });
+	}
+
+	void LveShaderReflection::merge(const LveShaderReflection& other)
+	{
+		stages |= other.stages;
+
+		for (const auto& binding : other.bindings)
+		{
+			auto existing = std::find_if(bindings.begin(), bindings.end(), [&](const DescriptorBinding& b) {
+				return b.set == binding.set && b.binding == binding.binding;
+			});
+			if (existing == bindings.end())
+			{
+				bindings.push_back(binding);
+				continue;
+			}
+			if (existing->type != binding.type || existing->count != binding.count)
+			{
+				throw std::runtime_error("Shader stages declare set " + std::to_string(binding.set) + " binding " + std::to_string(binding.binding) + " differently");
+			}
+			existing->stages |= binding.stages;
+		}
+		std::sort(bindings.begin(), bindings.end(), [](const DescriptorBinding& a, const DescriptorBinding& b) {
+			return a.set != b.set ? a.set < b.set : a.binding < b.binding;
+		});
+
+		// One range covering every stage's block, the stages usually share a single push constant struct
+		if (other.pushConstantSize != 0)
+		{
+			if (pushConstantSize == 0)
+			{
+				pushConstantOffset = other.pushConstantOffset;
+				pushConstantSize = other.pushConstantSize;
+			}
+			else
+			{
+				uint32_t end = std::max(pushConstantOffset + pushConstantSize, other.pushConstantOffset + other.pushConstantSize);
+				pushConstantOffset = std::min(pushConstantOffset, other.pushConstantOffset);
+				pushConstantSize = end - pushConstantOffset;
+			}
+			pushConstantStages |= other.pushConstantStages;
+		}
+
+		if (!other.vertexInputs.empty())
+		{
+			vertexInputs = other.vertexInputs;
+		}
+	}
+
+	uint32_t LveShaderReflection::getSetCount() const
+	{
+		return bindings.empty() ? 0 : bindings.back().set + 1;
+	}
+
+	std::vector<VkDescriptorSetLayoutBinding> LveShaderReflection::getSetBindings(uint32_t set, uint32_t maxRuntimeCount) const
+	{
+		std::vector<VkDescriptorSetLayoutBinding> setBindings;
+		for (const auto& binding : bindings)
+		{
+			if (binding.set != set) continue;
+
+			VkDescriptorSetLayoutBinding layoutBinding{};
+			layoutBinding.binding = binding.binding;
+			layoutBinding.descriptorType = binding.type;
+			layoutBinding.descriptorCount = binding.count != 0 ? binding.count : maxRuntimeCount;
+			layoutBinding.stageFlags = binding.stages;
+			setBindings.push_back(layoutBinding);
+		}
+		return setBindings;
+	}
+
+	std::vector<VkPushConstantRange> LveShaderReflection::getPushConstantRanges() const
+	{
+		if (pushConstantSize == 0) return {};
+		return { { pushConstantStages, pushConstantOffset, pushConstantSize } };
+	}
+
+	std::string LveShaderReflection::checkSetBindings(uint32_t set, const std::unordered_map<uint32_t, VkDescriptorSetLayoutBinding>& layoutBindings) const
+	{
+		for (const auto& binding : bindings)
+		{
+			if (binding.set != set) continue;
+
+			std::string name = "set " + std::to_string(set) + " binding " + std::to_string(binding.binding);
+			auto found = layoutBindings.find(binding.binding);
+			if (found == layoutBindings.end())
+			{
+				return name + " is missing from the layout";
+			}
+			const auto& layoutBinding = found->second;
+			if (layoutBinding.descriptorType != binding.type)
+			{
+				return name + " has a different descriptor type in the layout";
+			}
+			if ((layoutBinding.stageFlags & binding.stages) != binding.stages)
+			{
+				return name + " is not visible to every stage using it";
+			}
+			if (layoutBinding.descriptorCount < binding.count)
+			{
+				return name + " has fewer descriptors in the layout than the shader declares";
+			}
+		}
+		return "";
+	}
+
+	std::string LveShaderReflection::checkVertexInput(const std::vector<VkVertexInputAttributeDescription>& attributes) const
+	{
+		for (const auto& input : vertexInputs)
+		{
+			auto attribute = std::find_if(attributes.begin(), attributes.end(), [&](const VkVertexInputAttributeDescription& a) { return a.location == input.location; });
+			if (attribute == attributes.end())
+			{
+				return "no vertex attribute for location " + std::to_string(input.location);
+			}
+
+			// Component counts may differ, missing components are filled in. The numeric type has to match.
+			int expected = vertexFormatClass(input.format);
+			int actual = vertexFormatClass(attribute->format);
+			if (expected >= 0 && actual >= 0 && expected != actual)
+			{
+				return "vertex attribute at location " + std::to_string(input.location) + " has a different numeric type than the shader input";
+			}
+		}
+		return "";
+	}
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+// std
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace lve {
+
+	// What a SPIR-V module expects from the pipeline: its descriptor bindings, push constant range and vertex
+	// inputs, read from the decorations in the binary. Lets layouts be built from the shaders instead of being
+	// written next to them by hand, and catches hand-written state that does not match.
+	class LveShaderReflection
+	{
+	public:
+		struct DescriptorBinding {
+			uint32_t set;
+			uint32_t binding;
+			VkDescriptorType type;
+			uint32_t count;  // 0 for runtime sized arrays
+			VkShaderStageFlags stages;
+		};
+
+		struct VertexInput {
+			uint32_t location;
+			VkFormat format;  // the 32 bit format matching the shader type, undefined for types without one
+		};
+
+		LveShaderReflection() = default;
+		// Throws std::runtime_error for malformed SPIR-V
+		LveShaderReflection(const uint32_t* code, size_t wordCount);
+
+		// Combines the stages of one pipeline, bindings used by several stages get all of their stage flags
+		void merge(const LveShaderReflection& other);
+
+		VkShaderStageFlags getStages() const { return stages; }
+		// Sorted by set and binding
+		const std::vector<DescriptorBinding>& getBindings() const { return bindings; }
+		// One past the highest set used
+		uint32_t getSetCount() const;
+		// Runtime sized arrays get maxRuntimeCount descriptors
+		std::vector<VkDescriptorSetLayoutBinding> getSetBindings(uint32_t set, uint32_t maxRuntimeCount = 1) const;
+		// Empty when no stage has push constants
+		std::vector<VkPushConstantRange> getPushConstantRanges() const;
+		// Sorted by location, vertex stage only
+		const std::vector<VertexInput>& getVertexInputs() const { return vertexInputs; }
+
+		// Whether a layout with layoutBindings can back every binding of set, an empty string if so
+		std::string checkSetBindings(uint32_t set, const std::unordered_map<uint32_t, VkDescriptorSetLayoutBinding>& layoutBindings) const;
+		// Whether attributes feed every vertex input, an empty string if so. Formats are only compared when both
+		// are plain 32 bit formats, then their numeric type (float, signed, unsigned) has to match.
+		std::string checkVertexInput(const std::vector<VkVertexInputAttributeDescription>& attributes) const;
+
+	private:
+		void parse(const uint32_t* code, size_t wordCount);
+
+		VkShaderStageFlags stages = 0;
+		std::vector<DescriptorBinding> bindings;
+		VkShaderStageFlags pushConstantStages = 0;
+		uint32_t pushConstantOffset = 0;
+		uint32_t pushConstantSize = 0;
+		std::vector<VertexInput> vertexInputs;
+	};
+}
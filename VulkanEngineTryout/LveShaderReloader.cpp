@@ -0,0 +1,48 @@
+#include "LveShaderReloader.h"
+
+// std
+#include <chrono>
+#include <filesystem>
+
+namespace lve {
+
+	LveShaderReloader::LveShaderReloader(const std::string& shaderDirectory, LveShaderCompiler& shaderCompiler)
+		: directory{ shaderDirectory }, compiler{ shaderCompiler }, watcher{ shaderDirectory }
+	{
+	}
+
+	LveShaderReloader::~LveShaderReloader()
+	{
+		if (running.valid()) running.wait();
+	}
+
+	bool LveShaderReloader::isShaderSource(const std::string& fileName)
+	{
+		// Compiling writes .spv files into the same directory, only sources and their includes start a compile
+		std::string extension = std::filesystem::path(fileName).extension().string();
+		return LveShaderCompiler::isShaderStage(fileName) || extension == ".glsl";
+	}
+
+	std::vector<std::string> LveShaderReloader::poll()
+	{
+		for (auto& fileName : watcher.poll())
+		{
+			sourcesChanged |= isShaderSource(fileName);
+		}
+
+		std::vector<std::string> compiled;
+		if (running.valid() && running.wait_for(std::chrono::seconds(0)) == std::future_status::ready)
+		{
+			compiled = running.get();
+		}
+
+		// One compile at a time, sources saved meanwhile go into the next one
+		if (!running.valid() && sourcesChanged)
+		{
+			running = std::async(std::launch::async, [this]() { return compiler.compileDirectory(directory); });
+			sourcesChanged = false;
+		}
+		return compiled;
+	}
+
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include "LveFileWatcher.h"
+#include "LveShaderCompiler.h"
+
+// std
+#include <future>
+#include <string>
+#include <vector>
+
+namespace lve {
+
+	// Recompiles the GLSL sources of a shader directory to <source>.spv when they are saved, on a thread of
+	// its own so frames keep going. A source that fails to compile keeps its previous SPIR-V.
+	// Any save recompiles the whole directory, so shaders including the saved file are rebuilt as well,
+	// the compiler cache keeps that down to preprocessing for the others.
+	class LveShaderReloader
+	{
+	public:
+		LveShaderReloader(const std::string& shaderDirectory, LveShaderCompiler& shaderCompiler);
+		// Waits for a running compile
+		~LveShaderReloader();
+
+		LveShaderReloader(const LveShaderReloader&) = delete;
+		LveShaderReloader& operator=(const LveShaderReloader&) = delete;
+
+		// Call once per frame. Sources whose SPIR-V was rebuilt since the last call, empty while nothing changed.
+		std::vector<std::string> poll();
+
+	private:
+		static bool isShaderSource(const std::string& fileName);
+
+		std::string directory;
+		LveShaderCompiler& compiler;
+		LveFileWatcher watcher;
+		bool sourcesChanged = false;  // saved while a compile was running
+		std::future<std::vector<std::string>> running;
+	};
+}
@@ -0,0 +1,59 @@
+#include "LveSpecialization.h"
+
+// std
+#include <algorithm>
+
+namespace lve {
+
+	VkSpecializationInfo LveSpecialization::getInfo() const
+	{
+		VkSpecializationInfo info{};
+		info.mapEntryCount = static_cast<uint32_t>(entries.size());
+		info.pMapEntries = entries.data();
+		info.dataSize = data.size() * sizeof(uint32_t);
+		info.pData = data.data();
+		return info;
+	}
+
+	const VkSpecializationInfo* LveSpecialization::getInfo(VkSpecializationInfo& info) const
+	{
+		if (empty())
+		{
+			return nullptr;
+		}
+		info = getInfo();
+		return &info;
+	}
+
+	std::string LveSpecialization::getKey() const
+	{
+		std::string key;
+		for (size_t i = 0; i < entries.size(); i++)
+		{
+			key.append(reinterpret_cast<const char*>(&entries[i].constantID), sizeof(uint32_t));
+			key.append(reinterpret_cast<const char*>(&data[i]), sizeof(uint32_t));
+		}
+		return key;
+	}
+
+	void LveSpecialization::setWord(uint32_t id, uint32_t word)
+	{
+		auto entry = std::lower_bound(entries.begin(), entries.end(), id,
+			[](const VkSpecializationMapEntry& existing, uint32_t constantID) { return existing.constantID < constantID; });
+		size_t index = static_cast<size_t>(entry - entries.begin());
+
+		if (entry != entries.end() && entry->constantID == id)
+		{
+			data[index] = word;
+			return;
+		}
+
+		entries.insert(entry, VkSpecializationMapEntry{ id, 0, sizeof(uint32_t) });
+		data.insert(data.begin() + index, word);
+		// Entries are kept in the same order as their values
+		for (size_t i = index; i < entries.size(); i++)
+		{
+			entries[i].offset = static_cast<uint32_t>(i * sizeof(uint32_t));
+		}
+	}
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+// std
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace lve {
+	// A layout (constant_id = id) declaration of a shader, T is the GLSL type: bool, int32_t, uint32_t or float
+	template<typename T>
+	struct LveSpecializationConstant {
+		static_assert(std::is_same<T, bool>::value || std::is_same<T, int32_t>::value || std::is_same<T, uint32_t>::value || std::is_same<T, float>::value,
+			"Specialization constants are bool, int, uint or float");
+		using Type = T;
+		uint32_t id;
+	};
+
+	// Specialization constant values of one shader stage. Constants that are not set keep the default from the shader.
+	class LveSpecialization
+	{
+	public:
+		// The value is not deduced, so literals convert to the type of the constant
+		template<typename T>
+		LveSpecialization& set(LveSpecializationConstant<T> constant, typename LveSpecializationConstant<T>::Type value)
+		{
+			uint32_t word;
+			if constexpr (std::is_same<T, bool>::value)
+			{
+				VkBool32 boolValue = value ? VK_TRUE : VK_FALSE;
+				word = boolValue;
+			}
+			else
+			{
+				static_assert(sizeof(T) == sizeof(uint32_t), "Specialization constants are 32 bit");
+				std::memcpy(&word, &value, sizeof(word));
+			}
+			setWord(constant.id, word);
+			return *this;
+		}
+
+		bool empty() const { return entries.empty(); }
+
+		// Points into this object, which has to stay alive and unchanged until the pipeline is created
+		VkSpecializationInfo getInfo() const;
+		// nullptr without constants, otherwise info filled by getInfo
+		const VkSpecializationInfo* getInfo(VkSpecializationInfo& info) const;
+
+		// Equal for equal values, whatever order they were set in
+		std::string getKey() const;
+
+	private:
+		void setWord(uint32_t id, uint32_t word);
+
+		std::vector<VkSpecializationMapEntry> entries;  // ordered by constantID
+		std::vector<uint32_t> data;
+	};
+}
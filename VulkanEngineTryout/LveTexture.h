@@ -0,0 +1,32 @@
+#pragma once
+
+#include "LveDevice.h"
+
+namespace lve {
+	// Sampled 2D RGBA8 image with a single mip level, uploaded once through a staging buffer
+	class LveTexture
+	{
+	public:
+		LveTexture(LveDevice& device, uint32_t width, uint32_t height, const void* rgbaPixels, VkFormat format = VK_FORMAT_R8G8B8A8_SRGB);
+		~LveTexture();
+
+		LveTexture(const LveTexture&) = delete;
+		LveTexture& operator=(const LveTexture&) = delete;
+
+		VkImageView getImageView() const { return imageView; }
+		VkImageLayout getImageLayout() const { return VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL; }
+		VkExtent2D getExtent() const { return extent; }
+
+	private:
+		void createImage(VkFormat format);
+		void upload(const void* rgbaPixels);
+		void transitionLayout(VkImageLayout oldLayout, VkImageLayout newLayout);
+
+		LveDevice& lveDevice;
+		VkExtent2D extent;
+
+		VkImage image;
+		VkDeviceMemory imageMemory;
+		VkImageView imageView;
+	};
+}
@@ -0,0 +1,134 @@
+#include "LveThreadPool.h"
+
+// std
+#include <algorithm>
+#include <exception>
+
+namespace lve {
+
+	LveThreadPool::LveThreadPool(uint32_t threadCount)
+	{
+		threadCount = std::max(1u, threadCount);
+		workers.reserve(threadCount);
+		for (uint32_t i = 0; i < threadCount; i++)
+		{
+			workers.emplace_back(&LveThreadPool::workerLoop, this);
+		}
+	}
+
+	LveThreadPool::~LveThreadPool()
+	{
+		{
+			std::lock_guard<std::mutex> lock{ mutex };
+			stopping = true;
+		}
+		taskAvailable.notify_all();
+
+		for (auto& worker : workers)
+		{
+			worker.join();
+		}
+	}
+
+	uint32_t LveThreadPool::defaultThreadCount()
+	{
+		uint32_t hardwareThreads = std::thread::hardware_concurrency();
+		return hardwareThreads > 1 ? hardwareThreads - 1 : 1;
+	}
+
+	void LveThreadPool::submit(std::function<void()> task)
+	{
+		{
+			std::lock_guard<std::mutex> lock{ mutex };
+			tasks.push(std::move(task));
+			pendingTasks++;
+		}
+		taskAvailable.notify_one();
+	}
+
+	void LveThreadPool::wait()
+	{
+		std::unique_lock<std::mutex> lock{ mutex };
+		allTasksFinished.wait(lock, [this]() { return pendingTasks == 0; });
+	}
+
+	void LveThreadPool::parallelFor(uint32_t count, const std::function<void(uint32_t)>& task)
+	{
+		if (count == 0)
+		{
+			return;
+		}
+
+		std::mutex doneMutex;
+		std::condition_variable done;
+		uint32_t remaining = count;
+		std::exception_ptr firstError;
+
+		for (uint32_t i = 0; i < count; i++)
+		{
+			submit([&, i]()
+				{
+					std::exception_ptr error;
+					try
+					{
+						task(i);
+					}
+					catch (...)
+					{
+						error = std::current_exception();
+					}
+
+					std::lock_guard<std::mutex> lock{ doneMutex };
+					if (error && !firstError)
+					{
+						firstError = error;
+					}
+					if (--remaining == 0)
+					{
+						done.notify_one();
+					}
+				});
+		}
+
+		{
+			std::unique_lock<std::mutex> lock{ doneMutex };
+			done.wait(lock, [&]() { return remaining == 0; });
+		}
+
+		// Rethrown on the calling thread, an exception escaping a worker would terminate the program
+		if (firstError)
+		{
+			std::rethrow_exception(firstError);
+		}
+	}
+
+	void LveThreadPool::workerLoop()
+	{
+		while (true)
+		{
+			std::function<void()> task;
+			{
+				std::unique_lock<std::mutex> lock{ mutex };
+				taskAvailable.wait(lock, [this]() { return stopping || !tasks.empty(); });
+				if (stopping && tasks.empty())
+				{
+					return;
+				}
+
+				task = std::move(tasks.front());
+				tasks.pop();
+			}
+
+			task();
+
+			{
+				std::lock_guard<std::mutex> lock{ mutex };
+				pendingTasks--;
+				if (pendingTasks == 0)
+				{
+					allTasksFinished.notify_all();
+				}
+			}
+		}
+	}
+}
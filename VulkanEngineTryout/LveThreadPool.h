@@ -0,0 +1,47 @@
+#pragma once
+
+// std
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+namespace lve {
+	class LveThreadPool
+	{
+	public:
+		explicit LveThreadPool(uint32_t threadCount = defaultThreadCount());
+		~LveThreadPool();
+
+		LveThreadPool(const LveThreadPool&) = delete;
+		LveThreadPool& operator=(const LveThreadPool&) = delete;
+
+		// All hardware threads but the main one, at least one
+		static uint32_t defaultThreadCount();
+
+		uint32_t size() const { return static_cast<uint32_t>(workers.size()); }
+
+		void submit(std::function<void()> task);
+		// Blocks until every submitted task has finished
+		void wait();
+
+		// Runs task(0) .. task(count - 1) on the workers and blocks until those have finished,
+		// tasks submitted by others are not waited for. The first exception thrown by a task is rethrown here.
+		void parallelFor(uint32_t count, const std::function<void(uint32_t)>& task);
+
+	private:
+		void workerLoop();
+
+		std::vector<std::thread> workers;
+		std::queue<std::function<void()>> tasks;
+
+		std::mutex mutex;
+		std::condition_variable taskAvailable;
+		std::condition_variable allTasksFinished;
+		uint32_t pendingTasks = 0;
+		bool stopping = false;
+	};
+}
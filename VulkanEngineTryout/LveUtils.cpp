@@ -1 +1,53 @@
 #include "LveUtils.h"
+
+// std
+#include <array>
+#include <utility>
+
+namespace lve {
+
+	void radixSort(std::vector<SortItem>& items, std::vector<SortItem>& scratch)
+	{
+		constexpr int passCount = sizeof(uint64_t);
+		const size_t count = items.size();
+		if (count < 2)
+		{
+			return;
+		}
+
+		// Histograms for all passes in a single read of the keys
+		std::array<std::array<uint32_t, 256>, passCount> histograms{};
+		for (const auto& item : items)
+		{
+			for (int pass = 0; pass < passCount; pass++)
+			{
+				histograms[pass][(item.key >> (pass * 8)) & 0xFF]++;
+			}
+		}
+
+		scratch.resize(count);
+		for (int pass = 0; pass < passCount; pass++)
+		{
+			auto& histogram = histograms[pass];
+			const uint32_t firstDigit = (items[0].key >> (pass * 8)) & 0xFF;
+			if (histogram[firstDigit] == count)
+			{
+				continue;
+			}
+
+			uint32_t offset = 0;
+			for (auto& bucket : histogram)
+			{
+				uint32_t bucketCount = bucket;
+				bucket = offset;
+				offset += bucketCount;
+			}
+
+			for (const auto& item : items)
+			{
+				scratch[histogram[(item.key >> (pass * 8)) & 0xFF]++] = item;
+			}
+			std::swap(items, scratch);
+		}
+	}
+}
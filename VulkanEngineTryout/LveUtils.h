@@ -1,6 +1,8 @@
 #pragma once
 
+#include <cstdint>
 #include <functional>
+#include <vector>
 
 namespace lve {
 	template<typename T, typename... Rest>
@@ -10,5 +12,13 @@ namespace lve {
 		seed ^= std::hash<T>{}(v)+0x9e3779b9 + (seed << 6) + (seed >> 2);
 		(hashCombine(seed, rest), ...);
 	};
-}
 
+	struct SortItem {
+		uint64_t key;
+		uint32_t value;
+	};
+
+	// Stable LSD radix sort on the 64 bit keys, one byte per pass. Passes where every key has
+	// the same byte are skipped, so unused high bits cost nothing. scratch is resized as needed.
+	void radixSort(std::vector<SortItem>& items, std::vector<SortItem>& scratch);
+}
@@ -5,20 +5,26 @@
 namespace lve {
 
 
-	LveWindow::LveWindow(int w, int h, std::string name) : width{ w }, height{ h }, windowName{ name }
+	LveWindow::LveWindow(int w, int h, std::string name, bool headless) : width{ w }, height{ h }, windowName{ name }
 	{
-		initWindow();
+		if (!headless)
+		{
+			initWindow();
+		}
 	}
 
 	LveWindow::~LveWindow()
 	{
-		glfwDestroyWindow(window);
-		glfwTerminate();
+		if (window != nullptr)
+		{
+			glfwDestroyWindow(window);
+			glfwTerminate();
+		}
 	}
 
 	void LveWindow::createWindowSurface(VkInstance instance, VkSurfaceKHR* surface)
 	{
-		if (glfwCreateWindowSurface(instance, window, nullptr, surface) != VK_SUCCESS)
+		if (window == nullptr || glfwCreateWindowSurface(instance, window, nullptr, surface) != VK_SUCCESS)
 		{
 			throw std::runtime_error("Failed to create window surface!");
 		}
@@ -39,6 +45,12 @@ namespace lve {
 		glfwWindowHint(GLFW_RESIZABLE, GLFW_TRUE);
 
 		window = glfwCreateWindow(width, height, windowName.c_str(), nullptr, nullptr);
+		if (window == nullptr)
+		{
+			// The destructor doesn't run for a throwing constructor
+			glfwTerminate();
+			throw std::runtime_error("Failed to create window!");
+		}
 		glfwSetWindowUserPointer(window, this);
 		glfwSetFramebufferSizeCallback(window, framebufferResizeCallback);
 	}
@@ -9,13 +9,16 @@ namespace lve {
 	class LveWindow
 	{
 	public:
-		LveWindow(int w, int h, std::string name);
+		// A headless window never touches GLFW and has no surface, for machines without a display.
+		// It never closes and never resizes, w and h are the size of the offscreen images.
+		LveWindow(int w, int h, std::string name, bool headless = false);
 		~LveWindow();
 
 		LveWindow(const LveWindow&) = delete;
 		LveWindow& operator=(const LveWindow&) = delete;
 
-		bool shouldClose() { return glfwWindowShouldClose(window); }
+		bool isHeadless() const { return window == nullptr; }
+		bool shouldClose() { return window != nullptr && glfwWindowShouldClose(window); }
 		VkExtent2D getExtent() { return { static_cast<uint32_t>(width), static_cast<uint32_t>(height) }; }
 
 		bool wasWindowResized() { return farmeBufferResized; }
@@ -34,6 +37,6 @@ namespace lve {
 		bool farmeBufferResized = false;
 
 		std::string windowName;
-		GLFWwindow* window;
+		GLFWwindow* window = nullptr;
 	};
 }
\ No newline at end of file
@@ -6,6 +6,18 @@
 #include <vulkan/vulkan.h>
 
 namespace lve {
+	// Per object data shared by the vertex shader and the culling compute shader (std430 layout)
+	struct ObjectData
+	{
+		glm::mat4 modelMatrix{ 1.0f };
+		glm::mat4 normalMatrix{ 1.0f };
+		glm::vec4 boundingSphere{ 0.0f };  // model space center (xyz) and radius (w)
+		uint32_t batchIndex = 0;           // draw batch (model) the object belongs to
+		uint32_t firstCommand = 0;         // first indirect command slot of the batch
+		uint32_t indexCount = 0;
+		uint32_t textureIndex = 0;         // bindless texture slot, see LveBindlessRegistry
+	};
+
 	struct FrameInfo
 	{
 		int frameIndex;
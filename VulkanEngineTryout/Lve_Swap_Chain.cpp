@@ -1,7 +1,9 @@
 #include "Lve_Swap_Chain.h"
 
 // std
+#include <algorithm>
 #include <array>
+#include <chrono>
 #include <cstdlib>
 #include <cstring>
 #include <iostream>
@@ -11,31 +13,69 @@
 
 namespace lve {
 
-    Lve_Swap_Chain::Lve_Swap_Chain(LveDevice& deviceRef, VkExtent2D extent)
-        : device{ deviceRef }, windowExtent{ extent } {
+    namespace {
+        const char* presentModeName(VkPresentModeKHR presentMode) {
+            switch (presentMode) {
+            case VK_PRESENT_MODE_IMMEDIATE_KHR: return "Immediate";
+            case VK_PRESENT_MODE_MAILBOX_KHR: return "Mailbox";
+            case VK_PRESENT_MODE_FIFO_KHR: return "V-Sync";
+            case VK_PRESENT_MODE_FIFO_RELAXED_KHR: return "Relaxed V-Sync";
+            default: return "Other";
+            }
+        }
+
+        float millisecondsSince(std::chrono::steady_clock::time_point start) {
+            return std::chrono::duration<float, std::chrono::milliseconds::period>(std::chrono::steady_clock::now() - start).count();
+        }
+    }
+
+    Lve_Swap_Chain::Lve_Swap_Chain(LveDevice& deviceRef, VkExtent2D extent, const SwapChainSettings& settings)
+        : device{ deviceRef }, windowExtent{ extent }, settings{ settings } {
 		Init();
     }
     
-    Lve_Swap_Chain::Lve_Swap_Chain(LveDevice& deviceRef, VkExtent2D extent, std::shared_ptr<Lve_Swap_Chain> previous)
-        : device{ deviceRef }, windowExtent{ extent }, oldSwapChain{ previous } {
+    Lve_Swap_Chain::Lve_Swap_Chain(LveDevice& deviceRef, VkExtent2D extent, const SwapChainSettings& settings, std::shared_ptr<Lve_Swap_Chain> previous)
+        : device{ deviceRef }, windowExtent{ extent }, settings{ settings }, oldSwapChain{ previous } {
 		Init();
 
-		// Clean up old swap chain since its no longer needed
+		// The caller keeps the old swap chain alive until the frames that used it have finished
         oldSwapChain = nullptr;
     }
 
 
     void Lve_Swap_Chain::Init()
     {
-        createSwapChain();
+        if (settings.framesInFlight < 1 || settings.framesInFlight > MAX_FRAMES_IN_FLIGHT) {
+            throw std::runtime_error("frames in flight must be between 1 and MAX_FRAMES_IN_FLIGHT");
+        }
+
+        if (device.isHeadless()) {
+            createOffscreenImages();
+        }
+        else {
+            createSwapChain();
+        }
         createImageViews();
-        createRenderPass();
+        // Pipelines, also ones still compiling in the background, were created against the old render passes
+        if (oldSwapChain != nullptr &&
+            oldSwapChain->swapChainImageFormat == swapChainImageFormat &&
+            oldSwapChain->swapChainDepthFormat == findDepthFormat()) {
+            renderPasses = oldSwapChain->renderPasses;
+        }
+        else {
+            createRenderPass();
+        }
         createDepthResources();
         createFramebuffers();
         createSyncObjects();
     }
 
 
+    Lve_Swap_Chain::RenderPasses::~RenderPasses() {
+        vkDestroyRenderPass(device.device(), renderPass, nullptr);
+        vkDestroyRenderPass(device.device(), loadRenderPass, nullptr);
+    }
+
     Lve_Swap_Chain::~Lve_Swap_Chain() {
         for (auto imageView : swapChainImageViews) {
             vkDestroyImageView(device.device(), imageView, nullptr);
@@ -47,6 +87,11 @@ namespace lve {
             swapChain = nullptr;
         }
 
+        for (size_t i = 0; i < offscreenImageMemorys.size(); i++) {
+            vkDestroyImage(device.device(), swapChainImages[i], nullptr);
+            vkFreeMemory(device.device(), offscreenImageMemorys[i], nullptr);
+        }
+
         for (int i = 0; i < depthImages.size(); i++) {
             vkDestroyImageView(device.device(), depthImageViews[i], nullptr);
             vkDestroyImage(device.device(), depthImages[i], nullptr);
@@ -57,24 +102,30 @@ namespace lve {
             vkDestroyFramebuffer(device.device(), framebuffer, nullptr);
         }
 
-        vkDestroyRenderPass(device.device(), renderPass, nullptr);
-
         // cleanup synchronization objects
-        for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
-            vkDestroySemaphore(device.device(), renderFinishedSemaphores[i], nullptr);
-            vkDestroySemaphore(device.device(), imageAvailableSemaphores[i], nullptr);
-            vkDestroyFence(device.device(), inFlightFences[i], nullptr);
+        for (auto semaphore : renderFinishedSemaphores) {
+            vkDestroySemaphore(device.device(), semaphore, nullptr);
+        }
+        for (auto semaphore : imageAvailableSemaphores) {
+            vkDestroySemaphore(device.device(), semaphore, nullptr);
         }
     }
 
     VkResult Lve_Swap_Chain::acquireNextImage(uint32_t* imageIndex) {
-        vkWaitForFences(
-            device.device(),
-            1,
-            &inFlightFences[currentFrame],
-            VK_TRUE,
-            std::numeric_limits<uint64_t>::max());
+        auto start = std::chrono::steady_clock::now();
+        device.getGraphicsTimeline().wait(frameValues[currentFrame]);
+        timings.timelineWaitMilliseconds = millisecondsSince(start);
+
+        // Offscreen images are reused once the frame that last rendered to them has finished, which
+        // submitCommandBuffers waits for like it does for swap chain images
+        if (device.isHeadless()) {
+            *imageIndex = nextOffscreenImage;
+            nextOffscreenImage = (nextOffscreenImage + 1) % static_cast<uint32_t>(imageCount());
+            timings.acquireMilliseconds = 0.0f;
+            return VK_SUCCESS;
+        }
 
+        start = std::chrono::steady_clock::now();
         VkResult result = vkAcquireNextImageKHR(
             device.device(),
             swapChain,
@@ -82,44 +133,42 @@ namespace lve {
             imageAvailableSemaphores[currentFrame],  // must be a not signaled semaphore
             VK_NULL_HANDLE,
             imageIndex);
+        timings.acquireMilliseconds = millisecondsSince(start);
 
         return result;
     }
 
     VkResult Lve_Swap_Chain::submitCommandBuffers(
         const VkCommandBuffer* buffers, uint32_t* imageIndex) {
-        if (imagesInFlight[*imageIndex] != VK_NULL_HANDLE) {
-            vkWaitForFences(device.device(), 1, &imagesInFlight[*imageIndex], VK_TRUE, UINT64_MAX);
+        auto start = std::chrono::steady_clock::now();
+        // The depth image belongs to the swap chain image, a frame from another slot may still render into it
+        device.getGraphicsTimeline().wait(imageValues[*imageIndex]);
+
+        if (device.isHeadless()) {
+            uint64_t value = device.getGraphicsTimeline().submit({ buffers[0] });
+            frameValues[currentFrame] = value;
+            imageValues[*imageIndex] = value;
+            timings.submitMilliseconds = millisecondsSince(start);
+            timings.presentMilliseconds = 0.0f;
+
+            currentFrame = (currentFrame + 1) % settings.framesInFlight;
+            return VK_SUCCESS;
         }
-        imagesInFlight[*imageIndex] = inFlightFences[currentFrame];
-
-        VkSubmitInfo submitInfo = {};
-        submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-
-        VkSemaphore waitSemaphores[] = { imageAvailableSemaphores[currentFrame] };
-        VkPipelineStageFlags waitStages[] = { VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT };
-        submitInfo.waitSemaphoreCount = 1;
-        submitInfo.pWaitSemaphores = waitSemaphores;
-        submitInfo.pWaitDstStageMask = waitStages;
 
-        submitInfo.commandBufferCount = 1;
-        submitInfo.pCommandBuffers = buffers;
-
-        VkSemaphore signalSemaphores[] = { renderFinishedSemaphores[currentFrame] };
-        submitInfo.signalSemaphoreCount = 1;
-        submitInfo.pSignalSemaphores = signalSemaphores;
-
-        vkResetFences(device.device(), 1, &inFlightFences[currentFrame]);
-        if (vkQueueSubmit(device.graphicsQueue(), 1, &submitInfo, inFlightFences[currentFrame]) !=
-            VK_SUCCESS) {
-            throw std::runtime_error("failed to submit draw command buffer!");
-        }
+        uint64_t value = device.getGraphicsTimeline().submit(
+            { buffers[0] },
+            { { imageAvailableSemaphores[currentFrame], VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT_KHR } },
+            { renderFinishedSemaphores[*imageIndex] });
+        frameValues[currentFrame] = value;
+        imageValues[*imageIndex] = value;
+        timings.submitMilliseconds = millisecondsSince(start);
 
+        start = std::chrono::steady_clock::now();
         VkPresentInfoKHR presentInfo = {};
         presentInfo.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
 
         presentInfo.waitSemaphoreCount = 1;
-        presentInfo.pWaitSemaphores = signalSemaphores;
+        presentInfo.pWaitSemaphores = &renderFinishedSemaphores[*imageIndex];
 
         VkSwapchainKHR swapChains[] = { swapChain };
         presentInfo.swapchainCount = 1;
@@ -127,21 +176,36 @@ namespace lve {
 
         presentInfo.pImageIndices = imageIndex;
 
+        VkPresentIdKHR presentIdInfo{};
+        if (device.presentWait) {
+            presentId++;
+            presentIdInfo.sType = VK_STRUCTURE_TYPE_PRESENT_ID_KHR;
+            presentIdInfo.swapchainCount = 1;
+            presentIdInfo.pPresentIds = &presentId;
+            presentInfo.pNext = &presentIdInfo;
+        }
+
         auto result = vkQueuePresentKHR(device.presentQueue(), &presentInfo);
+        timings.presentMilliseconds = millisecondsSince(start);
 
-        currentFrame = (currentFrame + 1) % MAX_FRAMES_IN_FLIGHT;
+        currentFrame = (currentFrame + 1) % settings.framesInFlight;
 
         return result;
     }
 
+    bool Lve_Swap_Chain::isPresented(uint64_t id) {
+        return device.presentWait && device.waitForPresent(swapChain, id, 0) == VK_SUCCESS;
+    }
+
     void Lve_Swap_Chain::createSwapChain() {
         SwapChainSupportDetails swapChainSupport = device.getSwapChainSupport();
 
         VkSurfaceFormatKHR surfaceFormat = chooseSwapSurfaceFormat(swapChainSupport.formats);
-        VkPresentModeKHR presentMode = chooseSwapPresentMode(swapChainSupport.presentModes);
+        presentMode = chooseSwapPresentMode(swapChainSupport.presentModes);
         VkExtent2D extent = chooseSwapExtent(swapChainSupport.capabilities);
 
-        uint32_t imageCount = swapChainSupport.capabilities.minImageCount + 1;
+        uint32_t imageCount = settings.imageCount > 0 ? settings.imageCount : swapChainSupport.capabilities.minImageCount + 1;
+        imageCount = std::max(imageCount, swapChainSupport.capabilities.minImageCount);
         if (swapChainSupport.capabilities.maxImageCount > 0 &&
             imageCount > swapChainSupport.capabilities.maxImageCount) {
             imageCount = swapChainSupport.capabilities.maxImageCount;
@@ -196,6 +260,38 @@ namespace lve {
         swapChainExtent = extent;
     }
 
+    void Lve_Swap_Chain::createOffscreenImages() {
+        // The format the window path prefers, so pipelines are the same either way
+        swapChainImageFormat = VK_FORMAT_B8G8R8A8_UNORM;
+        swapChainExtent = windowExtent;
+        presentMode = VK_PRESENT_MODE_IMMEDIATE_KHR;
+
+        uint32_t imageCount = settings.imageCount > 0 ? settings.imageCount : settings.framesInFlight + 1;
+        swapChainImages.resize(imageCount);
+        offscreenImageMemorys.resize(imageCount);
+
+        for (uint32_t i = 0; i < imageCount; i++) {
+            VkImageCreateInfo imageInfo{};
+            imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+            imageInfo.imageType = VK_IMAGE_TYPE_2D;
+            imageInfo.extent.width = swapChainExtent.width;
+            imageInfo.extent.height = swapChainExtent.height;
+            imageInfo.extent.depth = 1;
+            imageInfo.mipLevels = 1;
+            imageInfo.arrayLayers = 1;
+            imageInfo.format = swapChainImageFormat;
+            imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+            imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+            // Transfer source so frames can be copied out for comparisons
+            imageInfo.usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+            imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+            imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+            device.createImageWithInfo(imageInfo, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, swapChainImages[i], offscreenImageMemorys[i]);
+        }
+        std::cout << "Present mode: none, " << imageCount << " offscreen images" << std::endl;
+    }
+
     void Lve_Swap_Chain::createImageViews() {
         swapChainImageViews.resize(swapChainImages.size());
         for (size_t i = 0; i < swapChainImages.size(); i++) {
@@ -218,14 +314,16 @@ namespace lve {
     }
 
     void Lve_Swap_Chain::createRenderPass() {
+        // Both passes start and end in attachment layouts without external dependencies,
+        // LveRenderGraph records the transitions and barriers around them
         VkAttachmentDescription depthAttachment{};
         depthAttachment.format = findDepthFormat();
         depthAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
         depthAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
-        depthAttachment.storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+        depthAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;  // read back by the depth pyramid
         depthAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
         depthAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
-        depthAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        depthAttachment.initialLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
         depthAttachment.finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
 
         VkAttachmentReference depthAttachmentRef{};
@@ -239,8 +337,8 @@ namespace lve {
         colorAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
         colorAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
         colorAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
-        colorAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-        colorAttachment.finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+        colorAttachment.initialLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+        colorAttachment.finalLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
 
         VkAttachmentReference colorAttachmentRef = {};
         colorAttachmentRef.attachment = 0;
@@ -252,14 +350,6 @@ namespace lve {
         subpass.pColorAttachments = &colorAttachmentRef;
         subpass.pDepthStencilAttachment = &depthAttachmentRef;
 
-        VkSubpassDependency dependency = {};
-        dependency.srcSubpass = VK_SUBPASS_EXTERNAL;
-        dependency.srcAccessMask = 0;
-        dependency.srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
-        dependency.dstSubpass = 0;
-        dependency.dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
-        dependency.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
-
         std::array<VkAttachmentDescription, 2> attachments = { colorAttachment, depthAttachment };
         VkRenderPassCreateInfo renderPassInfo = {};
         renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
@@ -267,12 +357,24 @@ namespace lve {
         renderPassInfo.pAttachments = attachments.data();
         renderPassInfo.subpassCount = 1;
         renderPassInfo.pSubpasses = &subpass;
-        renderPassInfo.dependencyCount = 1;
-        renderPassInfo.pDependencies = &dependency;
+        renderPassInfo.dependencyCount = 0;
+        renderPassInfo.pDependencies = nullptr;
 
-        if (vkCreateRenderPass(device.device(), &renderPassInfo, nullptr, &renderPass) != VK_SUCCESS) {
+        renderPasses = std::make_shared<RenderPasses>(device);
+        if (vkCreateRenderPass(device.device(), &renderPassInfo, nullptr, &renderPasses->renderPass) != VK_SUCCESS) {
             throw std::runtime_error("failed to create render pass!");
         }
+
+        // Second pass of the frame, continues drawing on top of what the first pass left behind
+        colorAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_LOAD;
+        depthAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_LOAD;
+        depthAttachment.storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+
+        attachments = { colorAttachment, depthAttachment };
+
+        if (vkCreateRenderPass(device.device(), &renderPassInfo, nullptr, &renderPasses->loadRenderPass) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create load render pass!");
+        }
     }
 
     void Lve_Swap_Chain::createFramebuffers() {
@@ -283,7 +385,7 @@ namespace lve {
             VkExtent2D swapChainExtent = getSwapChainExtent();
             VkFramebufferCreateInfo framebufferInfo = {};
             framebufferInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
-            framebufferInfo.renderPass = renderPass;
+            framebufferInfo.renderPass = renderPasses->renderPass;
             framebufferInfo.attachmentCount = static_cast<uint32_t>(attachments.size());
             framebufferInfo.pAttachments = attachments.data();
             framebufferInfo.width = swapChainExtent.width;
@@ -321,7 +423,7 @@ namespace lve {
             imageInfo.format = depthFormat;
             imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
             imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-            imageInfo.usage = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT;
+            imageInfo.usage = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
             imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
             imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
             imageInfo.flags = 0;
@@ -351,26 +453,37 @@ namespace lve {
 
     void Lve_Swap_Chain::createSyncObjects() {
         imageAvailableSemaphores.resize(MAX_FRAMES_IN_FLIGHT);
-        renderFinishedSemaphores.resize(MAX_FRAMES_IN_FLIGHT);
-        inFlightFences.resize(MAX_FRAMES_IN_FLIGHT);
-        imagesInFlight.resize(imageCount(), VK_NULL_HANDLE);
+        renderFinishedSemaphores.resize(imageCount());
+        imageValues.resize(imageCount(), 0);
+
+        // Frames still in flight were submitted through the previous swap chain, carrying over their timeline
+        // values keeps the frame slots in step with the renderer without stalling on the recreation.
+        // A different frames in flight count starts over at frame 0, the renderer waits for the device first.
+        if (oldSwapChain != nullptr && oldSwapChain->settings.framesInFlight == settings.framesInFlight) {
+            frameValues = oldSwapChain->frameValues;
+            currentFrame = oldSwapChain->currentFrame;
+        }
+
+        // Nothing to acquire or present headless
+        if (device.isHeadless()) {
+            return;
+        }
 
         VkSemaphoreCreateInfo semaphoreInfo = {};
         semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
 
-        VkFenceCreateInfo fenceInfo = {};
-        fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
-        fenceInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT;
-
         for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
             if (vkCreateSemaphore(device.device(), &semaphoreInfo, nullptr, &imageAvailableSemaphores[i]) !=
-                VK_SUCCESS ||
-                vkCreateSemaphore(device.device(), &semaphoreInfo, nullptr, &renderFinishedSemaphores[i]) !=
-                VK_SUCCESS ||
-                vkCreateFence(device.device(), &fenceInfo, nullptr, &inFlightFences[i]) != VK_SUCCESS) {
+                VK_SUCCESS) {
                 throw std::runtime_error("failed to create synchronization objects for a frame!");
             }
         }
+        for (size_t i = 0; i < imageCount(); i++) {
+            if (vkCreateSemaphore(device.device(), &semaphoreInfo, nullptr, &renderFinishedSemaphores[i]) !=
+                VK_SUCCESS) {
+                throw std::runtime_error("failed to create synchronization objects for an image!");
+            }
+        }
     }
 
     VkSurfaceFormatKHR Lve_Swap_Chain::chooseSwapSurfaceFormat(
@@ -386,22 +499,14 @@ namespace lve {
     }
 
     VkPresentModeKHR Lve_Swap_Chain::chooseSwapPresentMode(const std::vector<VkPresentModeKHR>& availablePresentModes) {
-        
-        /*for (const auto& availablePresentMode : availablePresentModes) {
-            if (availablePresentMode == VK_PRESENT_MODE_MAILBOX_KHR) {
-                std::cout << "Present mode: Mailbox" << std::endl;
+        for (const auto& availablePresentMode : availablePresentModes) {
+            if (availablePresentMode == settings.presentMode) {
+                std::cout << "Present mode: " << presentModeName(availablePresentMode) << std::endl;
                 return availablePresentMode;
             }
         }
 
-         for (const auto &availablePresentMode : availablePresentModes) {
-           if (availablePresentMode == VK_PRESENT_MODE_IMMEDIATE_KHR) {
-             std::cout << "Present mode: Immediate" << std::endl;
-             return availablePresentMode;
-           }
-         }*/
-
-        std::cout << "Present mode: V-Sync" << std::endl;
+        std::cout << "Present mode: " << presentModeName(settings.presentMode) << " not supported, using V-Sync" << std::endl;
         return VK_PRESENT_MODE_FIFO_KHR;
     }
 
@@ -426,7 +531,7 @@ namespace lve {
         return device.findSupportedFormat(
             { VK_FORMAT_D32_SFLOAT, VK_FORMAT_D32_SFLOAT_S8_UINT, VK_FORMAT_D24_UNORM_S8_UINT },
             VK_IMAGE_TILING_OPTIMAL,
-            VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT);
+            VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT);
     }
 
 }  // namespace lve
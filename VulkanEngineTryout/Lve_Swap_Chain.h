@@ -6,28 +6,68 @@
 #include <vulkan/vulkan.h>
 
 // std lib headers
+#include <array>
 #include <string>
 #include <vector>
 #include <memory>
 
 namespace lve {
 
+    struct SwapChainSettings {
+        // 1 to Lve_Swap_Chain::MAX_FRAMES_IN_FLIGHT. Fewer frames cut input latency, more keep the GPU fed
+        // when CPU frame times vary.
+        uint32_t framesInFlight = 2;
+        // 0 for one more than the surface minimum, clamped to what the surface supports
+        uint32_t imageCount = 0;
+        // Falls back to FIFO, the only mode every surface supports
+        VkPresentModeKHR presentMode = VK_PRESENT_MODE_FIFO_KHR;
+
+        // Newest image on screen without tearing, the CPU never runs more than a frame ahead
+        static SwapChainSettings lowLatency() { return { 1, 3, VK_PRESENT_MODE_MAILBOX_KHR }; }
+        // Smooths out uneven frames at the cost of latency
+        static SwapChainSettings throughput() { return { 3, 0, VK_PRESENT_MODE_FIFO_KHR }; }
+    };
+
+    // Headless (see LveDevice::isHeadless) it renders into a ring of offscreen images with the same
+    // acquire and submit calls, nothing is presented and the present mode is ignored.
     class Lve_Swap_Chain {
     public:
-        static constexpr int MAX_FRAMES_IN_FLIGHT = 2;
-
-        Lve_Swap_Chain(LveDevice& deviceRef, VkExtent2D windowExtent);
-        Lve_Swap_Chain(LveDevice& deviceRef, VkExtent2D windowExtent, std::shared_ptr<Lve_Swap_Chain> previous);
+        // CPU time spent in the last acquireNextImage and submitCommandBuffers
+        struct Timings {
+            float timelineWaitMilliseconds = 0.0f;
+            float acquireMilliseconds = 0.0f;
+            float submitMilliseconds = 0.0f;
+            float presentMilliseconds = 0.0f;
+        };
+
+        // Upper bound of SwapChainSettings::framesInFlight, per frame resources are created for this many
+        // so frames in flight can change without recreating them
+        static constexpr int MAX_FRAMES_IN_FLIGHT = 3;
+
+        Lve_Swap_Chain(LveDevice& deviceRef, VkExtent2D windowExtent, const SwapChainSettings& settings = {});
+        Lve_Swap_Chain(LveDevice& deviceRef, VkExtent2D windowExtent, const SwapChainSettings& settings, std::shared_ptr<Lve_Swap_Chain> previous);
         ~Lve_Swap_Chain();
 
         Lve_Swap_Chain(const Lve_Swap_Chain&) = delete;
         Lve_Swap_Chain& operator=(const Lve_Swap_Chain&) = delete;
 
         VkFramebuffer getFrameBuffer(int index) { return swapChainFramebuffers[index]; }
-        VkRenderPass getRenderPass() { return renderPass; }
+        // A swap chain recreated from one with the same formats shares its render passes, so a render pass
+        // stays valid until the last swap chain using it is destroyed, not just until the next resize
+        VkRenderPass getRenderPass() { return renderPasses->renderPass; }
+        // Compatible with getRenderPass() but loads color and depth instead of clearing them
+        VkRenderPass getLoadRenderPass() { return renderPasses->loadRenderPass; }
+        VkImage getImage(int index) { return swapChainImages[index]; }
         VkImageView getImageView(int index) { return swapChainImageViews[index]; }
+        VkImage getDepthImage(int index) { return depthImages[index]; }
+        VkImageView getDepthImageView(int index) { return depthImageViews[index]; }
         size_t imageCount() { return swapChainImages.size(); }
+        const SwapChainSettings& getSettings() const { return settings; }
+        VkPresentModeKHR getPresentMode() const { return presentMode; }
         VkFormat getSwapChainImageFormat() { return swapChainImageFormat; }
+        // The layout color images have to be in at the end of a frame, transfer source for offscreen ones
+        VkImageLayout getPresentLayout() const { return device.isHeadless() ? VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL : VK_IMAGE_LAYOUT_PRESENT_SRC_KHR; }
+        VkFormat getSwapChainDepthFormat() { return swapChainDepthFormat; }
         VkExtent2D getSwapChainExtent() { return swapChainExtent; }
         uint32_t width() { return swapChainExtent.width; }
         uint32_t height() { return swapChainExtent.height; }
@@ -37,8 +77,16 @@ namespace lve {
         }
         VkFormat findDepthFormat();
 
+        // Waits on the graphics timeline until the frame that last used this frame slot has finished
         VkResult acquireNextImage(uint32_t* imageIndex);
         VkResult submitCommandBuffers(const VkCommandBuffer* buffers, uint32_t* imageIndex);
+        const Timings& getTimings() const { return timings; }
+        // Id of the last present, 0 without present wait
+        uint64_t getLastPresentId() const { return presentId; }
+        // Whether the present with this id has reached the screen, does not block
+        bool isPresented(uint64_t id);
+        // Graphics timeline value signaled by the last submitCommandBuffers
+        uint64_t getLastSubmittedValue() const { return frameValues[(currentFrame + settings.framesInFlight - 1) % settings.framesInFlight]; }
 
 		bool compareSwapFormats(const Lve_Swap_Chain& swapChain) const {
 			return swapChainImageFormat == swapChain.swapChainImageFormat &&
@@ -46,8 +94,18 @@ namespace lve {
 		}
 
     private:
+        struct RenderPasses {
+            LveDevice& device;
+            VkRenderPass renderPass = VK_NULL_HANDLE;
+            VkRenderPass loadRenderPass = VK_NULL_HANDLE;
+
+            explicit RenderPasses(LveDevice& deviceRef) : device{ deviceRef } {}
+            ~RenderPasses();
+        };
+
 		void Init();
         void createSwapChain();
+        void createOffscreenImages();
         void createImageViews();
         void createDepthResources();
         void createRenderPass();
@@ -61,30 +119,41 @@ namespace lve {
             const std::vector<VkPresentModeKHR>& availablePresentModes);
         VkExtent2D chooseSwapExtent(const VkSurfaceCapabilitiesKHR& capabilities);
 
+        SwapChainSettings settings;
+        VkPresentModeKHR presentMode;
         VkFormat swapChainImageFormat;
         VkFormat swapChainDepthFormat;
         VkExtent2D swapChainExtent;
 
         std::vector<VkFramebuffer> swapChainFramebuffers;
-        VkRenderPass renderPass;
+        std::shared_ptr<RenderPasses> renderPasses;
 
         std::vector<VkImage> depthImages;
         std::vector<VkDeviceMemory> depthImageMemorys;
         std::vector<VkImageView> depthImageViews;
         std::vector<VkImage> swapChainImages;
+        std::vector<VkDeviceMemory> offscreenImageMemorys;  // headless only, the images are ours then
         std::vector<VkImageView> swapChainImageViews;
 
         LveDevice& device;
         VkExtent2D windowExtent;
 
-        VkSwapchainKHR swapChain;
+        VkSwapchainKHR swapChain = VK_NULL_HANDLE;
 		std::shared_ptr<Lve_Swap_Chain> oldSwapChain;
 
-        std::vector<VkSemaphore> imageAvailableSemaphores;
+        // Binary, presentation can't use timeline semaphores
+        std::vector<VkSemaphore> imageAvailableSemaphores;  // per frame slot
+        // Per image: the timeline only shows that the submit signalling one has finished, not that the present
+        // waiting on it has. Acquiring the image again does, so the semaphore is free to signal by then.
         std::vector<VkSemaphore> renderFinishedSemaphores;
-        std::vector<VkFence> inFlightFences;
-        std::vector<VkFence> imagesInFlight;
+        // Graphics timeline values of the last submission per frame slot and per image, 0 before the first
+        std::array<uint64_t, MAX_FRAMES_IN_FLIGHT> frameValues{};
+        std::vector<uint64_t> imageValues;
         size_t currentFrame = 0;
+        uint32_t nextOffscreenImage = 0;
+
+        Timings timings;
+        uint64_t presentId = 0;
     };
 
 }  // namespace lve
@@ -1,7 +1,6 @@
 #include "Pipeline.h"
 #include "LveModel.h"
 
-#include <fstream>
 #include <stdexcept>
 #include <iostream>
 #include <cassert>
@@ -13,10 +12,12 @@ namespace lve {
 		CreateGraphicsPipeline(vertFilePath, fragFilePath, configInfo);
 	}
 
+	Pipeline::Pipeline(LveDevice& device, VkPipeline pipeline) : lveDevice{ device }, graphicsPipline{ pipeline }
+	{
+	}
+
 	Pipeline::~Pipeline()
 	{
-		vkDestroyShaderModule(lveDevice.device(), vertShaderModule, nullptr);
-		vkDestroyShaderModule(lveDevice.device(), fragShaderModule, nullptr);
 		vkDestroyPipeline(lveDevice.device(), graphicsPipline, nullptr);
 	}
 
@@ -94,26 +95,9 @@ namespace lve {
 		pipelineConfigInfo.dynamicStateInfo.dynamicStateCount = static_cast<uint32_t>(pipelineConfigInfo.dynamicStateEnables.size());
 		pipelineConfigInfo.dynamicStateInfo.pDynamicStates = pipelineConfigInfo.dynamicStateEnables.data();
 		pipelineConfigInfo.dynamicStateInfo.flags = 0;
-	}
-
-	std::vector<char> Pipeline::readFile(const std::string& filePath)
-	{
-		std::ifstream file{ filePath, std::ios::ate | std::ios::binary };
-
-		if (!file.is_open())
-		{
-			throw std::runtime_error("Failed to open file: " + filePath);
-		}
 
-		size_t fileSize = static_cast<rsize_t>(file.tellg());
-
-		std::vector<char> buffer(fileSize);
-
-		file.seekg(0);
-		file.read(buffer.data(), fileSize);
-
-		file.close();
-		return buffer;
+		pipelineConfigInfo.bindingDescriptions = LveModel::Vertex::getBindingDescriptions();
+		pipelineConfigInfo.attributeDescriptions = LveModel::Vertex::getAttributeDescriptions();
 	}
 
 	void Pipeline::CreateGraphicsPipeline(const std::string& vertFilePath, const std::string& fragFilePath, const PipelineConfigInfo& configInfo)
@@ -121,51 +105,76 @@ namespace lve {
 		assert(configInfo.pipelineLayout != VK_NULL_HANDLE && "Cannot create graphics pipeline:: no pipelineLayout provided in configInfo");
 		assert(configInfo.renderPass != VK_NULL_HANDLE && "Cannot create graphics pipeline:: no renderPass provided in configInfo");
 
-		auto vertCode = readFile(vertFilePath);
-		auto fragCode = readFile(fragFilePath);
+		auto& shaderCache = lveDevice.getShaderCache();
+		vertShader = shaderCache.acquire(vertFilePath);
+
+		// The attributes are written by hand next to the vertex struct, the shader has the final say
+		std::string vertexInputError = vertShader->getReflection().checkVertexInput(configInfo.attributeDescriptions);
+		if (!vertexInputError.empty())
+		{
+			throw std::runtime_error(vertFilePath + ": " + vertexInputError);
+		}
 
-		createShaderModule(vertCode, &vertShaderModule);
-		createShaderModule(fragCode, &fragShaderModule);
+		bool hasFragmentStage = !fragFilePath.empty();
+		if (hasFragmentStage)
+		{
+			fragShader = shaderCache.acquire(fragFilePath);
+		}
+
+		VkSpecializationInfo vertSpecializationInfo;
+		VkSpecializationInfo fragSpecializationInfo;
 
 		VkPipelineShaderStageCreateInfo shaderStages[2];
 		shaderStages[0].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
 		shaderStages[0].stage = VK_SHADER_STAGE_VERTEX_BIT;
-		shaderStages[0].module = vertShaderModule;
+		shaderStages[0].module = VK_NULL_HANDLE;
 		shaderStages[0].pName = "main";
 		shaderStages[0].flags = 0;
 		shaderStages[0].pNext = nullptr;
-		shaderStages[0].pSpecializationInfo = nullptr;
+		shaderStages[0].pSpecializationInfo = configInfo.vertexSpecialization.getInfo(vertSpecializationInfo);
+		vertShader->attach(shaderStages[0]);
 
 		shaderStages[1].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
 		shaderStages[1].stage = VK_SHADER_STAGE_FRAGMENT_BIT;
-		shaderStages[1].module = fragShaderModule;
+		shaderStages[1].module = VK_NULL_HANDLE;
 		shaderStages[1].pName = "main";
 		shaderStages[1].flags = 0;
 		shaderStages[1].pNext = nullptr;
-		shaderStages[1].pSpecializationInfo = nullptr;
+		shaderStages[1].pSpecializationInfo = configInfo.fragmentSpecialization.getInfo(fragSpecializationInfo);
+		if (hasFragmentStage)
+		{
+			fragShader->attach(shaderStages[1]);
+		}
 
-		auto bindingDescription = LveModel::Vertex::getBindingDescriptions();
-		auto attributeDescriptions = LveModel::Vertex::getAttributeDescriptions();
+		auto& bindingDescriptions = configInfo.bindingDescriptions;
+		auto& attributeDescriptions = configInfo.attributeDescriptions;
 
 		VkPipelineVertexInputStateCreateInfo vertexInputInfo{};
 		vertexInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
 		vertexInputInfo.vertexAttributeDescriptionCount = static_cast<uint32_t>(attributeDescriptions.size());
-		vertexInputInfo.vertexBindingDescriptionCount = static_cast<uint32_t>(bindingDescription.size());
+		vertexInputInfo.vertexBindingDescriptionCount = static_cast<uint32_t>(bindingDescriptions.size());
 		vertexInputInfo.pVertexAttributeDescriptions = attributeDescriptions.data();
-		vertexInputInfo.pVertexBindingDescriptions = bindingDescription.data();
+		vertexInputInfo.pVertexBindingDescriptions = bindingDescriptions.data();
+
+		// The config may be a copy, whose internal pointers still point into the original
+		VkPipelineColorBlendStateCreateInfo colorBlendInfo = configInfo.colorBlendInfo;
+		colorBlendInfo.pAttachments = &configInfo.colorBlendAttachment;
+		VkPipelineDynamicStateCreateInfo dynamicStateInfo = configInfo.dynamicStateInfo;
+		dynamicStateInfo.dynamicStateCount = static_cast<uint32_t>(configInfo.dynamicStateEnables.size());
+		dynamicStateInfo.pDynamicStates = configInfo.dynamicStateEnables.data();
 
 		VkGraphicsPipelineCreateInfo pipelineInfo{};
 		pipelineInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
-		pipelineInfo.stageCount = 2;
+		pipelineInfo.stageCount = hasFragmentStage ? 2 : 1;
 		pipelineInfo.pStages = shaderStages;
 		pipelineInfo.pVertexInputState = &vertexInputInfo;
 		pipelineInfo.pInputAssemblyState = &configInfo.inputAssemblyInfo;
 		pipelineInfo.pViewportState = &configInfo.viewportInfo;
 		pipelineInfo.pRasterizationState = &configInfo.rasterizationInfo;
 		pipelineInfo.pMultisampleState = &configInfo.multisampleInfo;
-		pipelineInfo.pColorBlendState = &configInfo.colorBlendInfo;
+		pipelineInfo.pColorBlendState = &colorBlendInfo;
 		pipelineInfo.pDepthStencilState = &configInfo.depthStencilInfo;
-		pipelineInfo.pDynamicState = &configInfo.dynamicStateInfo;
+		pipelineInfo.pDynamicState = &dynamicStateInfo;
 
 		pipelineInfo.layout = configInfo.pipelineLayout;
 		pipelineInfo.renderPass = configInfo.renderPass;
@@ -174,21 +183,55 @@ namespace lve {
 		pipelineInfo.basePipelineIndex = -1;
 		pipelineInfo.basePipelineHandle = VK_NULL_HANDLE;
 
-		if (vkCreateGraphicsPipelines(lveDevice.device(), VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &graphicsPipline) != VK_SUCCESS)
+		if (vkCreateGraphicsPipelines(lveDevice.device(), lveDevice.pipelineCache(), 1, &pipelineInfo, nullptr, &graphicsPipline) != VK_SUCCESS)
 		{
 			throw std::runtime_error("Failed to create graphics pipeline");
 		}
 	}
 
-	void Pipeline::createShaderModule(const std::vector<char>& code, VkShaderModule* shaderModule)
+	ComputePipeline::ComputePipeline(LveDevice& device, const std::string& compFilePath, VkPipelineLayout pipelineLayout, const LveSpecialization& specialization) : lveDevice{ device }
+	{
+		createComputePipeline(compFilePath, pipelineLayout, specialization);
+	}
+
+	ComputePipeline::~ComputePipeline()
+	{
+		vkDestroyPipeline(lveDevice.device(), computePipeline, nullptr);
+	}
+
+	void ComputePipeline::bind(VkCommandBuffer commandBuffer)
+	{
+		vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, computePipeline);
+	}
+
+	void ComputePipeline::createComputePipeline(const std::string& compFilePath, VkPipelineLayout pipelineLayout, const LveSpecialization& specialization)
 	{
-		VkShaderModuleCreateInfo createInfo{};
-		createInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
-		createInfo.codeSize = code.size();
-		createInfo.pCode = reinterpret_cast<const uint32_t*>(code.data());
-		if (vkCreateShaderModule(lveDevice.device(), &createInfo, nullptr, shaderModule) != VK_SUCCESS)
+		assert(pipelineLayout != VK_NULL_HANDLE && "Cannot create compute pipeline:: no pipelineLayout provided");
+
+		compShader = lveDevice.getShaderCache().acquire(compFilePath);
+
+		VkSpecializationInfo specializationInfo;
+
+		VkPipelineShaderStageCreateInfo shaderStage{};
+		shaderStage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+		shaderStage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+		shaderStage.module = VK_NULL_HANDLE;
+		shaderStage.pName = "main";
+		shaderStage.flags = 0;
+		shaderStage.pNext = nullptr;
+		shaderStage.pSpecializationInfo = specialization.getInfo(specializationInfo);
+		compShader->attach(shaderStage);
+
+		VkComputePipelineCreateInfo pipelineInfo{};
+		pipelineInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+		pipelineInfo.stage = shaderStage;
+		pipelineInfo.layout = pipelineLayout;
+		pipelineInfo.basePipelineIndex = -1;
+		pipelineInfo.basePipelineHandle = VK_NULL_HANDLE;
+
+		if (vkCreateComputePipelines(lveDevice.device(), lveDevice.pipelineCache(), 1, &pipelineInfo, nullptr, &computePipeline) != VK_SUCCESS)
 		{
-			throw std::runtime_error("Failed to create shader module");
+			throw std::runtime_error("Failed to create compute pipeline");
 		}
 	}
 }
\ No newline at end of file
@@ -1,15 +1,20 @@
 #pragma once
 
 #include "LveDevice.h"
+#include "LveShaderCache.h"
+#include "LveSpecialization.h"
 
+#include <memory>
 #include <string>
 #include <vector>
 
 namespace lve {
 
+	// Safe to copy: colorBlendInfo.pAttachments and dynamicStateInfo.pDynamicStates point into the struct and are
+	// re-pointed at the copy's own members when the pipeline is created.
 	struct PipelineConfigInfo {
-
-
+		std::vector<VkVertexInputBindingDescription> bindingDescriptions{};
+		std::vector<VkVertexInputAttributeDescription> attributeDescriptions{};
 		VkPipelineViewportStateCreateInfo viewportInfo;
 		VkPipelineInputAssemblyStateCreateInfo inputAssemblyInfo;
 		VkPipelineRasterizationStateCreateInfo rasterizationInfo;
@@ -22,12 +27,17 @@ namespace lve {
 		VkPipelineLayout pipelineLayout = nullptr;
 		VkRenderPass renderPass = nullptr;
 		uint32_t subpass = 0;
+		LveSpecialization vertexSpecialization;
+		LveSpecialization fragmentSpecialization;
 	};
 
 	class Pipeline
 	{
 	public:
+		// An empty fragFilePath creates a pipeline without fragment stage, e.g. for depth only passes
 		Pipeline(LveDevice& device, const std::string& vertFilePath, const std::string& fragFilePath, const PipelineConfigInfo& configInfo);
+		// Takes ownership of a pipeline created elsewhere, e.g. linked from pipeline libraries
+		Pipeline(LveDevice& device, VkPipeline pipeline);
 		~Pipeline();
 
 		Pipeline(const Pipeline&) = delete;
@@ -38,15 +48,31 @@ namespace lve {
 		static void defaultPipelineConfigInfo(PipelineConfigInfo& pipelineConfigInfo);
 
 	private:
-		static std::vector<char> readFile(const std::string& filePath);
-
 		void CreateGraphicsPipeline(const std::string& vertFilePath, const std::string& fragFilePath, const PipelineConfigInfo& configInfo);
 
-		void createShaderModule(const std::vector<char>& code, VkShaderModule* shaderModule);
-
 		LveDevice& lveDevice;
 		VkPipeline graphicsPipline;
-		VkShaderModule vertShaderModule;
-		VkShaderModule fragShaderModule;
+		// Held so that later pipelines with the same shaders reuse the modules
+		std::shared_ptr<const LveShaderCache::Shader> vertShader;
+		std::shared_ptr<const LveShaderCache::Shader> fragShader;
+	};
+
+	class ComputePipeline
+	{
+	public:
+		ComputePipeline(LveDevice& device, const std::string& compFilePath, VkPipelineLayout pipelineLayout, const LveSpecialization& specialization = {});
+		~ComputePipeline();
+
+		ComputePipeline(const ComputePipeline&) = delete;
+		ComputePipeline& operator=(const ComputePipeline&) = delete;
+
+		void bind(VkCommandBuffer commandBuffer);
+
+	private:
+		void createComputePipeline(const std::string& compFilePath, VkPipelineLayout pipelineLayout, const LveSpecialization& specialization);
+
+		LveDevice& lveDevice;
+		VkPipeline computePipeline;
+		std::shared_ptr<const LveShaderCache::Shader> compShader;
 	};
 }
\ No newline at end of file
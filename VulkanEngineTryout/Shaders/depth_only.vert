@@ -0,0 +1,29 @@
+#version 450
+
+layout(location = 0) in vec3 position;
+
+layout (set = 0, binding = 0) uniform GlobalUBO {
+	mat4 projectionViewMatrix;
+} ubo;
+
+struct ObjectData {
+	mat4 modelMatrix;
+	mat4 normalMatrix;
+	vec4 boundingSphere;
+	uint batchIndex;
+	uint firstCommand;
+	uint indexCount;
+	uint textureIndex;
+};
+
+layout (std430, set = 1, binding = 0) readonly buffer ObjectBuffer {
+	ObjectData objects[];
+} objectBuffer;
+
+// Must match simple_shader.vert bit for bit, the main pass tests depth with EQUAL
+invariant gl_Position;
+
+void main() {
+	ObjectData objectData = objectBuffer.objects[gl_InstanceIndex];
+	gl_Position = ubo.projectionViewMatrix * objectData.modelMatrix * vec4(position, 1.0);
+}
@@ -1,14 +1,26 @@
 #version 450
+#extension GL_EXT_nonuniform_qualifier : require
 
 layout (location = 0) in vec3 fragColor;
+layout (location = 1) in vec2 fragUv;
+layout (location = 2) flat in uint fragTextureIndex;
+
 layout (location = 0) out vec4 outColor;
 
-layout(push_constant) uniform Push {
-	mat4 modelMatrix;
-	mat4 normalMatrix;
-} push;
+// Bindless set, see LveBindlessRegistry
+layout (set = 2, binding = 1) uniform sampler samplers[];
+layout (set = 2, binding = 2) uniform texture2D textures[];
+
+const uint DEFAULT_SAMPLER = 0;
 
+// Set per pipeline, see SimpleRenderSystem::ShaderFeatures
+layout (constant_id = 0) const bool TEXTURED = true;
 
 void main() {
-	outColor = vec4(fragColor, 1.0);
+	vec3 albedo = vec3(1.0);
+	if (TEXTURED)
+	{
+		albedo = texture(sampler2D(textures[nonuniformEXT(fragTextureIndex)], samplers[DEFAULT_SAMPLER]), fragUv).rgb;
+	}
+	outColor = vec4(fragColor * albedo, 1.0);
 }
\ No newline at end of file
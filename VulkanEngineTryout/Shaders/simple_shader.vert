@@ -6,24 +6,51 @@ layout(location = 2) in vec3 normal;
 layout(location = 3) in vec2 uv;
 
 layout (location = 0) out vec3 fragColor;
+layout (location = 1) out vec2 fragUv;
+layout (location = 2) flat out uint fragTextureIndex;
+
+// Size of the light array in GlobalUBO, SimpleRenderSystem::MAX_LIGHTS
+const uint MAX_LIGHTS = 4;
+
+// Set per pipeline, see SimpleRenderSystem::ShaderFeatures
+layout (constant_id = 0) const uint LIGHT_COUNT = 1;
+layout (constant_id = 1) const float AMBIENT = 0.02;
 
 layout (set = 0, binding = 0) uniform GlobalUBO {
 	mat4 projectionViewMatrix;
-	vec3 directionToLight;
+	vec4 directionsToLights[MAX_LIGHTS];
 } ubo;
 
-layout(push_constant) uniform Push {
+struct ObjectData {
 	mat4 modelMatrix;
 	mat4 normalMatrix;
-} push;
+	vec4 boundingSphere;
+	uint batchIndex;
+	uint firstCommand;
+	uint indexCount;
+	uint textureIndex;
+};
+
+// Indexed with gl_InstanceIndex, which is the firstInstance of the indirect draw command
+layout (std430, set = 1, binding = 0) readonly buffer ObjectBuffer {
+	ObjectData objects[];
+} objectBuffer;
 
-const float AMBIENT = 0.02;
+// The depth pre-pass (depth_only.vert) computes the same position, the main pass then tests depth with EQUAL
+invariant gl_Position;
 
 void main() {
-	gl_Position = ubo.projectionViewMatrix * push.modelMatrix * vec4(position, 1.0);
+	ObjectData objectData = objectBuffer.objects[gl_InstanceIndex];
+	gl_Position = ubo.projectionViewMatrix * objectData.modelMatrix * vec4(position, 1.0);
 
-	vec3 normalWorldSpace = normalize(mat3(push.normalMatrix) * normal);
-	float lightIntensity = AMBIENT + max(dot(normalWorldSpace, ubo.directionToLight), 0);
+	vec3 normalWorldSpace = normalize(mat3(objectData.normalMatrix) * normal);
+	float lightIntensity = AMBIENT;
+	for (uint i = 0; i < min(LIGHT_COUNT, MAX_LIGHTS); i++)
+	{
+		lightIntensity += max(dot(normalWorldSpace, ubo.directionsToLights[i].xyz), 0);
+	}
 
 	fragColor = lightIntensity * color;
+	fragUv = uv;
+	fragTextureIndex = objectData.textureIndex;
 }
\ No newline at end of file
@@ -1,4 +1,5 @@
 #include "SimpleRenderSystem.h"
+#include "Lve_Swap_Chain.h"
 
 // GLM
 #define GLM_FORCE_RADIANS
@@ -7,80 +8,1068 @@
 #include <glm/gtc/constants.hpp>
 
 // std
+#include <algorithm>
 #include <iostream>
 #include <array>
 #include <cassert>
+#include <cstddef>
+#include <numeric>
 #include <stdexcept>
+#include <string>
 
 namespace lve {
 
-	struct SimplePushConstantData {
-		glm::mat4 modelMatrix{ 1.0f };
-		glm::mat4 normalMatrix{ 1.0f };
-	};
+	namespace {
+		constexpr const char* SIMPLE_VERT_PATH = "./Shaders/simple_shader.vert.spv";
+		constexpr const char* SIMPLE_FRAG_PATH = "./Shaders/simple_shader.frag.spv";
+		constexpr const char* DEPTH_ONLY_VERT_PATH = "./Shaders/depth_only.vert.spv";
+	}
 
-	SimpleRenderSystem::SimpleRenderSystem(LveDevice& device, VkRenderPass renderPass, VkDescriptorSetLayout globalSetLayout) : lveDevice{ device }
+	SimpleRenderSystem::SimpleRenderSystem(LveDevice& device, VkRenderPass renderPass, const LveDescriptorSetLayout& globalSetLayout, LveBindlessRegistry& bindlessRegistry, LvePipelineCompiler& compiler)
+		: lveDevice{ device }, bindless{ bindlessRegistry }, pipelineCompiler{ compiler }
 	{
-		createPipelineLayout(globalSetLayout);
-		createPipeline(renderPass);
+		LveShaderReflection reflection = reflectShaders();
+		createObjectResources(reflection);
+		// Global, object and bindless set
+		setLayouts = { &globalSetLayout, objectSetLayout, &bindless.getSetLayout() };
+		pipelineLayout = getPipelineLayout(reflection);
+		auto pipelineSet = createPipelineSet(shaderFeatures, renderPass, true);
+		activePipelines = pipelineSet.get();
+		pipelineSets.emplace(getFeaturesKey(shaderFeatures), std::move(pipelineSet));
+
+		if (GpuCullingSystem::isSupported(lveDevice))
+		{
+			gpuCulling = std::make_unique<GpuCullingSystem>(lveDevice, *objectSetLayout, MAX_OBJECTS);
+		}
 	}
 
 	SimpleRenderSystem::~SimpleRenderSystem()
 	{
-		vkDestroyPipelineLayout(lveDevice.device(), pipelineLayout, nullptr);
+		// Compiles still running use the render pass and the shader modules
+		auto waitForCompiles = [](PipelineSet& pipelineSet)
+		{
+			for (auto& future : pipelineSet.futures)
+			{
+				if (future.valid()) future.wait();
+			}
+		};
+		for (auto& [key, pipelineSet] : pipelineSets)
+		{
+			waitForCompiles(*pipelineSet);
+		}
+		if (reloadedPipelines)
+		{
+			waitForCompiles(*reloadedPipelines);
+		}
+
+		// Frees the cached static command buffers
+		vkDestroyCommandPool(lveDevice.device(), staticCommandPool, nullptr);
+	}
+
+	LveShaderReflection SimpleRenderSystem::reflectShaders()
+	{
+		auto& shaderCache = lveDevice.getShaderCache();
+		LveShaderReflection reflection = shaderCache.acquire(SIMPLE_VERT_PATH)->getReflection();
+		reflection.merge(shaderCache.acquire(SIMPLE_FRAG_PATH)->getReflection());
+		reflection.merge(shaderCache.acquire(DEPTH_ONLY_VERT_PATH)->getReflection());
+		return reflection;
+	}
+
+	void SimpleRenderSystem::createObjectResources(const LveShaderReflection& reflection)
+	{
+		// Set 1 of the vertex shaders, GpuCullingSystem also binds it as set 0 of cull.comp
+		auto objectBindings = reflection.getSetBindings(1);
+		for (auto& binding : objectBindings)
+		{
+			binding.stageFlags |= VK_SHADER_STAGE_COMPUTE_BIT;
+		}
+		objectSetLayout = &lveDevice.getLayoutCache().getDescriptorSetLayout(objectBindings);
+
+		// One object set per frame plus the static object set
+		objectPool = LveDescriptorPool::Builder(lveDevice)
+			.setMaxSets(Lve_Swap_Chain::MAX_FRAMES_IN_FLIGHT + 1)
+			.addPoolSize(VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, Lve_Swap_Chain::MAX_FRAMES_IN_FLIGHT + 1)
+			.build();
+
+		objectBuffers.resize(Lve_Swap_Chain::MAX_FRAMES_IN_FLIGHT);
+		indirectBuffers.resize(Lve_Swap_Chain::MAX_FRAMES_IN_FLIGHT);
+		objectDescriptorSets.resize(Lve_Swap_Chain::MAX_FRAMES_IN_FLIGHT);
+		uploadedSceneVersions.resize(Lve_Swap_Chain::MAX_FRAMES_IN_FLIGHT, 0);
+
+		for (int i = 0; i < Lve_Swap_Chain::MAX_FRAMES_IN_FLIGHT; i++)
+		{
+			objectBuffers[i] = std::make_unique<Lve_Buffer>(
+				lveDevice,
+				sizeof(ObjectData),
+				MAX_OBJECTS,
+				VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+				VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT
+			);
+			objectBuffers[i]->map();
+
+			indirectBuffers[i] = std::make_unique<Lve_Buffer>(
+				lveDevice,
+				sizeof(VkDrawIndexedIndirectCommand),
+				MAX_OBJECTS,
+				VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT,
+				VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT
+			);
+			indirectBuffers[i]->map();
+
+			auto bufferInfo = objectBuffers[i]->descriptorInfo();
+			LveDescriptorWriter(*objectSetLayout, *objectPool)
+				.writeBuffer(0, &bufferInfo)
+				.build(objectDescriptorSets[i]);
+		}
+
+		staticObjectBuffer = std::make_unique<Lve_Buffer>(
+			lveDevice,
+			sizeof(ObjectData),
+			MAX_OBJECTS,
+			VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT
+		);
+		staticObjectBuffer->map();
+
+		auto staticBufferInfo = staticObjectBuffer->descriptorInfo();
+		LveDescriptorWriter(*objectSetLayout, *objectPool)
+			.writeBuffer(0, &staticBufferInfo)
+			.build(staticDescriptorSet);
+
+		staticIndirectBuffers.resize(Lve_Swap_Chain::MAX_FRAMES_IN_FLIGHT);
+		for (auto& staticIndirectBuffer : staticIndirectBuffers)
+		{
+			staticIndirectBuffer = std::make_unique<Lve_Buffer>(
+				lveDevice,
+				sizeof(VkDrawIndexedIndirectCommand),
+				MAX_OBJECTS,
+				VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT,
+				VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT
+			);
+			staticIndirectBuffer->map();
+		}
+
+		VkCommandPoolCreateInfo poolInfo{};
+		poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+		poolInfo.queueFamilyIndex = lveDevice.findPhysicalQueueFamilies().graphicsFamily;
+		poolInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+
+		if (vkCreateCommandPool(lveDevice.device(), &poolInfo, nullptr, &staticCommandPool) != VK_SUCCESS)
+		{
+			throw std::runtime_error("failed to create static command pool");
+		}
+
+		// Pre-pass and main pass buffer per frame in flight
+		staticRecordings.resize(Lve_Swap_Chain::MAX_FRAMES_IN_FLIGHT);
+		std::vector<VkCommandBuffer> staticCommandBuffers(staticRecordings.size() * 2);
+
+		VkCommandBufferAllocateInfo allocateInfo{};
+		allocateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+		allocateInfo.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+		allocateInfo.commandPool = staticCommandPool;
+		allocateInfo.commandBufferCount = static_cast<uint32_t>(staticCommandBuffers.size());
+
+		if (vkAllocateCommandBuffers(lveDevice.device(), &allocateInfo, staticCommandBuffers.data()) != VK_SUCCESS)
+		{
+			throw std::runtime_error("failed to allocate static command buffers");
+		}
+		for (size_t i = 0; i < staticRecordings.size(); i++)
+		{
+			staticRecordings[i].prepassCommandBuffer = staticCommandBuffers[i * 2];
+			staticRecordings[i].commandBuffer = staticCommandBuffers[i * 2 + 1];
+		}
 	}
 
-	void SimpleRenderSystem::createPipelineLayout(VkDescriptorSetLayout globalSetLayout)
+	VkPipelineLayout SimpleRenderSystem::getPipelineLayout(const LveShaderReflection& reflection) const
 	{
+		// The global and bindless layouts are made elsewhere, so all of them are checked against what the shaders declare
+		if (reflection.getSetCount() > setLayouts.size())
+		{
+			throw std::runtime_error("simple shaders use a descriptor set the render system does not bind");
+		}
 
-		VkPushConstantRange pushConstantRange{};
-		pushConstantRange.stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
-		pushConstantRange.offset = 0;
-		pushConstantRange.size = sizeof(SimplePushConstantData);
+		std::vector<VkDescriptorSetLayout> descriptorSetLayouts;
+		for (uint32_t set = 0; set < setLayouts.size(); set++)
+		{
+			std::string error = reflection.checkSetBindings(set, setLayouts[set]->getBindings());
+			if (!error.empty())
+			{
+				throw std::runtime_error("descriptor set layout does not match the simple shaders: " + error);
+			}
+			descriptorSetLayouts.push_back(setLayouts[set]->getDescriptorSetLayout());
+		}
 
-		std::vector<VkDescriptorSetLayout> descriptorSetLayouts{ globalSetLayout };
+		return lveDevice.getLayoutCache().getPipelineLayout(descriptorSetLayouts, reflection.getPushConstantRanges());
+	}
 
+	// constant_ids of simple_shader.vert and simple_shader.frag
+	namespace SimpleShaderConstants {
+		constexpr LveSpecializationConstant<uint32_t> LIGHT_COUNT{ 0 };
+		constexpr LveSpecializationConstant<float> AMBIENT{ 1 };
+		constexpr LveSpecializationConstant<bool> TEXTURED{ 0 };
+	}
 
-		VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
-		pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
-		pipelineLayoutInfo.setLayoutCount = static_cast<uint32_t>(descriptorSetLayouts.size());
-		pipelineLayoutInfo.pSetLayouts = descriptorSetLayouts.data();
-		pipelineLayoutInfo.pushConstantRangeCount = 1;
-		pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
+	void SimpleRenderSystem::createPipelineConfig(PipelineKind kind, const ShaderFeatures& features, VkRenderPass renderPass, PipelineConfigInfo& configInfo)
+	{
+		Pipeline::defaultPipelineConfigInfo(configInfo);
+		configInfo.renderPass = renderPass;
+		configInfo.pipelineLayout = pipelineLayout;
+		configInfo.vertexSpecialization
+			.set(SimpleShaderConstants::LIGHT_COUNT, std::min(features.lightCount, MAX_LIGHTS))
+			.set(SimpleShaderConstants::AMBIENT, features.ambient);
+		configInfo.fragmentSpecialization.set(SimpleShaderConstants::TEXTURED, features.textured);
 
-		if (vkCreatePipelineLayout(lveDevice.device(), &pipelineLayoutInfo, nullptr, &pipelineLayout) != VK_SUCCESS)
+		switch (kind)
 		{
-			throw std::runtime_error("failed to create pipeline layout");
+		case PipelineKind::Opaque:
+			break;
+		case PipelineKind::Transparent:
+			// Same shaders, blended with a constant alpha and without depth writes
+			configInfo.colorBlendAttachment.blendEnable = VK_TRUE;
+			configInfo.colorBlendAttachment.srcColorBlendFactor = VK_BLEND_FACTOR_CONSTANT_ALPHA;
+			configInfo.colorBlendAttachment.dstColorBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_CONSTANT_ALPHA;
+			configInfo.colorBlendInfo.blendConstants[3] = TRANSPARENT_ALPHA;
+			configInfo.depthStencilInfo.depthWriteEnable = VK_FALSE;
+			break;
+		case PipelineKind::DepthPrepass:
+			// Position attribute only, no fragment shader and no color writes. depth_only.vert has no constants.
+			configInfo.attributeDescriptions = { { 0, 0, VK_FORMAT_R32G32B32_SFLOAT, offsetof(LveModel::Vertex, position) } };
+			configInfo.colorBlendAttachment.colorWriteMask = 0;
+			configInfo.vertexSpecialization = {};
+			configInfo.fragmentSpecialization = {};
+			break;
+		case PipelineKind::DepthEqual:
+			// Shading after the pre-pass, depth is already final so only the visible surface passes
+			configInfo.depthStencilInfo.depthCompareOp = VK_COMPARE_OP_EQUAL;
+			configInfo.depthStencilInfo.depthWriteEnable = VK_FALSE;
+			break;
+		case PipelineKind::Count:
+			assert(false && "Not a pipeline kind");
+			break;
 		}
 	}
 
-	void SimpleRenderSystem::createPipeline(VkRenderPass renderPass)
+	std::unique_ptr<SimpleRenderSystem::PipelineSet> SimpleRenderSystem::createPipelineSet(const ShaderFeatures& features, VkRenderPass renderPass, bool waitForOpaque)
 	{
 		assert(pipelineLayout != nullptr && "Cannot create pipeline before pipeline layout");
 
-		PipelineConfigInfo pipelineConfig{};
-		Pipeline::defaultPipelineConfigInfo(pipelineConfig);
-		pipelineConfig.renderPass = renderPass;
-		pipelineConfig.pipelineLayout = pipelineLayout;
-		pipeline = std::make_unique<Pipeline>(lveDevice, "./Shaders/simple_shader.vert.spv", "./Shaders/simple_shader.frag.spv", pipelineConfig);
+		auto pipelineSet = std::make_unique<PipelineSet>();
+		for (uint32_t i = 0; i < static_cast<uint32_t>(PipelineKind::Count); i++)
+		{
+			auto kind = static_cast<PipelineKind>(i);
+			bool depthOnly = kind == PipelineKind::DepthPrepass;
+			std::string vertFilePath = depthOnly ? DEPTH_ONLY_VERT_PATH : SIMPLE_VERT_PATH;
+			std::string fragFilePath = depthOnly ? "" : SIMPLE_FRAG_PATH;
+
+			PipelineConfigInfo configInfo{};
+			createPipelineConfig(kind, features, renderPass, configInfo);
+
+			// The first frame needs the opaque pipeline, a full compile beats a fast link that gets replaced right away
+			if (waitForOpaque && kind == PipelineKind::Opaque)
+			{
+				pipelineSet->pipelines[i] = std::make_shared<Pipeline>(lveDevice, vertFilePath, fragFilePath, configInfo);
+				continue;
+			}
+
+			pipelineSet->pipelines[i] = pipelineCompiler.linkFast(vertFilePath, fragFilePath, configInfo);
+			pipelineSet->futures[i] = pipelineCompiler.compile(vertFilePath, fragFilePath, configInfo);
+		}
+		return pipelineSet;
+	}
+
+	std::string SimpleRenderSystem::getFeaturesKey(const ShaderFeatures& features)
+	{
+		return std::to_string(std::min(features.lightCount, MAX_LIGHTS)) + "/" + std::to_string(features.ambient) + "/" + (features.textured ? "textured" : "untextured");
+	}
+
+	void SimpleRenderSystem::setShaderFeatures(const ShaderFeatures& features, VkRenderPass renderPass)
+	{
+		shaderFeatures = features;
+
+		auto& pipelineSet = pipelineSets[getFeaturesKey(features)];
+		if (!pipelineSet)
+		{
+			pipelineSet = createPipelineSet(features, renderPass, false);
+		}
+
+		// Switched over by updatePipelines once the opaque pipeline exists
+		pendingPipelines = pipelineSet.get();
+		updatePipelines();
+	}
+
+	void SimpleRenderSystem::reloadShaders(VkRenderPass renderPass)
+	{
+		// Built before anything is retired, a shader that cannot make pipelines leaves the current ones drawing
+		std::unique_ptr<PipelineSet> reloadedSet;
+		try
+		{
+			// The same layout comes back from the cache unless the shader interface changed
+			if (getPipelineLayout(reflectShaders()) != pipelineLayout)
+			{
+				throw std::runtime_error("push constants changed");
+			}
+
+			// Not part of the layout, the attributes are fixed by the vertex struct
+			for (uint32_t i = 0; i < static_cast<uint32_t>(PipelineKind::Count); i++)
+			{
+				auto kind = static_cast<PipelineKind>(i);
+				std::string vertFilePath = kind == PipelineKind::DepthPrepass ? DEPTH_ONLY_VERT_PATH : SIMPLE_VERT_PATH;
+
+				PipelineConfigInfo configInfo{};
+				createPipelineConfig(kind, shaderFeatures, renderPass, configInfo);
+				std::string error = lveDevice.getShaderCache().acquire(vertFilePath)->getReflection().checkVertexInput(configInfo.attributeDescriptions);
+				if (!error.empty())
+				{
+					throw std::runtime_error(vertFilePath + ": " + error);
+				}
+			}
+
+			reloadedSet = createPipelineSet(shaderFeatures, renderPass, false);
+		}
+		catch (const std::exception& e)
+		{
+			std::cout << "Shader reload rejected, keeping the previous shaders (restart to change the shader interface): " << e.what() << std::endl;
+			return;
+		}
+
+		// Every set was built from the old SPIR-V. The active one keeps drawing until the new set is ready,
+		// the rest go once the frames in flight are done with them.
+		for (auto& [key, pipelineSet] : pipelineSets)
+		{
+			if (pipelineSet.get() == activePipelines)
+			{
+				if (!reloadedPipelines) reloadedPipelines = std::move(pipelineSet);
+				continue;
+			}
+			lveDevice.getDeletionQueue().push([retired = std::shared_ptr<PipelineSet>(std::move(pipelineSet))]() mutable { retired.reset(); });
+		}
+		pipelineSets.clear();
+
+		// Switched over by updatePipelines once the opaque pipeline exists
+		pendingPipelines = reloadedSet.get();
+		pipelineSets[getFeaturesKey(shaderFeatures)] = std::move(reloadedSet);
+		updatePipelines();
+
+		// Every set is built from the new SPIR-V now, nothing links the old parts again
+		pipelineCompiler.releaseStaleParts();
+	}
+
+	void SimpleRenderSystem::updatePipelines()
+	{
+		bool activeChanged = false;
+		for (auto& [key, pipelineSet] : pipelineSets)
+		{
+			for (size_t i = 0; i < pipelineSet->futures.size(); i++)
+			{
+				auto& future = pipelineSet->futures[i];
+				if (!LvePipelineCompiler::isReady(future)) continue;
+
+				std::shared_ptr<Pipeline> pipeline;
+				try
+				{
+					pipeline = future.get();
+				}
+				catch (const std::exception& e)
+				{
+					// The driver can still reject a reloaded shader. A set whose opaque pipeline failed never becomes active.
+					std::cout << "Pipeline compile failed, keeping the previous pipeline: " << e.what() << std::endl;
+					future = {};
+					continue;
+				}
+				future = {};
+
+				// Replaces a fast-linked pipeline that frames in flight may still use
+				auto& target = pipelineSet->pipelines[i];
+				if (target)
+				{
+					lveDevice.getDeletionQueue().push([retired = std::move(target)]() mutable { retired.reset(); });
+				}
+				target = std::move(pipeline);
+				activeChanged |= pipelineSet.get() == activePipelines;
+			}
+		}
+
+		if (pendingPipelines != nullptr && pendingPipelines->pipelines[static_cast<size_t>(PipelineKind::Opaque)] != nullptr)
+		{
+			activeChanged |= pendingPipelines != activePipelines;
+			activePipelines = pendingPipelines;
+			pendingPipelines = nullptr;
+
+			if (reloadedPipelines)
+			{
+				// Frames in flight may still draw with the pipelines from before the reload
+				lveDevice.getDeletionQueue().push([retired = std::shared_ptr<PipelineSet>(std::move(reloadedPipelines))]() mutable { retired.reset(); });
+			}
+		}
+
+		if (activeChanged)
+		{
+			// Cached static command buffers were recorded with other pipelines
+			staticVersion++;
+		}
+	}
+
+	void SimpleRenderSystem::prepareGameobjects(FrameInfo& frameInfo, std::vector<LveGameObject>& gameObjects, bool excludeStatic)
+	{
+		if (frustumCuller.size() != gameObjects.size())
+		{
+			updateBounds(gameObjects);
+		}
+
+		// Culled objects never reach writeObjects, so their transforms are not rebuilt
+		visibleIndices.clear();
+		frustumCuller.cull(frameInfo.camera.getFrustumPlanes(), visibleIndices);
+
+		if (excludeStatic)
+		{
+			assert(staticSlots.size() == gameObjects.size() && "Game objects changed since setStaticScene");
+
+			writeStaticVisibility(frameInfo.frameIndex);
+			visibleIndices.erase(std::remove_if(visibleIndices.begin(), visibleIndices.end(),
+				[this](uint32_t objectIndex) { return staticSlots[objectIndex] != UINT32_MAX; }), visibleIndices.end());
+		}
+
+		glm::mat4 projectionView = frameInfo.camera.getProjection() * frameInfo.camera.getView();
+		buildDrawItems(gameObjects, visibleIndices, &projectionView, drawItems);
+		radixSort(drawItems, sortScratch);
+		buildBatches(gameObjects, drawItems, batches);
+
+		auto objects = static_cast<ObjectData*>(objectBuffers[frameInfo.frameIndex]->getMappedMemory());
+		auto commands = static_cast<VkDrawIndexedIndirectCommand*>(indirectBuffers[frameInfo.frameIndex]->getMappedMemory());
+		writeObjects(gameObjects, drawItems, batches, objects, commands);
+		objectBuffers[frameInfo.frameIndex]->flush();
+		indirectBuffers[frameInfo.frameIndex]->flush();
+
+		// The object buffer no longer holds the uploaded scene
+		uploadedSceneVersions[frameInfo.frameIndex] = 0;
 	}
 
 	void lve::SimpleRenderSystem::renderGameobjects(FrameInfo& frameInfo, std::vector<LveGameObject>& gameObjects)
 	{
-		pipeline->bind(frameInfo.commandBuffer);
+		updatePipelines();
+		prepareGameobjects(frameInfo, gameObjects, false);
+
+		RecordState state{};
+		beginBatches(frameInfo, objectDescriptorSets[frameInfo.frameIndex], state);
+		VkBuffer indirectBuffer = indirectBuffers[frameInfo.frameIndex]->getBuffer();
+
+		writePassMarker(frameInfo.commandBuffer, frameInfo.frameIndex, PassMarker::Begin);
+		if (isDepthPrepassActive())
+		{
+			recordBatches(frameInfo, batches, indirectBuffer, true, state);
+		}
+		writePassMarker(frameInfo.commandBuffer, frameInfo.frameIndex, PassMarker::Main);
+		recordBatches(frameInfo, batches, indirectBuffer, false, state);
+		writePassMarker(frameInfo.commandBuffer, frameInfo.frameIndex, PassMarker::End);
+
+		drawStats = state.stats;
+	}
+
+	void SimpleRenderSystem::renderGameobjectsParallel(FrameInfo& frameInfo, std::vector<LveGameObject>& gameObjects, LveRenderer& renderer, LveThreadPool& threadPool)
+	{
+		assert(renderer.getSecondarySlotCount() > 0 && "Parallel recording requires secondary command pools");
+
+		updatePipelines();
+
+		bool drawStatic = hasStaticScene();
+		prepareGameobjects(frameInfo, gameObjects, drawStatic);
+
+		uint32_t commandCount = static_cast<uint32_t>(drawItems.size());
+		uint32_t maxChunks = (commandCount + MIN_COMMANDS_PER_CHUNK - 1) / MIN_COMMANDS_PER_CHUNK;
+		uint32_t chunkCount = std::max(1u, std::min(renderer.getSecondarySlotCount(), maxChunks));
+		splitBatches(chunkCount);
+
+		uint32_t recordedChunks = static_cast<uint32_t>(chunkBatches.size());
+		chunkStates.assign(recordedChunks, RecordState{});
+
+		// With the pre-pass the buffers form two groups, all depth only buffers and then all shading buffers.
+		// Static geometry is opaque, it goes first in each group so transparent draws of the dynamic chunks blend over it.
+		uint32_t staticBuffers = drawStatic ? 1 : 0;
+		uint32_t groupSize = staticBuffers + recordedChunks;
+		uint32_t mainGroup = isDepthPrepassActive() ? groupSize : 0;
+		chunkCommandBuffers.resize(mainGroup + groupSize);
+		if (drawStatic)
+		{
+			auto& recording = getStaticRecording(frameInfo, renderer);
+			if (isDepthPrepassActive())
+			{
+				chunkCommandBuffers[0] = recording.prepassCommandBuffer;
+			}
+			chunkCommandBuffers[mainGroup] = recording.commandBuffer;
+		}
+
+		VkBuffer indirectBuffer = indirectBuffers[frameInfo.frameIndex]->getBuffer();
+		// Chunk i records into slot i, so no two workers share a command pool
+		threadPool.parallelFor(recordedChunks, [&](uint32_t chunk)
+		{
+			FrameInfo chunkInfo = frameInfo;
+			auto& state = chunkStates[chunk];
+			// The first buffer of a group writes the pass markers, the cached static buffers carry their own
+			bool firstInGroup = chunk == 0 && !drawStatic;
+
+			if (isDepthPrepassActive())
+			{
+				chunkInfo.commandBuffer = renderer.beginSecondaryCommandBuffer(chunk);
+				beginBatches(chunkInfo, objectDescriptorSets[frameInfo.frameIndex], state);
+				if (firstInGroup)
+				{
+					writePassMarker(chunkInfo.commandBuffer, frameInfo.frameIndex, PassMarker::Begin);
+				}
+				recordBatches(chunkInfo, chunkBatches[chunk], indirectBuffer, true, state);
+				renderer.endSecondaryCommandBuffer(chunkInfo.commandBuffer);
+				chunkCommandBuffers[staticBuffers + chunk] = chunkInfo.commandBuffer;
+			}
+
+			chunkInfo.commandBuffer = renderer.beginSecondaryCommandBuffer(chunk);
+			beginBatches(chunkInfo, objectDescriptorSets[frameInfo.frameIndex], state);
+			if (firstInGroup)
+			{
+				writePassMarker(chunkInfo.commandBuffer, frameInfo.frameIndex, PassMarker::Main);
+			}
+			recordBatches(chunkInfo, chunkBatches[chunk], indirectBuffer, false, state);
+			if (chunk + 1 == recordedChunks)
+			{
+				writePassMarker(chunkInfo.commandBuffer, frameInfo.frameIndex, PassMarker::End);
+			}
+			renderer.endSecondaryCommandBuffer(chunkInfo.commandBuffer);
+			chunkCommandBuffers[mainGroup + staticBuffers + chunk] = chunkInfo.commandBuffer;
+		});
+
+		// Executed in chunk order, which keeps the sorted draw order (back to front for transparent draws)
+		vkCmdExecuteCommands(frameInfo.commandBuffer, static_cast<uint32_t>(chunkCommandBuffers.size()), chunkCommandBuffers.data());
+
+		drawStats = drawStatic ? staticRecordings[frameInfo.frameIndex].stats : DrawStats{};
+		for (auto& state : chunkStates)
+		{
+			drawStats += state.stats;
+		}
+	}
+
+	void SimpleRenderSystem::splitBatches(uint32_t chunkCount)
+	{
+		uint32_t commandCount = static_cast<uint32_t>(drawItems.size());
+		uint32_t commandsPerChunk = std::max(1u, (commandCount + chunkCount - 1) / chunkCount);
+
+		chunkBatches.resize(chunkCount);
+		for (auto& chunk : chunkBatches)
+		{
+			chunk.clear();
+		}
+
+		uint32_t chunk = 0;
+		uint32_t chunkFill = 0;
+		for (auto& batch : batches)
+		{
+			uint32_t first = batch.firstCommand;
+			uint32_t remaining = batch.commandCount;
+			while (remaining > 0)
+			{
+				if (chunkFill == commandsPerChunk && chunk + 1 < chunkCount)
+				{
+					chunk++;
+					chunkFill = 0;
+				}
+
+				uint32_t count = std::min(remaining, commandsPerChunk - chunkFill);
+				if (chunk + 1 == chunkCount)
+				{
+					// The last chunk takes whatever is left
+					count = remaining;
+				}
+				chunkBatches[chunk].push_back({ batch.model, batch.transparent, first, count });
+
+				first += count;
+				remaining -= count;
+				chunkFill += count;
+			}
+		}
+
+		// Fewer draws than chunks, drop the empty tail
+		while (chunkBatches.size() > 1 && chunkBatches.back().empty())
+		{
+			chunkBatches.pop_back();
+		}
+	}
+
+	void SimpleRenderSystem::setStaticScene(std::vector<LveGameObject>& gameObjects)
+	{
+		assert(isStaticSceneSupported() && "Static scenes are culled through indirect commands");
+
+		validateScene(gameObjects);
+
+		// The static object buffer and the cached command buffers may still be in use
+		vkDeviceWaitIdle(lveDevice.device());
+
+		std::vector<uint32_t> staticIndices;
+		for (uint32_t i = 0; i < gameObjects.size(); i++)
+		{
+			if (gameObjects[i].isStatic && !gameObjects[i].transparent)
+			{
+				staticIndices.push_back(i);
+			}
+		}
+
+		// Without depth in the keys, the cached order only has to minimize state changes
+		buildDrawItems(gameObjects, staticIndices, nullptr, staticItems);
+		radixSort(staticItems, sortScratch);
+		buildBatches(gameObjects, staticItems, staticBatches);
+
+		staticSlots.assign(gameObjects.size(), UINT32_MAX);
+		for (uint32_t slot = 0; slot < staticItems.size(); slot++)
+		{
+			staticSlots[staticItems[slot].value] = slot;
+		}
+
+		auto objects = static_cast<ObjectData*>(staticObjectBuffer->getMappedMemory());
+		auto commands = static_cast<VkDrawIndexedIndirectCommand*>(staticIndirectBuffers[0]->getMappedMemory());
+		writeObjects(gameObjects, staticItems, staticBatches, objects, commands);
+		staticObjectBuffer->flush();
+		for (size_t i = 0; i < staticIndirectBuffers.size(); i++)
+		{
+			if (i > 0)
+			{
+				staticIndirectBuffers[i]->writeToBuffer(commands, sizeof(VkDrawIndexedIndirectCommand) * staticItems.size());
+			}
+			staticIndirectBuffers[i]->flush();
+		}
+
+		staticVersion++;
+	}
+
+	void SimpleRenderSystem::writeStaticVisibility(int frameIndex)
+	{
+		// Culled static objects keep their command but draw zero instances
+		auto commands = static_cast<VkDrawIndexedIndirectCommand*>(staticIndirectBuffers[frameIndex]->getMappedMemory());
+		for (uint32_t slot = 0; slot < staticItems.size(); slot++)
+		{
+			commands[slot].instanceCount = 0;
+		}
+		for (uint32_t objectIndex : visibleIndices)
+		{
+			uint32_t slot = staticSlots[objectIndex];
+			if (slot != UINT32_MAX)
+			{
+				commands[slot].instanceCount = 1;
+			}
+		}
+		staticIndirectBuffers[frameIndex]->flush();
+	}
+
+	SimpleRenderSystem::StaticRecording& SimpleRenderSystem::getStaticRecording(FrameInfo& frameInfo, LveRenderer& renderer)
+	{
+		auto& recording = staticRecordings[frameInfo.frameIndex];
+		if (recording.staticVersion == staticVersion && recording.swapChainGeneration == renderer.getSwapChainGeneration())
+		{
+			return recording;
+		}
+
+		// The frame's timeline value has been waited on, the previous submission of these buffers has finished
+		FrameInfo staticInfo = frameInfo;
+		RecordState state{};
+		VkBuffer indirectBuffer = staticIndirectBuffers[frameInfo.frameIndex]->getBuffer();
+
+		if (isDepthPrepassActive())
+		{
+			staticInfo.commandBuffer = recording.prepassCommandBuffer;
+			beginStaticCommandBuffer(staticInfo.commandBuffer, renderer);
+			beginBatches(staticInfo, staticDescriptorSet, state);
+			writePassMarker(staticInfo.commandBuffer, frameInfo.frameIndex, PassMarker::Begin);
+			recordBatches(staticInfo, staticBatches, indirectBuffer, true, state);
+			renderer.endSecondaryCommandBuffer(staticInfo.commandBuffer);
+		}
+
+		staticInfo.commandBuffer = recording.commandBuffer;
+		beginStaticCommandBuffer(staticInfo.commandBuffer, renderer);
+		beginBatches(staticInfo, staticDescriptorSet, state);
+		writePassMarker(staticInfo.commandBuffer, frameInfo.frameIndex, PassMarker::Main);
+		recordBatches(staticInfo, staticBatches, indirectBuffer, false, state);
+		renderer.endSecondaryCommandBuffer(staticInfo.commandBuffer);
+
+		recording.staticVersion = staticVersion;
+		recording.swapChainGeneration = renderer.getSwapChainGeneration();
+		recording.stats = state.stats;
+		return recording;
+	}
+
+	void SimpleRenderSystem::beginStaticCommandBuffer(VkCommandBuffer commandBuffer, LveRenderer& renderer)
+	{
+		// Recorded against the render pass only, so the same commands work with every framebuffer
+		VkCommandBufferInheritanceInfo inheritanceInfo{};
+		inheritanceInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+		inheritanceInfo.renderPass = renderer.getSwapChainRenderPass();
+		inheritanceInfo.subpass = 0;
+		inheritanceInfo.framebuffer = VK_NULL_HANDLE;
+
+		VkCommandBufferBeginInfo beginInfo{};
+		beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+		beginInfo.flags = VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
+		beginInfo.pInheritanceInfo = &inheritanceInfo;
+
+		if (vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS)
+		{
+			throw std::runtime_error("failed to begin recording static command buffer");
+		}
+
+		renderer.setViewportAndScissor(commandBuffer);
+	}
+
+	void SimpleRenderSystem::updateBounds(std::vector<LveGameObject>& gameObjects)
+	{
+		validateScene(gameObjects);
+
+		frustumCuller.resize(static_cast<uint32_t>(gameObjects.size()));
+		for (uint32_t i = 0; i < gameObjects.size(); i++)
+		{
+			auto& obj = gameObjects[i];
+			if (obj.model == nullptr)
+			{
+				frustumCuller.setEmpty(i);
+				continue;
+			}
+
+			frustumCuller.setBounds(i, obj.transform.mat4(), obj.model->getBoundsCenter(), obj.model->getBoundsRadius(), obj.model->getBoundsMin(), obj.model->getBoundsMax());
+		}
+	}
+
+	void SimpleRenderSystem::setScene(std::vector<LveGameObject>& gameObjects)
+	{
+		validateScene(gameObjects);
 
-		vkCmdBindDescriptorSets(frameInfo.commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, 0, 1, &frameInfo.globalDescriptorSet, 0, nullptr);
+		// The GPU fills batches in whatever order objects survive culling, so scene keys carry no depth
+		sceneIndices.resize(gameObjects.size());
+		std::iota(sceneIndices.begin(), sceneIndices.end(), 0);
+		buildDrawItems(gameObjects, sceneIndices, nullptr, sceneItems);
+		radixSort(sceneItems, sortScratch);
+		buildBatches(gameObjects, sceneItems, sceneBatches);
+
+		sceneObjects.resize(sceneItems.size());
+		writeObjects(gameObjects, sceneItems, sceneBatches, sceneObjects.data(), nullptr);
+		sceneVersion++;
+
+		if (gpuCulling != nullptr)
+		{
+			gpuCulling->resetVisibility();
+		}
+	}
+
+	void SimpleRenderSystem::cullGameobjects(FrameInfo& frameInfo, CullPhase phase)
+	{
+		assert(gpuCulling != nullptr && "GPU culling is not supported on this device");
+
+		// Only re-upload when the scene changed since this frame's buffer was last written
+		auto& objectBuffer = objectBuffers[frameInfo.frameIndex];
+		if (phase == CullPhase::Early && uploadedSceneVersions[frameInfo.frameIndex] != sceneVersion && !sceneObjects.empty())
+		{
+			objectBuffer->writeToBuffer(sceneObjects.data(), sizeof(ObjectData) * sceneObjects.size());
+			objectBuffer->flush();
+			uploadedSceneVersions[frameInfo.frameIndex] = sceneVersion;
+		}
+
+		gpuCulling->cull(frameInfo, objectDescriptorSets[frameInfo.frameIndex], static_cast<uint32_t>(sceneObjects.size()), phase);
+	}
+
+	void SimpleRenderSystem::renderCulledGameobjects(FrameInfo& frameInfo, CullPhase phase)
+	{
+		assert(gpuCulling != nullptr && "GPU culling is not supported on this device");
+
+		if (phase == CullPhase::Early)
+		{
+			drawStats = {};
+			// Not between the phases, the late phase has to draw like the early one
+			updatePipelines();
+		}
+
+		uint32_t phaseIndex = static_cast<uint32_t>(phase);
+		RecordState state{};
+		beginBatches(frameInfo, objectDescriptorSets[frameInfo.frameIndex], state);
+
+		writePassMarker(frameInfo.commandBuffer, frameInfo.frameIndex, PassMarker::Begin, phaseIndex);
+		for (uint32_t pass = isDepthPrepassActive() ? 0 : 1; pass < 2; pass++)
+		{
+			bool depthOnly = pass == 0;
+			if (!depthOnly)
+			{
+				writePassMarker(frameInfo.commandBuffer, frameInfo.frameIndex, PassMarker::Main, phaseIndex);
+			}
+
+			for (uint32_t i = 0; i < sceneBatches.size(); i++)
+			{
+				auto& batch = sceneBatches[i];
+				if ((depthOnly || getPipeline(PipelineKind::Transparent) == nullptr) && batch.transparent) continue;
+
+				bindBatch(frameInfo, batch, depthOnly, state);
+				gpuCulling->drawBatch(frameInfo.commandBuffer, frameInfo.frameIndex, phase, i, batch.firstCommand, batch.commandCount);
+			}
+		}
+		writePassMarker(frameInfo.commandBuffer, frameInfo.frameIndex, PassMarker::End, phaseIndex);
+
+		drawStats += state.stats;
+	}
+
+	void SimpleRenderSystem::setDepthPrepass(bool enabled)
+	{
+		depthPrepass = enabled;
+
+		// Cached static command buffers were recorded for the other mode
+		staticVersion++;
+	}
+
+	void SimpleRenderSystem::setProfiler(LveGpuProfiler* gpuProfiler)
+	{
+		profiler = gpuProfiler;
+		if (profiler != nullptr)
+		{
+			prepassSections[0] = profiler->addSection("Depth pre-pass");
+			mainSections[0] = profiler->addSection("Main pass");
+			prepassSections[1] = profiler->addSection("Late depth pre-pass");
+			mainSections[1] = profiler->addSection("Late main pass");
+		}
+
+		// Cached static command buffers write the timestamps as well
+		staticVersion++;
+	}
+
+	void SimpleRenderSystem::setOcclusionCulling(bool enabled)
+	{
+		assert(gpuCulling != nullptr && "Occlusion culling requires GPU culling");
+
+		gpuCulling->setOcclusionCulling(enabled);
+	}
 
+	void SimpleRenderSystem::setDepthPyramid(FrameInfo& frameInfo, VkExtent2D depthExtent, VkImage image, VkImageView view)
+	{
+		assert(gpuCulling != nullptr && "Occlusion culling requires GPU culling");
+
+		gpuCulling->setDepthPyramid(frameInfo, depthExtent, image, view);
+	}
+
+	void SimpleRenderSystem::buildDepthPyramid(FrameInfo& frameInfo, VkImageView depthView)
+	{
+		assert(gpuCulling != nullptr && "Occlusion culling requires GPU culling");
+
+		gpuCulling->buildDepthPyramid(frameInfo, depthView);
+	}
+
+	void SimpleRenderSystem::validateScene(const std::vector<LveGameObject>& gameObjects)
+	{
+		uint32_t drawableCount = 0;
 		for (auto& obj : gameObjects)
 		{
-			SimplePushConstantData push{};
-			push.modelMatrix = obj.transform.mat4();
-			push.normalMatrix = obj.transform.normalMatrix();
+			if (obj.model == nullptr) continue;
+
+			// Every draw is a VkDrawIndexedIndirectCommand, the GPU cull writes index counts too
+			if (!obj.model->hasIndices())
+			{
+				throw std::runtime_error("Game object " + std::to_string(obj.getId()) + " has a model without indices, the indirect draw path needs indexed models");
+			}
+			drawableCount++;
+		}
+		if (drawableCount > MAX_OBJECTS)
+		{
+			throw std::runtime_error("Scene has " + std::to_string(drawableCount) + " drawable objects, the indirect draw buffers hold " + std::to_string(MAX_OBJECTS));
+		}
+	}
+
+	void SimpleRenderSystem::buildDrawItems(std::vector<LveGameObject>& gameObjects, const std::vector<uint32_t>& objectIndices, const glm::mat4* projectionView, std::vector<SortItem>& outItems)
+	{
+		constexpr uint64_t DEPTH_MASK = (1ull << 24) - 1;
+		constexpr uint64_t MODEL_MASK = 0xFFFF;
+		// Every draw shares the global and object descriptor sets, there are no materials yet
+		constexpr uint64_t material = 0;
+
+		outItems.clear();
+		for (uint32_t objectIndex : objectIndices)
+		{
+			auto& obj = gameObjects[objectIndex];
+			if (obj.model == nullptr) continue;
+
+			uint64_t depth = 0;
+			if (projectionView != nullptr)
+			{
+				glm::vec4 clip = *projectionView * glm::vec4(obj.transform.translation, 1.0f);
+				float normalizedDepth = clip.w > 0.0f ? glm::clamp(clip.z / clip.w, 0.0f, 1.0f) : 0.0f;
+				depth = static_cast<uint64_t>(normalizedDepth * DEPTH_MASK);
+			}
+
+			uint64_t pipelineId = obj.transparent ? 1 : 0;
+			uint64_t modelId = obj.model->getId() & MODEL_MASK;
 
-			vkCmdPushConstants(frameInfo.commandBuffer, pipelineLayout, VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(SimplePushConstantData), &push);
+			uint64_t key;
+			if (obj.transparent)
+			{
+				// Back to front first, blending order matters more than state changes
+				key = (pipelineId << 56) | ((DEPTH_MASK - depth) << 32) | (material << 16) | modelId;
+			}
+			else
+			{
+				// Front to back within a model for early-Z rejection
+				key = (pipelineId << 56) | (material << 40) | (modelId << 24) | depth;
+			}
+
+			outItems.push_back({ key, objectIndex });
+		}
+		// Objects added since the scene was validated would be written past the end of the mapped buffers
+		if (outItems.size() > MAX_OBJECTS)
+		{
+			throw std::runtime_error("Too many objects for the indirect draw buffers: " + std::to_string(outItems.size()));
+		}
+	}
+
+	void SimpleRenderSystem::buildBatches(std::vector<LveGameObject>& gameObjects, const std::vector<SortItem>& drawItems, std::vector<DrawBatch>& outBatches)
+	{
+		// Sorted draws that share pipeline and model are bound once and drawn with a single indirect call
+		outBatches.clear();
+		for (uint32_t slot = 0; slot < drawItems.size(); slot++)
+		{
+			auto& obj = gameObjects[drawItems[slot].value];
+			if (outBatches.empty() || outBatches.back().model != obj.model.get() || outBatches.back().transparent != obj.transparent)
+			{
+				if (!obj.model->hasIndices())
+				{
+					throw std::runtime_error("Indirect draw path requires an indexed model");
+				}
+				outBatches.push_back({ obj.model.get(), obj.transparent, slot, 0 });
+			}
+			outBatches.back().commandCount++;
+		}
+	}
+
+	void SimpleRenderSystem::writeObjects(std::vector<LveGameObject>& gameObjects, const std::vector<SortItem>& drawItems, const std::vector<DrawBatch>& drawBatches, ObjectData* objects, VkDrawIndexedIndirectCommand* commands)
+	{
+		for (uint32_t batchIndex = 0; batchIndex < drawBatches.size(); batchIndex++)
+		{
+			auto& batch = drawBatches[batchIndex];
+			for (uint32_t slot = batch.firstCommand; slot < batch.firstCommand + batch.commandCount; slot++)
+			{
+				auto& obj = gameObjects[drawItems[slot].value];
+
+				auto& objectData = objects[slot];
+				objectData.modelMatrix = obj.transform.mat4();
+				objectData.normalMatrix = obj.transform.normalMatrix();
+				objectData.boundingSphere = glm::vec4{ obj.model->getBoundsCenter(), obj.model->getBoundsRadius() };
+				objectData.batchIndex = batchIndex;
+				objectData.firstCommand = batch.firstCommand;
+				objectData.indexCount = obj.model->getIndexCount();
+				objectData.textureIndex = obj.textureIndex;
+
+				if (commands != nullptr)
+				{
+					// firstInstance doubles as the index into the object buffer (gl_InstanceIndex in the shader)
+					commands[slot].indexCount = obj.model->getIndexCount();
+					commands[slot].instanceCount = 1;
+					commands[slot].firstIndex = 0;
+					commands[slot].vertexOffset = 0;
+					commands[slot].firstInstance = slot;
+				}
+			}
+		}
+	}
+
+	void SimpleRenderSystem::beginBatches(FrameInfo& frameInfo, VkDescriptorSet objectSet, RecordState& state)
+	{
+		// All pipelines share the layout, so the sets stay bound across pipeline switches. Textures are
+		// indexed through the bindless set, so this is the only descriptor bind of a command buffer.
+		std::array<VkDescriptorSet, 3> descriptorSets{ frameInfo.globalDescriptorSet, objectSet, bindless.getDescriptorSet() };
+		vkCmdBindDescriptorSets(frameInfo.commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, 0, static_cast<uint32_t>(descriptorSets.size()), descriptorSets.data(), 0, nullptr);
+		state.stats.descriptorBinds++;
 
-			obj.model->bind(frameInfo.commandBuffer);
-			obj.model->draw(frameInfo.commandBuffer);
+		state.boundPipeline = nullptr;
+		state.boundModel = nullptr;
+	}
+
+	void SimpleRenderSystem::bindBatch(FrameInfo& frameInfo, const DrawBatch& batch, bool depthOnly, RecordState& state)
+	{
+		Pipeline* batchPipeline;
+		if (depthOnly)
+		{
+			batchPipeline = getPipeline(PipelineKind::DepthPrepass);
+		}
+		else if (batch.transparent)
+		{
+			batchPipeline = getPipeline(PipelineKind::Transparent);
+		}
+		else
+		{
+			batchPipeline = getPipeline(isDepthPrepassActive() ? PipelineKind::DepthEqual : PipelineKind::Opaque);
+		}
+
+		if (batchPipeline != state.boundPipeline)
+		{
+			batchPipeline->bind(frameInfo.commandBuffer);
+			state.boundPipeline = batchPipeline;
+			state.stats.pipelineBinds++;
+		}
+
+		if (batch.model != state.boundModel)
+		{
+			batch.model->bind(frameInfo.commandBuffer);
+			state.boundModel = batch.model;
+			state.stats.modelBinds++;
+		}
+
+		state.stats.batchCount++;
+	}
+
+	void SimpleRenderSystem::drawBatch(FrameInfo& frameInfo, const DrawBatch& batch, VkBuffer indirectBuffer)
+	{
+		constexpr uint32_t stride = sizeof(VkDrawIndexedIndirectCommand);
+
+		if (!lveDevice.features.drawIndirectFirstInstance)
+		{
+			// firstInstance must be 0 in indirect commands, fall back to direct draws
+			for (uint32_t i = 0; i < batch.commandCount; i++)
+			{
+				vkCmdDrawIndexed(frameInfo.commandBuffer, batch.model->getIndexCount(), 1, 0, 0, batch.firstCommand + i);
+			}
+			return;
+		}
+
+		uint32_t maxDrawCount = lveDevice.features.multiDrawIndirect ? lveDevice.properties.limits.maxDrawIndirectCount : 1;
+		for (uint32_t first = 0; first < batch.commandCount; first += maxDrawCount)
+		{
+			uint32_t drawCount = std::min(maxDrawCount, batch.commandCount - first);
+			VkDeviceSize offset = static_cast<VkDeviceSize>(batch.firstCommand + first) * stride;
+			vkCmdDrawIndexedIndirect(frameInfo.commandBuffer, indirectBuffer, offset, drawCount, stride);
+		}
+	}
+
+	void SimpleRenderSystem::recordBatches(FrameInfo& frameInfo, const std::vector<DrawBatch>& drawBatches, VkBuffer indirectBuffer, bool depthOnly, RecordState& state)
+	{
+		for (auto& batch : drawBatches)
+		{
+			// Transparent surfaces must not occlude what is behind them, and are left out until their pipeline is compiled
+			if ((depthOnly || getPipeline(PipelineKind::Transparent) == nullptr) && batch.transparent) continue;
+
+			bindBatch(frameInfo, batch, depthOnly, state);
+			drawBatch(frameInfo, batch, indirectBuffer);
+		}
+	}
+
+	void SimpleRenderSystem::writePassMarker(VkCommandBuffer commandBuffer, int frameIndex, PassMarker marker, uint32_t phase)
+	{
+		if (profiler == nullptr)
+		{
+			return;
+		}
+
+		switch (marker)
+		{
+		case PassMarker::Begin:
+			if (isDepthPrepassActive())
+			{
+				profiler->writeBegin(commandBuffer, frameIndex, prepassSections[phase]);
+			}
+			break;
+		case PassMarker::Main:
+			if (isDepthPrepassActive())
+			{
+				profiler->writeEnd(commandBuffer, frameIndex, prepassSections[phase]);
+			}
+			profiler->writeBegin(commandBuffer, frameIndex, mainSections[phase]);
+			break;
+		case PassMarker::End:
+			profiler->writeEnd(commandBuffer, frameIndex, mainSections[phase]);
+			break;
 		}
 	}
-}
\ No newline at end of file
+}
@@ -4,32 +4,270 @@
 #include "LveDevice.h"
 #include "LveGameObject.h"
 #include "LveCamera.h"
+#include "LveDescriptor.h"
+#include "Lve_Buffer.h"
 #include "Lve_Frame_Info.h"
+#include "GpuCullingSystem.h"
+#include "LveFrustumCuller.h"
+#include "LveUtils.h"
+#include "LveRenderer.h"
+#include "LveThreadPool.h"
+#include "LveGpuProfiler.h"
+#include "LveBindlessRegistry.h"
+#include "LvePipelineCompiler.h"
 
 // Std
+#include <array>
 #include <memory>
+#include <string>
+#include <unordered_map>
 #include <vector>
 
 namespace lve {
 	class SimpleRenderSystem
 	{
 	public:
-		SimpleRenderSystem(LveDevice& device, VkRenderPass renderPass, VkDescriptorSetLayout globalSetLayout);
+		static constexpr uint32_t MAX_OBJECTS = 10000;
+		static constexpr float TRANSPARENT_ALPHA = 0.5f;
+		// Parallel recording never hands a worker fewer draws than this, smaller chunks cost more than they save
+		static constexpr uint32_t MIN_COMMANDS_PER_CHUNK = 64;
+		// Directional lights in GlobalUBO, MAX_LIGHTS in simple_shader.vert
+		static constexpr uint32_t MAX_LIGHTS = 4;
+
+		// Baked into simple_shader.vert and .frag as specialization constants, so the driver drops the branches
+		// that are off. Every distinct value set gets its own pipelines.
+		struct ShaderFeatures {
+			uint32_t lightCount = 1;  // up to MAX_LIGHTS
+			float ambient = 0.02f;
+			bool textured = true;
+		};
+
+		// State changes recorded by the last frame, pipeline + descriptor + vertex/index buffer binds
+		struct DrawStats {
+			uint32_t batchCount = 0;
+			uint32_t pipelineBinds = 0;
+			uint32_t descriptorBinds = 0;
+			uint32_t modelBinds = 0;
+
+			uint32_t stateChanges() const { return pipelineBinds + descriptorBinds + modelBinds; }
+
+			DrawStats& operator+=(const DrawStats& other)
+			{
+				batchCount += other.batchCount;
+				pipelineBinds += other.pipelineBinds;
+				descriptorBinds += other.descriptorBinds;
+				modelBinds += other.modelBinds;
+				return *this;
+			}
+		};
+
+		// Sets: 0 global, 1 objects, 2 bindless resources.
+		// Only the opaque pipeline of the default ShaderFeatures is created up front, the others come from compiler.
+		// Until they are ready (fast-linked, when the device supports pipeline libraries) transparent batches are
+		// skipped and the depth pre-pass stays off.
+		// globalSetLayout is bound as set 0 and has to back what the shaders read from it
+		SimpleRenderSystem(LveDevice& device, VkRenderPass renderPass, const LveDescriptorSetLayout& globalSetLayout, LveBindlessRegistry& bindlessRegistry, LvePipelineCompiler& compiler);
 		~SimpleRenderSystem();
 
 		SimpleRenderSystem(const SimpleRenderSystem&) = delete;
 		SimpleRenderSystem& operator=(const SimpleRenderSystem&) = delete;
 
+		// CPU driven path, objects are frustum culled on the CPU and draw commands are written every frame
 		void renderGameobjects(FrameInfo& frameInfo, std::vector<LveGameObject>& gameObjects);
+		// Same as renderGameobjects, but the draws are split into chunks that are recorded into secondary command buffers
+		// on the thread pool. The render pass must have been begun with VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS.
+		void renderGameobjectsParallel(FrameInfo& frameInfo, std::vector<LveGameObject>& gameObjects, LveRenderer& renderer, LveThreadPool& threadPool);
+
+		// Opaque objects marked isStatic are drawn from command buffers recorded once per frame in flight and only
+		// re-recorded when the static set, the pipelines or the swap chain change. Culling still applies every frame
+		// through the instance count of their indirect commands. Only used by renderGameobjectsParallel.
+		// Waits for the device, call on scene load rather than per frame.
+		void setStaticScene(std::vector<LveGameObject>& gameObjects);
+		// Without drawIndirectFirstInstance batches are recorded as direct draws of one instance, so culled static
+		// objects would still be drawn from the cached command buffers
+		bool isStaticSceneSupported() const { return lveDevice.features.drawIndirectFirstInstance; }
+		bool hasStaticScene() const { return !staticItems.empty(); }
+		// Recomputes the world space bounds used by the CPU cull, call after objects have moved. setScene, setStaticScene
+		// and updateBounds throw std::runtime_error for scenes the indirect draw buffers can't hold, see validateScene.
+		void updateBounds(std::vector<LveGameObject>& gameObjects);
+		uint32_t getVisibleObjectCount() const { return static_cast<uint32_t>(visibleIndices.size()); }
+		const DrawStats& getDrawStats() const { return drawStats; }
+
+		// Opaque geometry is drawn depth only first, the shaded pass then tests depth with EQUAL and runs the
+		// fragment shader once per pixel. Pays off in scenes with a lot of overdraw, applies to every render path.
+		void setDepthPrepass(bool enabled);
+		bool isDepthPrepassEnabled() const { return depthPrepass; }
+		// Enabled and its pipelines have finished compiling
+		bool isDepthPrepassActive() const { return depthPrepass && getPipeline(PipelineKind::DepthPrepass) != nullptr && getPipeline(PipelineKind::DepthEqual) != nullptr; }
+
+		// Pipelines for features are compiled in the background the first time they are asked for, drawing continues
+		// with the current ones until the new opaque pipeline is ready. Switching back to earlier features is free.
+		// renderPass is the current swap chain render pass.
+		void setShaderFeatures(const ShaderFeatures& features, VkRenderPass renderPass);
+		const ShaderFeatures& getShaderFeatures() const { return shaderFeatures; }
+		// Rebuilds the pipelines from the SPIR-V on disk after a shader changed, in the background like
+		// setShaderFeatures. Shaders whose descriptor sets, push constants or vertex inputs changed are rejected and
+		// drawing continues with the previous pipelines, as it does for a pipeline the driver fails to compile.
+		void reloadShaders(VkRenderPass renderPass);
+		// Adds the pre-pass and main pass sections (early and late phase) to the profiler, timed by every render path
+		void setProfiler(LveGpuProfiler* gpuProfiler);
+
+		// GPU driven path, the scene is uploaded once and culled into indirect commands every frame
+		bool isGpuCullingSupported() const { return gpuCulling != nullptr; }
+		void setScene(std::vector<LveGameObject>& gameObjects);
+		void cullGameobjects(FrameInfo& frameInfo, CullPhase phase = CullPhase::Early);
+		void renderCulledGameobjects(FrameInfo& frameInfo, CullPhase phase = CullPhase::Early);
+
+		// Occlusion culling splits the frame: early cull, early draw, depth pyramid, late cull, late draw
+		void setOcclusionCulling(bool enabled);
+		bool isOcclusionCullingEnabled() const { return gpuCulling != nullptr && gpuCulling->isOcclusionCullingEnabled(); }
+		// Every frame on the GPU driven path once the render graph is compiled, see GpuCullingSystem::setDepthPyramid
+		void setDepthPyramid(FrameInfo& frameInfo, VkExtent2D depthExtent, VkImage image, VkImageView view);
+		// Expects the depth image in shader read layout
+		void buildDepthPyramid(FrameInfo& frameInfo, VkImageView depthView);
 
 	private:
-		void createPipelineLayout(VkDescriptorSetLayout globalSetLayout);
-		void createPipeline(VkRenderPass renderPass);
+		// Consecutive indirect commands that share the same pipeline and model (and therefore the same vertex/index buffers)
+		struct DrawBatch {
+			LveModel* model;
+			bool transparent;
+			uint32_t firstCommand;
+			uint32_t commandCount;
+		};
+
+		// Bind state of one command buffer, every secondary command buffer starts from scratch
+		struct RecordState {
+			Pipeline* boundPipeline = nullptr;
+			LveModel* boundModel = nullptr;
+			DrawStats stats;
+		};
+
+		// Descriptor bindings and push constants of every shader the system uses
+		LveShaderReflection reflectShaders();
+		void createObjectResources(const LveShaderReflection& reflection);
+		// The cached pipeline layout for the shaders, throws std::runtime_error when setLayouts cannot back them
+		VkPipelineLayout getPipelineLayout(const LveShaderReflection& reflection) const;
+		enum class PipelineKind : uint32_t {
+			Opaque,
+			Transparent,
+			DepthPrepass,
+			DepthEqual,
+			Count,
+		};
+
+		// Pipelines of one ShaderFeatures value, null until compiled
+		struct PipelineSet {
+			std::array<std::shared_ptr<Pipeline>, static_cast<size_t>(PipelineKind::Count)> pipelines;
+			std::array<LvePipelineCompiler::PipelineFuture, static_cast<size_t>(PipelineKind::Count)> futures;
+		};
+
+		// Fast-links what it can and queues the optimized compiles. With waitForOpaque the opaque pipeline is usable on return.
+		std::unique_ptr<PipelineSet> createPipelineSet(const ShaderFeatures& features, VkRenderPass renderPass, bool waitForOpaque);
+		void createPipelineConfig(PipelineKind kind, const ShaderFeatures& features, VkRenderPass renderPass, PipelineConfigInfo& configInfo);
+		static std::string getFeaturesKey(const ShaderFeatures& features);
+		// Picks up background compiles that have finished, called by the render paths before recording
+		void updatePipelines();
+		Pipeline* getPipeline(PipelineKind kind) const { return activePipelines->pipelines[static_cast<size_t>(kind)].get(); }
+
+		// Throws std::runtime_error for scenes the fixed size object and indirect buffers can't draw: more than
+		// MAX_OBJECTS drawable objects or a model without indices
+		static void validateScene(const std::vector<LveGameObject>& gameObjects);
+		// Sort key, most significant first: pipeline, material, model, depth (depth before material and model for transparent draws).
+		// Without a projectionView the depth bits stay zero.
+		void buildDrawItems(std::vector<LveGameObject>& gameObjects, const std::vector<uint32_t>& objectIndices, const glm::mat4* projectionView, std::vector<SortItem>& outItems);
+		void buildBatches(std::vector<LveGameObject>& gameObjects, const std::vector<SortItem>& drawItems, std::vector<DrawBatch>& outBatches);
+		void writeObjects(std::vector<LveGameObject>& gameObjects, const std::vector<SortItem>& drawItems, const std::vector<DrawBatch>& drawBatches, ObjectData* objects, VkDrawIndexedIndirectCommand* commands);
+
+		// Profiler timestamps around the passes. Begin opens the pre-pass, Main closes it and opens the main pass,
+		// End closes the main pass. Without the pre-pass Begin writes nothing.
+		enum class PassMarker {
+			Begin,
+			Main,
+			End,
+		};
+
+		// Bookkeeping for one cached static command buffer
+		struct StaticRecording {
+			VkCommandBuffer prepassCommandBuffer = VK_NULL_HANDLE;
+			VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+			uint64_t staticVersion = 0;
+			uint64_t swapChainGeneration = 0;
+			DrawStats stats;
+		};
+
+		// Culls, sorts and batches the visible objects and writes this frame's object and indirect buffers.
+		// With excludeStatic the static objects are left to the cached static command buffers.
+		void prepareGameobjects(FrameInfo& frameInfo, std::vector<LveGameObject>& gameObjects, bool excludeStatic);
+		void writeStaticVisibility(int frameIndex);
+		// Returns the cached static command buffers of this frame, re-recorded if they went stale
+		StaticRecording& getStaticRecording(FrameInfo& frameInfo, LveRenderer& renderer);
+		void beginStaticCommandBuffer(VkCommandBuffer commandBuffer, LveRenderer& renderer);
+		// Splits the batches into at most chunkCount runs of roughly equal command count, cutting batches where needed
+		void splitBatches(uint32_t chunkCount);
+
+		void beginBatches(FrameInfo& frameInfo, VkDescriptorSet objectSet, RecordState& state);
+		// depthOnly binds the pre-pass pipeline, otherwise the shading pipeline matching the batch and the pre-pass mode
+		void bindBatch(FrameInfo& frameInfo, const DrawBatch& batch, bool depthOnly, RecordState& state);
+		void drawBatch(FrameInfo& frameInfo, const DrawBatch& batch, VkBuffer indirectBuffer);
+		// Binds and draws the batches, the depth only pass skips transparent batches
+		void recordBatches(FrameInfo& frameInfo, const std::vector<DrawBatch>& drawBatches, VkBuffer indirectBuffer, bool depthOnly, RecordState& state);
+		void writePassMarker(VkCommandBuffer commandBuffer, int frameIndex, PassMarker marker, uint32_t phase = 0);
 
 		LveDevice& lveDevice;
+		LveBindlessRegistry& bindless;
+
+		LvePipelineCompiler& pipelineCompiler;
+		ShaderFeatures shaderFeatures;
+		// By getFeaturesKey, fast-linked pipelines are replaced by the optimized ones as they arrive
+		std::unordered_map<std::string, std::unique_ptr<PipelineSet>> pipelineSets;
+		PipelineSet* activePipelines = nullptr;
+		PipelineSet* pendingPipelines = nullptr;  // becomes active once its opaque pipeline is ready
+		std::unique_ptr<PipelineSet> reloadedPipelines;  // the active set from before reloadShaders, drawn with until then
+		bool depthPrepass = false;
+		VkPipelineLayout pipelineLayout;  // owned by the layout cache
+
+		LveDescriptorSetLayout* objectSetLayout = nullptr;  // owned by the layout cache
+		std::array<const LveDescriptorSetLayout*, 3> setLayouts{};  // global, object and bindless set
+		std::unique_ptr<LveDescriptorPool> objectPool;
+		std::vector<VkDescriptorSet> objectDescriptorSets;
+		std::vector<std::unique_ptr<Lve_Buffer>> objectBuffers;
+		std::vector<std::unique_ptr<Lve_Buffer>> indirectBuffers;
 
-		std::unique_ptr<Pipeline> pipeline;
-		VkPipelineLayout pipelineLayout;
+		std::vector<DrawBatch> batches;
+		std::vector<SortItem> drawItems;
+		std::vector<SortItem> sortScratch;
+
+		DrawStats drawStats;
+
+		LveGpuProfiler* profiler = nullptr;
+		std::array<uint32_t, 2> prepassSections{};  // indexed by CullPhase, the CPU paths use the early one
+		std::array<uint32_t, 2> mainSections{};
+
+		std::vector<std::vector<DrawBatch>> chunkBatches;
+		std::vector<RecordState> chunkStates;
+		std::vector<VkCommandBuffer> chunkCommandBuffers;
+
+		LveFrustumCuller frustumCuller;
+		std::vector<uint32_t> visibleIndices;
+
+		std::unique_ptr<GpuCullingSystem> gpuCulling;
+		std::vector<DrawBatch> sceneBatches;
+		std::vector<uint32_t> sceneIndices;
+		std::vector<SortItem> sceneItems;
+		std::vector<ObjectData> sceneObjects;
+		uint64_t sceneVersion = 0;
+		std::vector<uint64_t> uploadedSceneVersions;
+
+		// Static objects have their own object buffer, written once, and per-frame indirect buffers for the culling
+		std::vector<SortItem> staticItems;
+		std::vector<DrawBatch> staticBatches;
+		std::vector<uint32_t> staticSlots;  // object index -> static command slot, UINT32_MAX for dynamic objects
+		std::unique_ptr<Lve_Buffer> staticObjectBuffer;
+		std::vector<std::unique_ptr<Lve_Buffer>> staticIndirectBuffers;
+		VkDescriptorSet staticDescriptorSet;
+		VkCommandPool staticCommandPool = VK_NULL_HANDLE;
+		std::vector<StaticRecording> staticRecordings;
+		// Bumped by setStaticScene and pipeline creation, starts at 1 so nothing counts as recorded yet
+		uint64_t staticVersion = 1;
 	};
 }
-
@@ -1,15 +1,106 @@
 #include "FirstApp.h"
+#include "LveFrustumCuller.h"
 
 #include <iostream>
 #include <stdexcept>
+#include <string>
 #include <cstdlib>
+#include <cstring>
 
-int main() {
-    lve::FirstApp app{};
+static int runCullBenchmark() {
+	constexpr uint32_t iterations = 200;
 
-	try
+	std::cout << "CPU frustum cull benchmark, kernel: " << lve::LveFrustumCuller::kernelName() << '\n';
+	for (uint32_t objectCount : { 1000u, 10000u, 100000u, 1000000u })
+	{
+		auto result = lve::LveFrustumCuller::runBenchmark(objectCount, iterations);
+		std::cout << "  " << result.objectCount << " objects, " << result.visibleCount << " visible: "
+			<< result.microsecondsPerCull << " us/cull, "
+			<< result.culledPerMicrosecond << " objects culled/us, "
+			<< result.testedPerMicrosecond << " objects tested/us" << '\n';
+	}
+
+	return EXIT_SUCCESS;
+}
+
+// Renders the scripted run headless and writes <outputPrefix>.csv and <outputPrefix>.json. Fails when the
+// CPU or GPU p95 exceeds maxP95Milliseconds, so it can gate changes; 0 only reports.
+static int runBenchmark(const std::string& benchmarkPath, const std::string& outputPrefix, float maxP95Milliseconds) {
+	auto benchmark = lve::LveBenchmark::loadFromFile(benchmarkPath);
+	std::string deviceName;
 	{
+		lve::FirstApp app{ true, &benchmark };
 		app.run();
+		deviceName = app.getDeviceName();
+	}
+
+	benchmark.writeCsv(outputPrefix + ".csv");
+	benchmark.writeJson(outputPrefix + ".json", deviceName);
+	benchmark.printSummary();
+	std::cout << "Benchmark results written to " << outputPrefix << ".csv and " << outputPrefix << ".json" << '\n';
+
+	if (maxP95Milliseconds > 0.0f)
+	{
+		float cpuP95 = benchmark.getCpuSummary().p95;
+		float gpuP95 = benchmark.getGpuSummary().p95;
+		if (cpuP95 > maxP95Milliseconds || gpuP95 > maxP95Milliseconds)
+		{
+			std::cerr << "Benchmark over budget: CPU p95 " << cpuP95 << " ms, GPU p95 " << gpuP95 << " ms, allowed " << maxP95Milliseconds << " ms" << '\n';
+			return EXIT_FAILURE;
+		}
+	}
+	return EXIT_SUCCESS;
+}
+
+int main(int argc, char* argv[]) {
+	bool headless = false;
+	uint64_t frameCount = 0;
+	std::string benchmarkPath;
+	std::string benchmarkOutput = "benchmark";
+	float maxP95Milliseconds = 0.0f;
+	for (int i = 1; i < argc; i++)
+	{
+		if (std::strcmp(argv[i], "--cull-benchmark") == 0)
+		{
+			return runCullBenchmark();
+		}
+		// No window, surface or present queue, e.g. for CI on a software driver
+		if (std::strcmp(argv[i], "--headless") == 0)
+		{
+			headless = true;
+		}
+		if (std::strcmp(argv[i], "--frames") == 0 && i + 1 < argc)
+		{
+			frameCount = std::strtoull(argv[++i], nullptr, 10);
+		}
+		// Scene, camera path and frame count from a file such as Benchmarks/orbit.bench, always headless
+		if (std::strcmp(argv[i], "--benchmark") == 0 && i + 1 < argc)
+		{
+			benchmarkPath = argv[++i];
+		}
+		if (std::strcmp(argv[i], "--benchmark-out") == 0 && i + 1 < argc)
+		{
+			benchmarkOutput = argv[++i];
+		}
+		if (std::strcmp(argv[i], "--max-p95") == 0 && i + 1 < argc)
+		{
+			maxP95Milliseconds = std::strtof(argv[++i], nullptr);
+		}
+	}
+	if (headless && frameCount == 0)
+	{
+		frameCount = 600;
+	}
+
+	try
+	{
+		if (!benchmarkPath.empty())
+		{
+			return runBenchmark(benchmarkPath, benchmarkOutput, maxP95Milliseconds);
+		}
+
+		lve::FirstApp app{ headless };
+		app.run(frameCount);
 	}
 	catch (const std::exception& e)
 	{
@@ -18,4 +109,4 @@ int main() {
 	}
 
     return EXIT_SUCCESS;
-}
\ No newline at end of file
+}